@@ -0,0 +1,409 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : api.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : The charts_list library functions (see charts_list_api.h).
+ *               They are built from the same code as the charts_list command
+ *               (every file but main.c), so records, water levels, and audits
+ *               come out exactly as charts_list would list them.
+ *
+ *               Records can be read three ways:
+ *
+ *                 cl_read_records     whole HYDRO_OUTPUT_T or TOPO_OUTPUT_T
+ *                                     structures into the caller's buffer
+ *                 cl_view_records     a pointer to the records in the file
+ *                                     mapping, no copy at all (NULL if the
+ *                                     file isn't mapped, see record_reader.c)
+ *                 cl_read_columns     the fields picked with cl_select (by
+ *                                     the --fields names), one array per
+ *                                     field, in batches of whatever size the
+ *                                     caller's arrays hold
+ *
+ *               The caller owns every buffer and can reuse them from batch to
+ *               batch.  Errors are reported on stderr, like charts_list.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+struct CL_FILE
+{
+  int32_t            type;                       /*  CL_HOF or CL_TOF  */
+  FILE               *fp;
+  RECORD_READER      reader;
+  FIELD_SET          fields;                     /*  cl_select columns  */
+  int32_t            next;                       /*  next record for cl_read_columns (1 based)  */
+  uint8_t            *batch;                     /*  records for cl_read_columns when the file isn't mapped  */
+  int32_t            batch_size;
+};
+
+
+
+/*  The charts_list defaults with no options given, without the per file messages.  */
+
+static void api_options (OPTIONS *options)
+{
+  memset (options, 0, sizeof (OPTIONS));
+
+  options->rec_num = -1;
+  record_list_init (&options->records);
+  options->list_null = NVTrue;
+  options->average = NVTrue;
+  options->workers = 1;
+  filter_init (&options->filter);
+  options->srtm_cache_mb = SRTM_CACHE_DEFAULT_MB;
+  options->wl_num_windows = 1;
+  options->wl_width[0] = 2000000;
+  options->grid.returns = GRID_FIRST_RETURN | GRID_LAST_RETURN;
+  options->prefetch_mb = PREFETCH_DEFAULT_MB;
+  options->stats = STATS_OFF;
+  options->quiet = NVTrue;
+}
+
+
+
+static void api_options_free (OPTIONS *options)
+{
+  filter_free (&options->filter);
+  record_list_free (&options->records);
+}
+
+
+
+/*  Open a .hof or .tof file.  use_library reads the records through the CHARTS library instead of
+    mapping the file (-L).  Returns NULL on error.  */
+
+CL_FILE *cl_open (char *file, int32_t use_library)
+{
+  CL_FILE            *cf;
+  HOF_HEADER_T       hof_header;
+  int32_t            type, num_records = -1;
+  FILE               *fp;
+
+
+  if (strstr (file, ".hof"))
+    {
+      type = CL_HOF;
+      fp = open_hof_file (file);
+    }
+  else if (strstr (file, ".tof"))
+    {
+      type = CL_TOF;
+      fp = open_tof_file (file);
+    }
+  else
+    {
+      fprintf (stderr, "\nUnknown file extension %s\n", file);
+      return (NULL);
+    }
+
+  if (fp == NULL)
+    {
+      perror (file);
+      return (NULL);
+    }
+
+  if ((cf = (CL_FILE *) calloc (1, sizeof (CL_FILE))) == NULL)
+    {
+      perror ("Allocating file memory");
+      exit (-1);
+    }
+
+  if (type == CL_HOF)
+    {
+      hof_read_header (fp, &hof_header);
+      num_records = hof_header.text.number_shots;
+    }
+
+  cf->type = type;
+  cf->fp = fp;
+  cf->next = 1;
+
+  reader_open (&cf->reader, fp, file, type, num_records, use_library ? NVTrue : NVFalse);
+
+  field_set_parse (&cf->fields, type, NULL);
+
+  return (cf);
+}
+
+
+
+void cl_close (CL_FILE *cf)
+{
+  if (cf == NULL) return;
+
+  reader_close (&cf->reader);
+  fclose (cf->fp);
+  free (cf->batch);
+  free (cf);
+}
+
+
+
+int32_t cl_type (CL_FILE *cf)
+{
+  return (cf->type);
+}
+
+
+
+/*  Number of records, -1 if it isn't known without reading the whole file (a TOF file read
+    through the library).  */
+
+int32_t cl_num_records (CL_FILE *cf)
+{
+  return (cf->reader.num_records);
+}
+
+
+
+/*  Read up to count records starting at record number first (1 based) into records, an array of
+    HYDRO_OUTPUT_T or TOPO_OUTPUT_T.  Returns the number read, 0 at the end of the file.  */
+
+int32_t cl_read_records (CL_FILE *cf, int32_t first, int32_t count, void *records)
+{
+  return (reader_read (&cf->reader, first, count, records));
+}
+
+
+
+/*  Records first (1 based) through first + *count - 1 in place in the file mapping.  *count is
+    cut to the end of the file.  The records stay valid until cl_close.  Returns NULL (and sets
+    *count to 0) if the file isn't mapped or first is past the end.  */
+
+void *cl_view_records (CL_FILE *cf, int32_t first, int32_t *count)
+{
+  RECORD_READER      *reader = &cf->reader;
+
+
+  if (!reader->mapped || first < 1 || first > reader->num_records || *count < 1)
+    {
+      *count = 0;
+      return (NULL);
+    }
+
+  if (first - 1 + *count > reader->num_records) *count = reader->num_records - first + 1;
+
+  return (reader->map + reader->head_size + (int64_t) (first - 1) * reader->record_size);
+}
+
+
+
+/*  Pick the cl_read_columns fields, a comma separated list of --fields names (NULL for the
+    charts_list defaults).  Returns the number of columns or -1 for an unknown name.  */
+
+int32_t cl_select (CL_FILE *cf, char *fields)
+{
+  field_set_parse (&cf->fields, cf->type, fields);
+
+  if (cf->fields.count < 0)
+    {
+      fprintf (stderr, "\nUnknown %s field %s\n\n", cf->type ? "TOF" : "HOF", cf->fields.bad);
+      return (-1);
+    }
+
+  return (cf->fields.count);
+}
+
+
+
+/*  Storage type (CL_INT8 ... CL_DOUBLE) and size in bytes of a cl_select column.  */
+
+int32_t cl_column_type (CL_FILE *cf, int32_t column)
+{
+  if (column < 0 || column >= cf->fields.count) return (-1);
+
+  return (cf->fields.field[column]->type);
+}
+
+
+
+int32_t cl_column_size (CL_FILE *cf, int32_t column)
+{
+  if (column < 0 || column >= cf->fields.count) return (-1);
+
+  return (cf->fields.field[column]->size);
+}
+
+
+
+/*  Set the next record (1 based) for cl_read_columns.  */
+
+int32_t cl_seek (CL_FILE *cf, int32_t record)
+{
+  if (record < 1 || (cf->reader.num_records >= 0 && record > cf->reader.num_records + 1)) return (-1);
+
+  cf->next = record;
+
+  return (0);
+}
+
+
+
+/*  Read the next count records into columns, one array of count values for each cl_select field.
+    Returns the number of records read, 0 at the end of the file.  */
+
+int32_t cl_read_columns (CL_FILE *cf, int32_t count, void **columns)
+{
+  FIELD_DEF          *field;
+  uint8_t            *src, *dst;
+  int32_t            i, j, n = 0;
+
+
+  if (count < 1) return (0);
+
+
+  /*  Straight out of the mapping.  */
+
+  if (cf->reader.mapped)
+    {
+      for (i = 0 ; i < cf->fields.count ; i++)
+        {
+          field = cf->fields.field[i];
+
+          n = reader_gather (&cf->reader, cf->next, count, field->offset, field->size, columns[i]);
+        }
+
+      if (!cf->fields.count) n = 0;
+
+      cf->next += n;
+
+      return (n);
+    }
+
+
+  /*  Through the library, one read per record and then split up.  */
+
+  if (count > cf->batch_size)
+    {
+      if ((cf->batch = (uint8_t *) realloc (cf->batch, (size_t) count * cf->reader.record_size)) == NULL)
+        {
+          perror ("Allocating record memory");
+          exit (-1);
+        }
+
+      cf->batch_size = count;
+    }
+
+  if ((n = reader_read (&cf->reader, cf->next, count, cf->batch)) <= 0) return (0);
+
+  for (i = 0 ; i < cf->fields.count ; i++)
+    {
+      field = cf->fields.field[i];
+      src = cf->batch + field->offset;
+      dst = (uint8_t *) columns[i];
+
+      for (j = 0 ; j < n ; j++, src += cf->reader.record_size, dst += field->size) memcpy (dst, src, field->size);
+    }
+
+  cf->next += n;
+
+  return (n);
+}
+
+
+
+/*  Water levels for a HOF file (-w, -W).  Each sample is passed to func with data.  Returns 0 on
+    success or -1 on error.  */
+
+int32_t cl_water_level (char *file, CL_WATER_LEVEL_OPTIONS *wl_options, CL_WATER_LEVEL_FUNC func, void *data)
+{
+  OPTIONS            options;
+  int32_t            i, status;
+
+
+  if (wl_options->num_windows < 0 || wl_options->num_windows > CL_MAX_WINDOWS) return (-1);
+
+  api_options (&options);
+
+  options.water_level = NVTrue;
+  options.average = wl_options->average ? NVTrue : NVFalse;
+  options.wl_func = func;
+  options.wl_data = data;
+
+
+  /*  --windows  */
+
+  if (wl_options->num_windows)
+    {
+      options.wl_num_windows = wl_options->num_windows;
+      options.wl_stats = NVTrue;
+
+      for (i = 0 ; i < wl_options->num_windows ; i++)
+        {
+          if (wl_options->window_seconds[i] <= 0.0) return (-1);
+
+          options.wl_width[i] = (int64_t) (wl_options->window_seconds[i] * 1000000.0 + 0.5);
+        }
+    }
+
+
+  /*  -g  */
+
+  if (wl_options->geo_check)
+    {
+      options.geo_check = NVTrue;
+      options.geo.y = wl_options->lat;
+      options.geo.x = wl_options->lon;
+      geo_distance_init (&options.geo_ref, options.geo.y, options.geo.x);
+    }
+
+  if (wl_options->srtm_cache_mb > 0) srtm_cache_init (wl_options->srtm_cache_mb);
+
+  status = process_file (&options, file, 1, -1);
+
+  if (wl_options->srtm_cache_mb > 0) srtm_cache_free ();
+
+  api_options_free (&options);
+
+  return (status);
+}
+
+
+
+/*  Tide audit of a HOF file (--audit).  confidence is the --audit=CONFIDENCE value, 0 to check
+    every shot.  Returns 0 on success or -1 on error.  */
+
+int32_t cl_audit (char *file, double confidence, CL_AUDIT_RESULT *result)
+{
+  OPTIONS            options;
+  int32_t            status;
+
+
+  api_options (&options);
+
+  options.audit = NVTrue;
+  options.audit_confidence = confidence;
+
+  status = audit_run (&options, file, result);
+
+  api_options_free (&options);
+
+  return (status);
+}
@@ -0,0 +1,330 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : audit.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --audit, the -t tide correction check with one machine
+ *               readable line per file.
+ *
+ *               Only reported_depth and tide_cor_depth are copied out of the
+ *               records (see reader_gather).  A file is untided when the
+ *               whole percent of checked shots with reported_depth +
+ *               tide_cor_depth == 0 is more than 1, the same test -t has
+ *               always used (so 2% or more).  If the file has a current
+ *               sidecar (--index) its counts are used and nothing is read.
+ *
+ *               With --bbox, --polygon, --time, or --radius the whole records
+ *               are read so they can be filtered, only the shots that pass
+ *               are checked, and the sidecar isn't used.
+ *
+ *               With --audit=CONFIDENCE the shots are sampled without
+ *               replacement, spread over the whole file, and sampling stops
+ *               as soon as the Wilson score interval for the untided
+ *               fraction at that confidence is entirely above or below the
+ *               threshold.  If it never is, every shot ends up checked and
+ *               the answer is exact.  The interval is checked every
+ *               AUDIT_CHECK_EVERY shots, so the stated confidence is a
+ *               little optimistic.
+ *
+ *               Output lines are:
+ *
+ *                 file,status,checked,zero_tide,percent,records_read,method
+ *
+ *               status is tided, untided, no_data, or error.  method is full,
+ *               sample, or index.
+ *
+ ********************************************************************/
+
+#include <stddef.h>
+
+#include "charts_list.h"
+
+
+#define AUDIT_THRESHOLD      0.02
+#define AUDIT_MIN_SAMPLE     1000
+#define AUDIT_CHECK_EVERY    256
+
+
+
+/*  Standard normal quantile (Abramowitz and Stegun 26.2.23, |error| < 4.5e-4).  */
+
+static double normal_quantile (double p)
+{
+  double             q = p < 0.5 ? p : 1.0 - p, t, z;
+
+
+  t = sqrt (-2.0 * log (q));
+  z = t - (2.515517 + 0.802853 * t + 0.010328 * t * t) / (1.0 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+
+  return (p < 0.5 ? -z : z);
+}
+
+
+
+/*  -1 if the untided fraction is clearly below the threshold, 1 if it's clearly above, 0 if we
+    can't tell yet.  */
+
+static int32_t wilson_decision (int32_t checked, int32_t zero_tide, double z)
+{
+  double             n = (double) checked, p = (double) zero_tide / n, z2 = z * z, center, half;
+
+
+  center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+  half = z * sqrt (p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+
+  if (center + half < AUDIT_THRESHOLD) return (-1);
+  if (center - half > AUDIT_THRESHOLD) return (1);
+
+  return (0);
+}
+
+
+
+static int64_t gcd (int64_t a, int64_t b)
+{
+  int64_t            t;
+
+
+  while (b)
+    {
+      t = a % b;
+      a = b;
+      b = t;
+    }
+
+  return (a);
+}
+
+
+
+static void audit_set (CL_AUDIT_RESULT *result, int32_t status, int32_t checked, int32_t zero_tide, int32_t records_read, int32_t method)
+{
+  result->status = status;
+  result->checked = checked;
+  result->zero_tide = zero_tide;
+  result->percent = checked ? (double) zero_tide / (double) checked * 100.0 : 0.0;
+  result->records_read = records_read;
+  result->method = method;
+}
+
+
+
+static void audit_result (CL_AUDIT_RESULT *result, int32_t checked, int32_t zero_tide, int32_t records_read, int32_t method)
+{
+  int32_t            i;
+
+
+  if (!checked)
+    {
+      audit_set (result, CL_AUDIT_NO_DATA, 0, 0, records_read, method);
+      return;
+    }
+
+  i = ((float) zero_tide / (float) checked) * 100.0;
+
+  audit_set (result, i > 1 ? CL_AUDIT_UNTIDED : CL_AUDIT_TIDED, checked, zero_tide, records_read, method);
+}
+
+
+
+/*  Get reported_depth and tide_cor_depth for count records from first.  Without a filter only the
+    two fields are copied out.  With one the whole records are read so they can be filtered, and
+    the records that don't pass are given a null reported depth so they aren't checked.  Returns
+    the number of records, 0 at the end of the file.  */
+
+static int32_t audit_gather (OPTIONS *options, RECORD_READER *reader, HYDRO_OUTPUT_T *records, int32_t first, int32_t count,
+                             float *reported, float *tide)
+{
+  uint8_t            pass[READ_BATCH];
+  int32_t            i;
+
+
+  if (!options->filter.active)
+    {
+      if ((count = reader_gather (reader, first, count, offsetof (HYDRO_OUTPUT_T, reported_depth), sizeof (float), reported)) <= 0)
+        return (0);
+
+      reader_gather (reader, first, count, offsetof (HYDRO_OUTPUT_T, tide_cor_depth), sizeof (float), tide);
+
+      return (count);
+    }
+
+  if ((count = reader_read (reader, first, count, records)) <= 0) return (0);
+
+  filter_batch (&options->filter, 0, records, count, pass);
+
+  for (i = 0 ; i < count ; i++)
+    {
+      reported[i] = pass[i] ? records[i].reported_depth : -998.0;
+      tide[i] = records[i].tide_cor_depth;
+    }
+
+  return (count);
+}
+
+
+
+/*  Audit one file into result.  Returns 0 on success or -1 on error (result->status is
+    CL_AUDIT_ERROR).  */
+
+int32_t audit_run (OPTIONS *options, char *file, CL_AUDIT_RESULT *result)
+{
+  FILE               *fp;
+  HOF_HEADER_T       hof_header;
+  HYDRO_OUTPUT_T     *records = NULL;
+  RECORD_READER      reader;
+  SUMMARY            summary;
+  float              reported[READ_BATCH], tide[READ_BATCH];
+  int32_t            start, count, i, checked = 0, zero_tide = 0, records_read = 0, decision;
+  int64_t            num_records, stride, k;
+  double             z;
+
+
+  if (!strstr (file, ".hof"))
+    {
+      fprintf (stderr, "\nCannot tide check TOF files - Doh!\n\n");
+      audit_set (result, CL_AUDIT_ERROR, 0, 0, 0, CL_AUDIT_FULL);
+      return (-1);
+    }
+
+
+  if (!options->filter.active && !summary_read (file, &summary, NVFalse) && !summary.header.record_type)
+    {
+      audit_result (result, summary.header.tide_total, summary.header.zero_tide_count, 0, CL_AUDIT_INDEX);
+      return (0);
+    }
+
+
+  if ((fp = open_hof_file (file)) == NULL)
+    {
+      perror (file);
+      audit_set (result, CL_AUDIT_ERROR, 0, 0, 0, CL_AUDIT_FULL);
+      return (-1);
+    }
+
+  if (options->filter.active && (records = (HYDRO_OUTPUT_T *) malloc (READ_BATCH * sizeof (HYDRO_OUTPUT_T))) == NULL)
+    {
+      perror ("Allocating record memory");
+      exit (-1);
+    }
+
+  hof_read_header (fp, &hof_header);
+
+  reader_open (&reader, fp, file, 0, hof_header.text.number_shots, options->use_library);
+
+  num_records = reader.num_records;
+
+
+  /*  Sampled.  The walk steps through the records by a stride with no factor in common with the
+      record count, so every record is visited once if it runs to the end.  */
+
+  if (options->audit_confidence > 0.0 && num_records > AUDIT_MIN_SAMPLE)
+    {
+      z = normal_quantile (0.5 + options->audit_confidence / 2.0);
+
+      for (stride = (int64_t) (num_records * 0.6180339887) ; gcd (stride, num_records) != 1 ; stride++);
+
+      reader_advise (&reader, NVTrue);
+
+      for (k = 0 ; k < num_records ; k++)
+        {
+          start = (int32_t) ((k * stride) % num_records) + 1;
+
+          if (!audit_gather (options, &reader, records, start, 1, reported, tide)) break;
+
+          records_read++;
+
+          if (reported[0] != -998.0)
+            {
+              if ((reported[0] + tide[0]) == 0.0) zero_tide++;
+              checked++;
+
+              if (checked >= AUDIT_MIN_SAMPLE && !(checked % AUDIT_CHECK_EVERY) &&
+                  (decision = wilson_decision (checked, zero_tide, z)) != 0) break;
+            }
+        }
+
+      reader_close (&reader);
+      fclose (fp);
+      free (records);
+
+      stats_count (STAT_RECORDS_READ, records_read);
+
+      audit_result (result, checked, zero_tide, records_read, records_read < num_records ? CL_AUDIT_SAMPLE : CL_AUDIT_FULL);
+
+      return (0);
+    }
+
+
+  /*  Full scan.  */
+
+  for (start = 1 ; ; start += count)
+    {
+      if ((count = audit_gather (options, &reader, records, start, READ_BATCH, reported, tide)) <= 0) break;
+
+      for (i = 0 ; i < count ; i++)
+        {
+          if (reported[i] != -998.0)
+            {
+              if ((reported[i] + tide[i]) == 0.0) zero_tide++;
+              checked++;
+            }
+        }
+
+      records_read += count;
+    }
+
+  reader_close (&reader);
+  fclose (fp);
+  free (records);
+
+  stats_count (STAT_RECORDS_READ, records_read);
+
+  audit_result (result, checked, zero_tide, records_read, CL_AUDIT_FULL);
+
+  return (0);
+}
+
+
+
+/*  Audit one file and print its line.  Returns 0 on success or -1 on error.  */
+
+int32_t audit_file (OPTIONS *options, char *file)
+{
+  static char        *status_name[] = {"tided", "untided", "no_data", "error"};
+  static char        *method_name[] = {"full", "sample", "index"};
+  CL_AUDIT_RESULT    result;
+  int32_t            status;
+
+
+  status = audit_run (options, file, &result);
+
+  printf ("%s,%s,%d,%d,%.3f,%d,%s\n", file, status_name[result.status], result.checked, result.zero_tide, result.percent,
+          result.records_read, method_name[result.method]);
+
+  return (status);
+}
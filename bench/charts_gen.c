@@ -0,0 +1,373 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : charts_gen.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Writes a synthetic CHARTS .hof, .tof, and .inh file set for
+ *               benchmarking charts_list (see run_bench.sh).  The files are
+ *               written through the CHARTS library so they are in the same
+ *               format as real files.
+ *
+ *               The survey is a set of east-west flight lines, each
+ *               LINE_SECONDS long, flown in alternating directions with a
+ *               sinusoidal scan across the track.  The west end of every line
+ *               (the land fraction) is land: abdc 70 and no depth.  Over the
+ *               water the depth increases away from the shore and the KGPS
+ *               water level follows a 12.42 hour tide.  Null depths, rejected
+ *               abdc codes, untided shots, and timestamp gaps are scattered
+ *               at random with the requested rates.
+ *
+ *               The same seed always gives the same files.  The random
+ *               numbers come from a local xorshift generator, not rand (), so
+ *               they don't depend on the C library.
+ *
+ ********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <math.h>
+
+
+/* Local Includes. */
+
+#include "nvutility.h"
+
+#include "FileHydroOutput.h"
+#include "FileTopoOutput.h"
+#include "FileWave.h"
+
+
+#define LINE_SECONDS         60.0
+#define LINE_SPACING         150.0                   /*  meters between lines  */
+#define SWATH_WIDTH          200.0                   /*  meters  */
+#define SCAN_RATE            10.0                    /*  scans per second  */
+#define SPEED                60.0                    /*  meters per second  */
+#define MAX_DEPTH            30.0
+#define TIDE_PERIOD          44712.0                 /*  seconds (M2)  */
+#define START_TIME           1300000000000000LL      /*  microseconds  */
+
+
+typedef struct
+{
+  int32_t            shots;
+  float              rep_rate;
+  double             null_fraction;
+  double             abdc_fraction;
+  double             land_fraction;
+  double             untided_fraction;
+  double             gap_fraction;
+  double             gap_seconds;
+  double             lat;
+  double             lon;
+  uint64_t           seed;
+} GEN_OPTIONS;
+
+
+static uint64_t      state;
+
+
+
+/*  xorshift64*, uniform in [0, 1).  */
+
+static double uniform ()
+{
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+
+  return ((double) ((state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0));
+}
+
+
+
+void usage ()
+{
+  fprintf (stderr, "\nUsage: charts_gen [-n SHOTS] [-r REP_RATE] [-z NULL_FRACTION] [-a ABDC_FRACTION] [-l LAND_FRACTION]\n");
+  fprintf (stderr, "\t[-t UNTIDED_FRACTION] [-G GAP_FRACTION,SECONDS] [-p LAT,LON] [-s SEED] BASE_NAME\n");
+  fprintf (stderr, "\nWhere:\n\n");
+  fprintf (stderr, "\t-n  =  number of shots (default 100000)\n");
+  fprintf (stderr, "\t-r  =  shots per second (default 1000)\n");
+  fprintf (stderr, "\t-z  =  fraction of water shots with null (-998.0) depths and\n");
+  fprintf (stderr, "\t\televations (default 0.05)\n");
+  fprintf (stderr, "\t-a  =  fraction of water shots with abdc 72, 74, or below 70\n");
+  fprintf (stderr, "\t\t(default 0.1)\n");
+  fprintf (stderr, "\t-l  =  fraction of each line that is over land (default 0.2)\n");
+  fprintf (stderr, "\t-t  =  fraction of shots with no tide correction (default 0.0)\n");
+  fprintf (stderr, "\t-G  =  chance of a timestamp gap after each shot and the gap length\n");
+  fprintf (stderr, "\t\tin seconds (default 0.0005,1.5)\n");
+  fprintf (stderr, "\t-p  =  position of the south west corner of the survey in decimal\n");
+  fprintf (stderr, "\t\tdegrees (default 30.0,-88.0)\n");
+  fprintf (stderr, "\t-s  =  random number seed (default 1)\n\n");
+  fprintf (stderr, "\tBASE_NAME.hof, BASE_NAME.tof, and BASE_NAME.inh are written.\n\n");
+  exit (-1);
+}
+
+
+
+static FILE *create_file (char *base, char *suffix, char *name, FILE *(*create) (char *path))
+{
+  FILE               *fp;
+
+
+  sprintf (name, "%s%s", base, suffix);
+
+  if ((fp = (*create) (name)) == NULL)
+    {
+      perror (name);
+      exit (-1);
+    }
+
+  return (fp);
+}
+
+
+
+int32_t main (int32_t argc, char **argv)
+{
+  char               hof_name[1024], tof_name[1024], wave_name[1024];
+  FILE               *hof_fp, *tof_fp, *wave_fp;
+  HOF_HEADER_T       hof_header;
+  TOF_HEADER_T       tof_header;
+  WAVE_HEADER_T      wave_header;
+  HYDRO_OUTPUT_T     hof;
+  TOPO_OUTPUT_T      tof;
+  WAVE_DATA_T        wave;
+  GEN_OPTIONS        options;
+  int32_t            c, i, j, line, line_shots;
+  int64_t            timestamp, step;
+  double             x, along, across, north, east, m_per_lat, m_per_lon, seconds, tide, depth, ground, r;
+
+
+  options.shots = 100000;
+  options.rep_rate = 1000.0;
+  options.null_fraction = 0.05;
+  options.abdc_fraction = 0.1;
+  options.land_fraction = 0.2;
+  options.untided_fraction = 0.0;
+  options.gap_fraction = 0.0005;
+  options.gap_seconds = 1.5;
+  options.lat = 30.0;
+  options.lon = -88.0;
+  options.seed = 1;
+
+
+  while ((c = getopt (argc, argv, "n:r:z:a:l:t:G:p:s:")) != EOF)
+    {
+      switch (c)
+        {
+        case 'n':
+          if (sscanf (optarg, "%d", &options.shots) != 1 || options.shots < 1) usage ();
+          break;
+
+        case 'r':
+          if (sscanf (optarg, "%f", &options.rep_rate) != 1 || options.rep_rate <= 0.0) usage ();
+          break;
+
+        case 'z':
+          if (sscanf (optarg, "%lf", &options.null_fraction) != 1) usage ();
+          break;
+
+        case 'a':
+          if (sscanf (optarg, "%lf", &options.abdc_fraction) != 1) usage ();
+          break;
+
+        case 'l':
+          if (sscanf (optarg, "%lf", &options.land_fraction) != 1 || options.land_fraction < 0.0 || options.land_fraction > 1.0) usage ();
+          break;
+
+        case 't':
+          if (sscanf (optarg, "%lf", &options.untided_fraction) != 1) usage ();
+          break;
+
+        case 'G':
+          if (sscanf (optarg, "%lf,%lf", &options.gap_fraction, &options.gap_seconds) != 2 || options.gap_seconds < 0.0) usage ();
+          break;
+
+        case 'p':
+          if (sscanf (optarg, "%lf,%lf", &options.lat, &options.lon) != 2) usage ();
+          break;
+
+        case 's':
+          if (sscanf (optarg, "%llu", (unsigned long long *) &options.seed) != 1) usage ();
+          break;
+
+        default:
+          usage ();
+          break;
+        }
+    }
+
+  if (optind != argc - 1) usage ();
+
+
+  state = options.seed * 0x9e3779b97f4a7c15ULL + 1;
+
+
+  hof_fp = create_file (argv[optind], ".hof", hof_name, create_hof_file);
+  tof_fp = create_file (argv[optind], ".tof", tof_name, create_tof_file);
+  wave_fp = create_file (argv[optind], ".inh", wave_name, create_wave_file);
+
+  memset (&hof_header, 0, sizeof (HOF_HEADER_T));
+  memset (&tof_header, 0, sizeof (TOF_HEADER_T));
+  memset (&wave_header, 0, sizeof (WAVE_HEADER_T));
+
+  hof_header.text.number_shots = tof_header.text.number_shots = wave_header.number_shots = options.shots;
+  hof_header.text.system_rep_rate = tof_header.text.system_rep_rate = options.rep_rate;
+
+  hof_write_header (hof_fp, &hof_header);
+  tof_write_header (tof_fp, &tof_header);
+  wave_write_header (wave_fp, &wave_header);
+
+
+  m_per_lat = 111132.954 - 559.822 * cos (2.0 * options.lat * M_PI / 180.0);
+  m_per_lon = 111412.84 * cos (options.lat * M_PI / 180.0);
+
+  line_shots = (int32_t) (LINE_SECONDS * options.rep_rate);
+  step = (int64_t) (1000000.0 / options.rep_rate);
+  timestamp = START_TIME;
+
+
+  for (i = 0 ; i < options.shots ; i++)
+    {
+      memset (&hof, 0, sizeof (HYDRO_OUTPUT_T));
+      memset (&tof, 0, sizeof (TOPO_OUTPUT_T));
+
+
+      /*  Position.  x is the fraction of the way along the line from the west end.  */
+
+      line = i / line_shots;
+      x = (double) (i % line_shots) / (double) line_shots;
+      if (line & 1) x = 1.0 - x;
+
+      seconds = (double) (timestamp - START_TIME) / 1000000.0;
+      along = x * LINE_SECONDS * SPEED;
+      across = 0.5 * SWATH_WIDTH * sin (2.0 * M_PI * SCAN_RATE * (double) i / options.rep_rate);
+
+      north = line * LINE_SPACING + across;
+      east = along;
+
+      hof.timestamp = tof.timestamp = timestamp;
+      hof.latitude = options.lat + north / m_per_lat;
+      hof.longitude = options.lon + east / m_per_lon;
+      hof.sec_latitude = hof.latitude;
+      hof.sec_longitude = hof.longitude;
+      tof.latitude_first = tof.latitude_last = hof.latitude;
+      tof.longitude_first = tof.longitude_last = hof.longitude;
+
+      hof.data_type = 1;
+      hof.haps_version = 4;
+      hof.altitude = tof.altitude = 400.0 + 2.0 * uniform ();
+      hof.nadir_angle = tof.nadir_angle = 20.0;
+      hof.scanner_azimuth = tof.scanner_azimuth = (float) (360.0 * fmod (SCAN_RATE * (double) i / options.rep_rate, 1.0));
+
+      tide = 0.5 * sin (2.0 * M_PI * seconds / TIDE_PERIOD) + 0.02 * (uniform () - 0.5);
+
+
+      if (x < options.land_fraction)
+        {
+          /*  Land.  */
+
+          ground = 1.0 + 10.0 * (options.land_fraction - x) / (options.land_fraction > 0.0 ? options.land_fraction : 1.0) + 0.2 * uniform ();
+
+          hof.abdc = hof.sec_abdc = 70;
+          hof.correct_depth = hof.correct_sec_depth = hof.reported_depth = -998.0;
+          hof.kgps_water_level = -998.0;
+          hof.elevation = hof.topo = hof.kgps_topo = ground;
+
+          tof.elevation_last = ground;
+          tof.elevation_first = (uniform () < 0.3) ? ground + 5.0 + 10.0 * uniform () : -998.0;
+        }
+      else
+        {
+          /*  Water.  */
+
+          depth = 1.0 + MAX_DEPTH * (x - options.land_fraction) / (1.0 - options.land_fraction) + 0.3 * uniform ();
+
+          hof.abdc = 71 + (int32_t) (25.0 * uniform ());
+          hof.sec_abdc = hof.abdc;
+          hof.correct_depth = hof.correct_sec_depth = -depth;
+          hof.reported_depth = hof.correct_depth;
+          hof.tide_cor_depth = tide;
+          hof.kgps_water_level = tide;
+          hof.elevation = hof.kgps_topo = hof.topo = -998.0;
+
+          r = uniform ();
+          if (r < options.abdc_fraction / 3.0)
+            {
+              hof.abdc = 72;
+            }
+          else if (r < options.abdc_fraction * 2.0 / 3.0)
+            {
+              hof.abdc = 74;
+            }
+          else if (r < options.abdc_fraction)
+            {
+              hof.abdc = 50 + (int32_t) (20.0 * uniform ());
+            }
+
+          if (uniform () < options.null_fraction)
+            {
+              hof.correct_depth = hof.reported_depth = -998.0;
+              hof.kgps_water_level = -998.0;
+            }
+
+          if (hof.reported_depth != -998.0 && uniform () < options.untided_fraction) hof.tide_cor_depth = -hof.reported_depth;
+
+          tof.elevation_first = -998.0;
+          tof.elevation_last = (uniform () < options.null_fraction) ? -998.0 : tide;
+        }
+
+
+      /*  Waveforms.  Only the contents matter to the decoder, so they're just noise.  */
+
+      for (j = 0 ; j < (int32_t) sizeof (wave) ; j++) ((uint8_t *) &wave)[j] = (uint8_t) (256.0 * uniform ());
+
+
+      if (!hof_write_record (hof_fp, i + 1, &hof) || !tof_write_record (tof_fp, i + 1, &tof) || !wave_write_record (wave_fp, i + 1, &wave))
+        {
+          perror ("Writing records");
+          exit (-1);
+        }
+
+
+      timestamp += step;
+      if (uniform () < options.gap_fraction) timestamp += (int64_t) (options.gap_seconds * 1000000.0);
+    }
+
+
+  fclose (hof_fp);
+  fclose (tof_fp);
+  fclose (wave_fp);
+
+
+  fprintf (stderr, "%s, %s, %s : %d shots\n", hof_name, tof_name, wave_name, options.shots);
+
+
+  return (0);
+}
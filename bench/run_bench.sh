@@ -0,0 +1,145 @@
+#!/bin/bash
+
+#  Benchmarks charts_list on synthetic data written by charts_gen.
+#
+#  Usage: run_bench.sh [CHARTS_LIST_OPTIONS ...]
+#
+#  Any arguments are added to every charts_list run (for example -j 4 or --prefetch 8).  The
+#  environment variables below change what is run:
+#
+#    CHARTS_LIST    charts_list program (default charts_list in the PATH, then ../charts_list)
+#    CHARTS_GEN     charts_gen program (default ./charts_gen, built from charts_gen.c if missing)
+#    BENCH_DATA     directory for the generated files (default ./bench_data)
+#    BENCH_SIZES    NAME:SHOTS pairs (default "small:100000 medium:2000000 large:20000000", the
+#                   large HOF file is about 3.5 GB)
+#    BENCH_RUNS     runs of each test, the fastest is reported (default 3)
+#    BENCH_SEED     charts_gen seed (default 1)
+#
+#  The generated files are kept and reused as long as they are newer than charts_gen.  For each
+#  size and mode it prints the shots listed per second, input MB read per second, and the peak
+#  resident set size of the largest process, all taken from charts_list --stats=json.  The MB/s
+#  column counts the HOF or TOF file (plus the .inh file for -s) whether or not the mode reads
+#  every byte of it.  Output goes to /dev/null.
+
+
+BENCH=`cd \`dirname $0\`; pwd`
+
+CHARTS_LIST=${CHARTS_LIST:-`which charts_list 2>/dev/null`}
+CHARTS_LIST=${CHARTS_LIST:-$BENCH/../charts_list}
+CHARTS_GEN=${CHARTS_GEN:-$BENCH/charts_gen}
+BENCH_DATA=${BENCH_DATA:-./bench_data}
+BENCH_SIZES=${BENCH_SIZES:-"small:100000 medium:2000000 large:20000000"}
+BENCH_RUNS=${BENCH_RUNS:-3}
+BENCH_SEED=${BENCH_SEED:-1}
+
+
+if [ ! -x $CHARTS_LIST ]; then
+    echo "Can't find charts_list, set CHARTS_LIST"
+    exit -1
+fi
+
+
+#  Build the generator the same way mk builds charts_list.
+
+if [ ! -x $CHARTS_GEN ]; then
+    PFM_ABE_DEV=${PFM_ABE_DEV:-"/usr/local"}
+
+    cc -O2 -DNVLinux -I $PFM_ABE_DEV/include -o $CHARTS_GEN $BENCH/charts_gen.c -L $PFM_ABE_DEV/lib -lCHARTS -lnvutility -lgdal \
+        -lxml2 -lpoppler -lm -lpthread
+    if [ $? != 0 ];then
+        exit -1
+    fi
+fi
+
+
+mkdir -p $BENCH_DATA
+
+
+#  -g position in the middle of the first line.
+
+GEO="30.0005,-87.98"
+
+
+#  run NAME SHOTS MEGABYTES OPTIONS FILE
+
+run ()
+{
+    rm -f $BENCH_DATA/stats.out
+
+    for i in `seq $BENCH_RUNS`; do
+        $CHARTS_LIST --stats=json $4 $EXTRA $5 >/dev/null 2>$BENCH_DATA/stderr.out
+        if [ $? != 0 ];then
+            echo "charts_list $4 $5 failed :"
+            cat $BENCH_DATA/stderr.out
+            return
+        fi
+
+        grep wall_seconds $BENCH_DATA/stderr.out >>$BENCH_DATA/stats.out
+    done
+
+
+    #  Fastest run and largest memory use.
+
+    awk -F '[:,] *' -v name=$1 -v file=`basename $5` -v mode="$4" -v shots=$2 -v mb=$3 '
+        {
+            for (i = 1 ; i < NF ; i++)
+                {
+                    if ($i ~ /"wall_seconds"/) seconds = $(i + 1)
+                    if ($i ~ /"max_rss_kb"/) rss = $(i + 1)
+                }
+
+            if (NR == 1 || seconds < best) best = seconds
+            if (rss > peak) peak = rss
+        }
+        END {
+            if (best < 0.001) best = 0.001
+            printf "%-8s %-12s %-22s %10.3f %14.0f %10.1f %10d\n", name, file, mode, best, shots / best, mb / best, peak
+        }' $BENCH_DATA/stats.out
+}
+
+
+EXTRA="$*"
+
+echo
+echo "`$CHARTS_LIST 2>&1 | grep -m 1 charts_list`"
+echo "`uname -srm`, `grep -c ^processor /proc/cpuinfo` processors, extra options : $EXTRA"
+echo
+
+printf "%-8s %-12s %-22s %10s %14s %10s %10s\n" size file mode seconds shots/s MB/s "peak KB"
+
+
+for SIZE in $BENCH_SIZES; do
+    NAME=`echo $SIZE | cut -d: -f1`
+    SHOTS=`echo $SIZE | cut -d: -f2`
+    BASE=$BENCH_DATA/$NAME
+
+    if [ ! $BASE.hof -nt $CHARTS_GEN ] || [ ! $BASE.tof -nt $CHARTS_GEN ] || [ ! $BASE.inh -nt $CHARTS_GEN ]; then
+        $CHARTS_GEN -n $SHOTS -s $BENCH_SEED $BASE
+        if [ $? != 0 ];then
+            exit -1
+        fi
+    fi
+
+    HOF_MB=$((`stat -c %s $BASE.hof` / 1048576))
+    TOF_MB=$((`stat -c %s $BASE.tof` / 1048576))
+    INH_MB=$((`stat -c %s $BASE.inh` / 1048576))
+    HALF=$((SHOTS / 2))
+
+    for MODE in "" "-y" "-d" "-w" "-W -g $GEO" "-t"; do
+        run $NAME $SHOTS $HOF_MB "$MODE" $BASE.hof
+    done
+
+    run $NAME $SHOTS $((HOF_MB + INH_MB)) "-s" $BASE.hof
+    run $NAME $HALF $((HOF_MB / 2)) "-n $HALF:" $BASE.hof
+
+    for MODE in "" "-y" "-d"; do
+        run $NAME $SHOTS $TOF_MB "$MODE" $BASE.tof
+    done
+
+    run $NAME $HALF $((TOF_MB / 2)) "-n $HALF:" $BASE.tof
+done
+
+
+rm -f $BENCH_DATA/stats.out $BENCH_DATA/stderr.out
+
+echo
@@ -0,0 +1,744 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+#ifndef __CHARTS_LIST_H__
+#define __CHARTS_LIST_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <getopt.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+
+/* Local Includes. */
+
+#include "nvutility.h"
+
+#include "FileHydroOutput.h"
+#include "FileTopoOutput.h"
+#include "FileWave.h"
+
+#include "version.h"
+
+#include "charts_list_api.h"
+
+
+/*  Size of the header block at the start of HOF and TOF files.  The records follow it.  */
+
+#ifndef HOF_HEAD_SIZE
+#define HOF_HEAD_SIZE 16384
+#endif
+
+#ifndef TOF_HEAD_SIZE
+#define TOF_HEAD_SIZE 16384
+#endif
+
+
+/*  Default size of the SRTM land mask cache in MB (see srtm_cache.c).  */
+
+#define SRTM_CACHE_DEFAULT_MB 64
+
+
+/*  Number of records decoded per batch in the full file loops.  */
+
+#define READ_BATCH 4096
+
+
+/*  Field storage types.  These values are also written to columnar files so don't change them.  */
+
+#define FIELD_INT8        1
+#define FIELD_UINT8       2
+#define FIELD_INT16       3
+#define FIELD_UINT16      4
+#define FIELD_INT32       5
+#define FIELD_UINT32      6
+#define FIELD_INT64       7
+#define FIELD_UINT64      8
+#define FIELD_FLOAT       9
+#define FIELD_DOUBLE      10
+
+
+/*  Maximum number of fields that can be selected at once.  */
+
+#define MAX_FIELDS        64
+
+
+/*  A HYDRO_OUTPUT_T or TOPO_OUTPUT_T field that can be selected by name (see fields.c).  */
+
+typedef struct
+{
+  char               *name;
+  int32_t            offset;                     /*  byte offset in the record structure  */
+  int32_t            type;                       /*  FIELD_INT8 ... FIELD_DOUBLE  */
+  int32_t            size;                       /*  bytes  */
+  int32_t            precision;                  /*  decimal places when printed as text  */
+} FIELD_DEF;
+
+
+/*  A list of fields resolved for one record type.  count is -1 if a name wasn't found (see bad).  */
+
+typedef struct
+{
+  int32_t            count;
+  FIELD_DEF          *field[MAX_FIELDS];
+  char               bad[64];
+} FIELD_SET;
+
+
+/*  A field list compiled for fast text output (see output_compile_fields in output.c).  */
+
+typedef char *(*FIELD_FUNC) (char *p, const uint8_t *value, int32_t precision);
+
+typedef struct
+{
+  FIELD_FUNC         func;
+  int32_t            offset;
+  int32_t            precision;
+} FIELD_FORMAT_ITEM;
+
+typedef struct
+{
+  int32_t            count;
+  char               delimiter;
+  FIELD_FORMAT_ITEM  item[MAX_FIELDS];
+} FIELD_FORMAT;
+
+
+/*  Columnar output file layout (see columnar.c).  */
+
+#define COLUMNAR_MAGIC    "CHRTSCOL"
+#define COLUMNAR_VERSION  1
+#define COLUMNAR_ALIGN    64
+
+typedef struct
+{
+  char               magic[8];                   /*  COLUMNAR_MAGIC, not null terminated  */
+  uint32_t           byte_order;                 /*  0x01020304 in the writer's byte order  */
+  uint32_t           version;                    /*  COLUMNAR_VERSION  */
+  uint32_t           header_size;                /*  sizeof (COLUMNAR_HEADER)  */
+  uint32_t           column_size;                /*  sizeof (COLUMNAR_COLUMN)  */
+  uint32_t           num_columns;
+  uint32_t           record_type;                /*  0 = HOF, 1 = TOF  */
+  uint64_t           num_rows;
+  char               source[512];                /*  input file name  */
+} COLUMNAR_HEADER;
+
+typedef struct
+{
+  char               name[32];                   /*  field name (see fields.c)  */
+  uint32_t           type;                       /*  FIELD_INT8 ... FIELD_DOUBLE  */
+  uint32_t           width;                      /*  bytes per value  */
+  uint64_t           offset;                     /*  start of the column data from the start of the file  */
+  double             min;
+  double             max;
+} COLUMNAR_COLUMN;
+
+
+/*  Summary sidecar file layout (see summary.c).  */
+
+#define SUMMARY_SUFFIX           ".clx"
+#define SUMMARY_MAGIC            "CHRTSIDX"
+#define SUMMARY_VERSION          2
+#define SUMMARY_BLOCK_SIZE       4096
+#define SUMMARY_DATA_TYPE_BINS   16
+#define SUMMARY_ABDC_BINS        256
+
+typedef struct
+{
+  char               magic[8];                   /*  SUMMARY_MAGIC, not null terminated  */
+  uint32_t           byte_order;                 /*  0x01020304 in the writer's byte order  */
+  uint32_t           version;                    /*  SUMMARY_VERSION  */
+  uint32_t           header_size;                /*  sizeof (SUMMARY_HEADER)  */
+  uint32_t           block_size;                 /*  records per SUMMARY_BLOCK  */
+  uint32_t           record_type;                /*  0 = HOF, 1 = TOF  */
+  int32_t            num_blocks;
+  int64_t            source_size;                /*  data file size and modification time when the sidecar was built  */
+  int64_t            source_mtime;
+  int64_t            source_mtime_ns;            /*  nanoseconds part of the modification time (0 where there isn't one)  */
+  int32_t            num_records;
+  int32_t            null_count;                 /*  correct_depth (HOF) or elevation_last (TOF) == -998.0  */
+  int32_t            null_first_count;           /*  TOF elevation_first == -998.0  */
+  int32_t            null_water_level_count;     /*  HOF kgps_water_level == -998.0  */
+  int32_t            tide_total;                 /*  HOF records checked by -t  */
+  int32_t            zero_tide_count;            /*  HOF records with no tide correction  */
+  int64_t            min_time;
+  int64_t            max_time;
+  double             min_lat;                    /*  TOF bounds include first and last returns  */
+  double             max_lat;
+  double             min_lon;
+  double             max_lon;
+  int32_t            data_type_hist[SUMMARY_DATA_TYPE_BINS + 1];    /*  last bin is everything else  */
+  int32_t            abdc_hist[SUMMARY_ABDC_BINS + 1];              /*  last bin is everything else  */
+} SUMMARY_HEADER;
+
+typedef struct
+{
+  int64_t            min_time;
+  int64_t            max_time;
+  double             min_lat;
+  double             max_lat;
+  double             min_lon;
+  double             max_lon;
+  int32_t            null_count;
+  int32_t            pad;
+} SUMMARY_BLOCK;
+
+typedef struct
+{
+  SUMMARY_HEADER     header;
+  SUMMARY_BLOCK      *block;                     /*  NULL if only the header was read  */
+} SUMMARY;
+
+
+/*  --incremental state file layout (see state.c).  */
+
+#define STATE_SUFFIX             ".state"
+#define STATE_MAGIC              "CHRTSSTA"
+#define STATE_VERSION            2
+
+typedef struct
+{
+  char               magic[8];                   /*  STATE_MAGIC, not null terminated  */
+  uint32_t           byte_order;                 /*  0x01020304 in the writer's byte order  */
+  uint32_t           version;                    /*  STATE_VERSION  */
+  uint32_t           header_size;                /*  sizeof (STATE_HEADER)  */
+  uint32_t           path_size;                  /*  full path of the data file, not null terminated  */
+  uint32_t           signature_size;             /*  option signature, not null terminated  */
+  uint32_t           pad;
+  int64_t            source_size;                /*  data file size, modification time, and fingerprint when it was listed  */
+  int64_t            source_mtime;
+  int64_t            source_mtime_ns;            /*  nanoseconds part of the modification time (0 where there isn't one)  */
+  uint64_t           fingerprint;
+  int64_t            out_size;                   /*  saved stdout bytes  */
+  int64_t            err_size;                   /*  saved stderr bytes  */
+} STATE_HEADER;
+
+
+/*  -n record numbers and ranges (see record_list.c).  last is INT32_MAX for the end of the file.  */
+
+typedef struct
+{
+  int32_t            first;
+  int32_t            last;
+} RECORD_RANGE;
+
+typedef struct
+{
+  RECORD_RANGE       *range;
+  int32_t            count;
+  int32_t            size;
+} RECORD_LIST;
+
+
+/*  Reference point for batched distances (see geodesic.c).  */
+
+#define GEO_BATCH            64
+
+typedef struct
+{
+  double             lat;                        /*  degrees  */
+  double             lon;
+  double             lon_rad;
+  double             a;
+  double             f;
+  double             r;                          /*  1 - f  */
+  double             tu1;                        /*  reduced latitude terms  */
+  double             su1;
+  double             cu1;
+  uint8_t            use_invgp;                  /*  the kernel failed its check against invgp  */
+} GEO_REFERENCE;
+
+
+/*  --stats phases and counters (see stats.c).  */
+
+#define STATS_OFF                0
+#define STATS_TEXT               1
+#define STATS_JSON               2
+
+#define STAT_OPEN                0
+#define STAT_READ                1
+#define STAT_FILTER              2
+#define STAT_SRTM                3
+#define STAT_GEODESIC            4
+#define STAT_FORMAT              5
+#define STAT_WRITE               6
+#define STAT_PHASES              7
+
+#define STAT_FILES               0
+#define STAT_RECORDS_READ        1
+#define STAT_BYTES_READ          2
+#define STAT_BYTES_WRITTEN       3
+#define STAT_REJECTED_FILTER     4
+#define STAT_REJECTED_NULL       5
+#define STAT_REJECTED_ABDC       6
+#define STAT_REJECTED_DATA_TYPE  7
+#define STAT_REJECTED_LAND       8
+#define STAT_REJECTED_EDGE       9
+#define STAT_COUNTS              10
+
+typedef struct
+{
+  double             start;
+  double             inner;                      /*  nested phase time when the timer started  */
+} STAT_TIMER;
+
+
+/*  --bbox, --polygon, --time, and --radius filters (see filter.c).  TOF records are selected by
+    their last return position.  */
+
+typedef struct
+{
+  uint8_t            active;                     /*  any filter is set  */
+  uint8_t            area;                       /*  --bbox and/or --polygon  */
+  uint8_t            time;                       /*  --time  */
+  double             min_lat;                    /*  bounding box, intersected with the polygon bounds  */
+  double             min_lon;
+  double             max_lat;
+  double             max_lon;
+  int32_t            poly_count;
+  double             *poly_lat;
+  double             *poly_lon;
+  int64_t            start_time;
+  int64_t            end_time;
+  uint8_t            radius;                     /*  --radius  */
+  double             max_distance;               /*  meters from center  */
+  GEO_REFERENCE      center;
+} RECORD_FILTER;
+
+
+/*  --grid output (see grid.c).  */
+
+#define GRID_MAGIC           "CHRTSGRD"
+#define GRID_VERSION         1
+#define GRID_NULL            -998.0f
+#define GRID_FIRST_RETURN    1
+#define GRID_LAST_RETURN     2
+
+typedef struct
+{
+  char               magic[8];                   /*  GRID_MAGIC  */
+  int32_t            version;
+  int32_t            rows;                       /*  row 0 is the southern edge  */
+  int32_t            cols;
+  int32_t            value_type;                 /*  0 = HOF correct_depth, 1 = TOF elevation  */
+  double             min_lat;                    /*  south west corner of cell 0,0 (degrees)  */
+  double             min_lon;
+  double             cell_lat;
+  double             cell_lon;
+  float              null_value;                 /*  GRID_NULL  */
+  int32_t            reserved;
+} GRID_HEADER;
+
+typedef struct
+{
+  double             min_lat;
+  double             min_lon;
+  double             cell_lat;
+  double             cell_lon;
+  int32_t            rows;
+  int32_t            cols;
+  int32_t            value_type;
+  uint8_t            returns;                    /*  TOF GRID_FIRST_RETURN and/or GRID_LAST_RETURN  */
+  char               *out;                       /*  --grid-out  */
+} GRID_SPEC;
+
+
+/*  Most --windows widths.  */
+
+#define WL_MAX_WINDOWS       16
+
+
+/*  Command line options shared by every file processed in a run.  */
+
+typedef struct
+{
+  int32_t            rec_num;                    /*  first -n record number, -1 for all records  */
+  RECORD_LIST        records;                    /*  -n record numbers and ranges  */
+  uint8_t            tide_check;                 /*  -t  */
+  uint8_t            list_null;                  /*  cleared by -d  */
+  uint8_t            water_level;                /*  -w or -W  */
+  uint8_t            average;                    /*  -w (NVTrue) or -W (NVFalse)  */
+  uint8_t            yxz;                        /*  -y  */
+  uint8_t            shot_data;                  /*  -s  */
+  uint8_t            geo_check;                  /*  -g  */
+  NV_F64_COORD2      geo;                        /*  -g position  */
+  GEO_REFERENCE      geo_ref;                    /*  -g position set up for geo_distance  */
+  int32_t            workers;                    /*  -j number of worker processes  */
+  uint8_t            use_library;                /*  -L read records with the CHARTS library instead of mmap  */
+  int32_t            chunk_records;              /*  -c records per chunk when splitting files, 0 for automatic  */
+  uint8_t            columnar;                   /*  --columnar  */
+  char               *columnar_dir;              /*  --columnar=DIR, NULL to write beside the input file  */
+  FIELD_SET          hof_columns;                /*  --columns resolved for HOF files  */
+  FIELD_SET          tof_columns;                /*  --columns resolved for TOF files  */
+  uint8_t            fields;                     /*  --fields  */
+  FIELD_SET          hof_fields;                 /*  --fields resolved for HOF files  */
+  FIELD_SET          tof_fields;                 /*  --fields resolved for TOF files  */
+  FIELD_FORMAT       hof_format;                 /*  compiled hof_fields  */
+  FIELD_FORMAT       tof_format;                 /*  compiled tof_fields  */
+  uint8_t            index;                      /*  --index  */
+  uint8_t            summary;                    /*  --summary  */
+  RECORD_FILTER      filter;                     /*  --bbox, --polygon, --time, --radius  */
+  int32_t            srtm_cache_mb;              /*  --srtm-cache, 0 to read the SRTM mask directly  */
+  int32_t            wl_num_windows;             /*  -w and -W averaging windows, 1 unless --windows  */
+  int64_t            wl_width[WL_MAX_WINDOWS];   /*  window widths in microseconds  */
+  uint8_t            wl_stats;                   /*  --windows, add the window statistics to the output  */
+  uint8_t            merge;                      /*  --merge  */
+  uint8_t            merge_source;               /*  --source, add the source file to merged output  */
+  uint8_t            audit;                      /*  --audit  */
+  double             audit_confidence;           /*  --audit=CONFIDENCE, 0 to check every shot  */
+  uint8_t            gridding;                   /*  --grid  */
+  GRID_SPEC          grid;                       /*  --grid, --grid-out, --grid-return  */
+  int32_t            prefetch_depth;             /*  --prefetch reads in flight, 0 for none  */
+  int32_t            prefetch_mb;                /*  --prefetch read size  */
+  uint8_t            stats;                      /*  --stats, STATS_OFF, STATS_TEXT, or STATS_JSON  */
+  uint8_t            compress;                   /*  --compress  */
+  int32_t            compress_level;             /*  --compress gzip level  */
+  char               *server;                    /*  --server socket path, NULL if not serving  */
+  int32_t            server_files;               /*  --server files kept open  */
+  char               *state_dir;                 /*  --incremental state directory, NULL if not incremental  */
+  char               *state_signature;           /*  --incremental version and output options  */
+  uint8_t            joint;                      /*  --joint  */
+  uint8_t            quiet;                      /*  no per file messages (library calls, see api.c)  */
+  CL_WATER_LEVEL_FUNC wl_func;                   /*  -w and -W samples go here instead of stdout if not NULL  */
+  void               *wl_data;
+} OPTIONS;
+
+
+/*  List of input files built from the command line, directories, and list files.  */
+
+typedef struct
+{
+  char               **name;
+  int32_t            count;
+  int32_t            size;
+} FILE_LIST;
+
+
+/*  A range of records from one file.  Files are split into chunks so that workers can process a
+    single large file in parallel.  last is -1 for the end of the file.  */
+
+typedef struct
+{
+  char               *file;
+  int32_t            first;
+  int32_t            last;
+} FILE_CHUNK;
+
+
+/*  Read ahead file reader for --prefetch (see prefetch.c).  */
+
+#define PREFETCH_DEFAULT_MB  4
+
+typedef struct PREFETCH PREFETCH;
+
+
+/*  Bulk HOF/TOF record reader (see record_reader.c).  */
+
+typedef struct
+{
+  int32_t            type;                       /*  0 = HOF, 1 = TOF  */
+  FILE               *fp;                        /*  library file handle, owned by the caller  */
+  int32_t            num_records;                /*  -1 if unknown (TOF read through the library)  */
+  int64_t            head_size;
+  int32_t            record_size;
+  uint8_t            mapped;
+  uint8_t            *map;
+  int64_t            map_size;
+  int64_t            advised;                    /*  end of the last read ahead hint  */
+  int32_t            lib_next;                   /*  record the library will return for a sequential read  */
+  PREFETCH           *prefetch;                  /*  --prefetch reader, used instead of the mapping  */
+} RECORD_READER;
+
+
+/*  File types for file_cache_open (see file_cache.c).  */
+
+#define FILE_CACHE_HOF       0
+#define FILE_CACHE_TOF       1
+#define FILE_CACHE_WAVE      2
+
+#define SERVER_DEFAULT_FILES 64
+
+
+/*  Pipelined HOF and waveform reader for -s (see shot_reader.c).  */
+
+#define SHOT_VALUE_COUNT     24
+#define SHOT_BATCH_RECORDS   512
+#define SHOT_DEPTH           4
+
+typedef struct
+{
+  float              f[SHOT_VALUE_COUNT];
+  int32_t            i32[SHOT_VALUE_COUNT];
+  int16_t            i16[SHOT_VALUE_COUNT * 2];
+} SHOT_VALUES;
+
+typedef struct
+{
+  int32_t            first;                      /*  1 based record number of hof[0]  */
+  int32_t            count;                      /*  0 at the end of the range  */
+  HYDRO_OUTPUT_T     *hof;
+  SHOT_VALUES        *values;
+} SHOT_BATCH;
+
+typedef struct
+{
+  RECORD_READER      *reader;
+  FILE               *wfp;
+  int32_t            wave_size;                  /*  wave_record_size  */
+  int32_t            next;                       /*  next record the thread will read  */
+  int32_t            last;
+  SHOT_BATCH         batch[SHOT_DEPTH];
+  int32_t            head;
+  int32_t            tail;
+  int32_t            filled;
+  uint8_t            holding;                    /*  the caller has batch[head]  */
+  uint8_t            stop;
+  uint8_t            running;
+  pthread_t          thread;
+  pthread_mutex_t    mutex;
+  pthread_cond_t     ready;
+  pthread_cond_t     space;
+} SHOT_READER;
+
+
+/*  Buffered text output (see output.c).  */
+
+typedef struct
+{
+  FILE               *fp;
+  char               *buffer;
+  int32_t            size;
+  int32_t            used;
+} OUTPUT_BUFFER;
+
+
+/*  Streaming -w and -W aggregation (see water_level.c).  */
+
+typedef struct
+{
+  int64_t            width;                      /*  microseconds  */
+  int64_t            start_time;
+  int64_t            last_time;
+  int32_t            count;
+  double             sum;
+  double             sumlat;
+  double             sumlon;
+  double             mean;                       /*  running mean and sum of squared differences (Welford)  */
+  double             m2;
+  float              min;
+  float              max;
+} WL_WINDOW;
+
+typedef struct
+{
+  OUTPUT_BUFFER      *out;
+  GEO_REFERENCE      *geo_ref;
+  uint8_t            average;
+  uint8_t            stats;
+  uint8_t            geo_check;
+  CL_WATER_LEVEL_FUNC func;                      /*  NULL for text output  */
+  void               *data;
+  int32_t            num_windows;
+  WL_WINDOW          window[WL_MAX_WINDOWS];
+} WATER_LEVEL;
+
+
+/*  Columnar file writer (see columnar.c).  */
+
+typedef struct
+{
+  int32_t            type;
+  FIELD_SET          *fields;
+  char               source[512];
+  char               path[1024];
+  FILE               *spool[MAX_FIELDS];
+  uint8_t            *buffer[MAX_FIELDS];
+  int32_t            used[MAX_FIELDS];
+  double             min[MAX_FIELDS];
+  double             max[MAX_FIELDS];
+  uint64_t           rows;
+} COLUMNAR_WRITER;
+
+
+/*  What the record loop kernels work with besides the records (see kernels.c).  */
+
+typedef struct
+{
+  OUTPUT_BUFFER      *out;
+  COLUMNAR_WRITER    *col;
+  FIELD_FORMAT       *format;                    /*  --fields  */
+  WATER_LEVEL        *wl;
+  double             per_ten_sec;                /*  -w and -W, shots in the first and last ten seconds skipped  */
+  int32_t            number_shots;
+  int32_t            total;                      /*  -t valid depths  */
+  int32_t            zero_tide;                  /*  -t valid depths with no tide correction  */
+} KERNEL_STATE;
+
+typedef int32_t (*RECORD_KERNEL) (KERNEL_STATE *state, void *records, int32_t start, int32_t count, uint8_t *pass, SHOT_VALUES *values);
+
+
+/*  A job is run once per job number, possibly in a child process.  Returns 0 on success.  */
+
+typedef int32_t (*JOB_FUNC) (int32_t job, void *data);
+
+
+/*  Lists a whole file for --incremental (see state.c).  */
+
+typedef int32_t (*STATE_FUNC) (OPTIONS *options, char *file, int32_t first_rec, int32_t last_rec);
+
+
+int32_t process_file (OPTIONS *options, char *file, int32_t first_rec, int32_t last_rec);
+int32_t count_file_records (OPTIONS *options, char *file);
+
+void file_list_init (FILE_LIST *list);
+int32_t file_list_add (FILE_LIST *list, char *path, uint8_t hof_only);
+int32_t file_list_read (FILE_LIST *list, char *list_file, uint8_t hof_only);
+void file_list_free (FILE_LIST *list);
+
+void reader_open (RECORD_READER *reader, FILE *fp, char *file, int32_t type, int32_t num_records, uint8_t use_library);
+int32_t reader_read (RECORD_READER *reader, int32_t first, int32_t count, void *records);
+int32_t reader_gather (RECORD_READER *reader, int32_t first, int32_t count, int32_t offset, int32_t size, void *values);
+void reader_advise (RECORD_READER *reader, uint8_t random);
+void reader_close (RECORD_READER *reader);
+void reader_set_prefetch (int32_t depth, int32_t megabytes);
+double reader_wait (RECORD_READER *reader);
+
+PREFETCH *prefetch_open (char *file, int32_t depth, int64_t chunk_size);
+int64_t prefetch_read (PREFETCH *pf, int64_t offset, int64_t size, void *buffer);
+double prefetch_wait (PREFETCH *pf);
+char *prefetch_backend (PREFETCH *pf);
+void prefetch_close (PREFETCH *pf);
+
+void output_init (OUTPUT_BUFFER *out, FILE *fp);
+void output_flush (OUTPUT_BUFFER *out);
+void output_close (OUTPUT_BUFFER *out);
+void output_fixed (OUTPUT_BUFFER *out, double value, int32_t precision);
+void output_char (OUTPUT_BUFFER *out, char c);
+void output_yxz (OUTPUT_BUFFER *out, double lat, double lon, double z);
+void output_yxz_source (OUTPUT_BUFFER *out, double lat, double lon, double z, char source);
+void output_water_level (OUTPUT_BUFFER *out, double lat, double lon, int32_t year, int32_t jday, int32_t hour, int32_t minute,
+                         float second, float level, uint8_t geo_check, double dist);
+void output_water_level_stats (OUTPUT_BUFFER *out, double lat, double lon, int32_t year, int32_t jday, int32_t hour, int32_t minute,
+                               float second, float level, uint8_t geo_check, double dist, int64_t width, int32_t count, float min,
+                               float max, double variance);
+void output_shot_data (OUTPUT_BUFFER *out, SHOT_VALUES *values);
+void output_compile_fields (FIELD_SET *set, char delimiter, FIELD_FORMAT *format);
+void output_record (OUTPUT_BUFFER *out, FIELD_FORMAT *format, void *record);
+
+FIELD_DEF *field_lookup (int32_t type, char *name);
+void field_set_parse (FIELD_SET *set, int32_t type, char *list);
+double field_value (void *record, FIELD_DEF *field);
+
+int32_t columnar_open (COLUMNAR_WRITER *col, char *file, char *dir, int32_t type, FIELD_SET *fields);
+void columnar_add (COLUMNAR_WRITER *col, void *record);
+int32_t columnar_close (COLUMNAR_WRITER *col);
+void columnar_abort (COLUMNAR_WRITER *col);
+
+int32_t summary_build (OPTIONS *options, char *file, SUMMARY *summary);
+int32_t summary_write (char *file, SUMMARY *summary);
+int32_t summary_read (char *file, SUMMARY *summary, uint8_t blocks);
+void summary_free (SUMMARY *summary);
+void summary_print (char *file, SUMMARY *summary);
+int32_t summary_file (OPTIONS *options, char *file);
+
+void decode_shot_data (WAVE_DATA_T *wave, SHOT_VALUES *values, int32_t count);
+int32_t wave_record_size (FILE *wfp);
+void wave_read (FILE *wfp, int32_t num, WAVE_DATA_T *wave_data, int32_t size);
+int32_t shot_reader_open (SHOT_READER *shots, RECORD_READER *reader, FILE *wfp, int32_t first, int32_t last);
+SHOT_BATCH *shot_reader_next (SHOT_READER *shots);
+void shot_reader_close (SHOT_READER *shots);
+
+RECORD_KERNEL kernel_select (OPTIONS *options, int32_t type, uint8_t srtm_check);
+
+void srtm_cache_init (int32_t megabytes);
+void srtm_cache_free ();
+int32_t srtm_cache_read (double lat, double lon);
+void wl_init (WATER_LEVEL *wl, OPTIONS *options, OUTPUT_BUFFER *out);
+void wl_add (WATER_LEVEL *wl, int64_t timestamp, double lat, double lon, float level);
+int32_t wl_parse_windows (OPTIONS *options, char *list);
+
+int32_t merge_files (OPTIONS *options, FILE_LIST *list);
+
+int32_t joint_files (OPTIONS *options, FILE_LIST *list);
+
+int32_t audit_run (OPTIONS *options, char *file, CL_AUDIT_RESULT *result);
+int32_t audit_file (OPTIONS *options, char *file);
+
+int32_t grid_parse (GRID_SPEC *spec, char *string);
+int32_t grid_file (OPTIONS *options, char *file, int32_t first_rec, int32_t last_rec);
+int32_t grid_merge (GRID_SPEC *spec, FILE **spool, int32_t num_spools);
+
+void geo_distance_init (GEO_REFERENCE *ref, double lat, double lon);
+double geo_distance (GEO_REFERENCE *ref, double lat, double lon);
+void geo_within_batch (GEO_REFERENCE *ref, const double *lat, const double *lon, double max_distance, uint8_t *pass, int32_t count);
+
+void record_list_init (RECORD_LIST *list);
+int32_t record_list_parse (RECORD_LIST *list, char *arg);
+void record_list_free (RECORD_LIST *list);
+
+void filter_init (RECORD_FILTER *filter);
+int32_t filter_parse_bbox (RECORD_FILTER *filter, char *string);
+int32_t filter_read_polygon (RECORD_FILTER *filter, char *file);
+int32_t filter_parse_time (RECORD_FILTER *filter, char *string);
+void filter_free (RECORD_FILTER *filter);
+void filter_set_radius (RECORD_FILTER *filter, double lat, double lon, double meters);
+uint8_t filter_record (RECORD_FILTER *filter, int64_t timestamp, double lat, double lon);
+void filter_batch (RECORD_FILTER *filter, int32_t type, void *records, int32_t count, uint8_t *pass);
+void filter_time_range (RECORD_FILTER *filter, RECORD_READER *reader, int32_t *first, int32_t *last);
+int32_t filter_span (RECORD_FILTER *filter, SUMMARY *summary, int32_t start, int32_t count);
+
+void file_cache_init (int32_t max_files);
+void file_cache_free ();
+FILE *file_cache_open (char *file, int32_t type);
+void file_cache_close (FILE *fp);
+void file_cache_hof_header (FILE *fp, HOF_HEADER_T *header);
+void file_cache_wave_header (FILE *fp, WAVE_HEADER_T *header);
+void file_cache_reader_open (RECORD_READER *reader, FILE *fp, char *file, int32_t type, int32_t num_records, uint8_t use_library);
+void file_cache_reader_close (RECORD_READER *reader);
+int32_t server_run (OPTIONS *options, char *path, int32_t max_files);
+
+int32_t compress_start (int32_t level, int32_t num_threads);
+int32_t compress_finish ();
+
+int32_t state_file (OPTIONS *options, char *file, STATE_FUNC func);
+void state_sign_options (OPTIONS *options);
+
+void stats_init (int32_t mode);
+STAT_TIMER stats_start ();
+void stats_stop (int32_t phase, STAT_TIMER timer);
+void stats_count (int32_t counter, int64_t n);
+void stats_flush ();
+void stats_report ();
+
+double wall_clock ();
+int32_t get_worker_count (int32_t requested);
+int32_t run_ordered_jobs (int32_t num_jobs, int32_t workers, JOB_FUNC func, void *data);
+int32_t run_spooled_jobs (int32_t num_jobs, int32_t workers, JOB_FUNC func, void *data, FILE **spool);
+
+
+#endif
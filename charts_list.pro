@@ -1,5 +1,5 @@
 INCLUDEPATH += /c/PFM_ABEv7.0.0_Win64/include
-LIBS += -L /c/PFM_ABEv7.0.0_Win64/lib -lCHARTS -lnvutility -lgdal -lxml2 -lpoppler -lm -liconv
+LIBS += -L /c/PFM_ABEv7.0.0_Win64/lib -lCHARTS -lnvutility -lgdal -lxml2 -lpoppler -lm -lpthread -liconv
 DEFINES += NVWIN3X
 CONFIG += console
 QMAKE_LFLAGS += 
@@ -13,5 +13,5 @@ DEPENDPATH += .
 INCLUDEPATH += .
 
 # Input
-HEADERS += version.h
-SOURCES += main.c
+HEADERS += charts_list.h charts_list_api.h version.h
+SOURCES += api.c audit.c columnar.c compress.c fields.c file_cache.c file_list.c filter.c geodesic.c grid.c jobs.c joint.c kernels.c main.c merge.c output.c prefetch.c process_file.c record_list.c record_reader.c server.c shot_reader.c srtm_cache.c state.c stats.c summary.c water_level.c
@@ -0,0 +1,152 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : charts_list_api.h
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : The charts_list library (libcharts_list.a, built by mk from
+ *               lib/charts_list.pro), for programs that want HOF and TOF
+ *               records, water level samples, or tide audits without running
+ *               charts_list and parsing its text.  See api.c.
+ *
+ *               Link with the library, the CHARTS library and its
+ *               dependencies, and -lpthread.  The functions aren't thread
+ *               safe, use one thread or one process per file.
+ *
+ ********************************************************************/
+
+#ifndef __CHARTS_LIST_API_H__
+#define __CHARTS_LIST_API_H__
+
+#include <stdint.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+
+/*  File types.  */
+
+#define CL_HOF               0
+#define CL_TOF               1
+
+
+/*  Column storage types from cl_column_type, the same numbers as the charts_list columnar files.  */
+
+#define CL_INT8              1
+#define CL_UINT8             2
+#define CL_INT16             3
+#define CL_UINT16            4
+#define CL_INT32             5
+#define CL_UINT32            6
+#define CL_INT64             7
+#define CL_UINT64            8
+#define CL_FLOAT             9
+#define CL_DOUBLE            10
+
+
+/*  An open HOF or TOF file.  */
+
+typedef struct CL_FILE CL_FILE;
+
+
+/*  Water level settings for cl_water_level, the -w, -W, --windows, and -g options.  */
+
+#define CL_MAX_WINDOWS       16
+
+typedef struct
+{
+  int32_t            average;                    /*  1 to average over windows (-w), 0 for every shot (-W)  */
+  int32_t            num_windows;                /*  0 for one 2 second window  */
+  double             window_seconds[CL_MAX_WINDOWS];
+  int32_t            geo_check;                  /*  1 to compute each sample's distance from lat, lon  */
+  double             lat;
+  double             lon;
+  int32_t            srtm_cache_mb;              /*  SRTM land mask cache, 0 for none  */
+} CL_WATER_LEVEL_OPTIONS;
+
+typedef struct
+{
+  int64_t            timestamp;                  /*  CHARTS time (microseconds), see charts_cvtime  */
+  double             latitude;
+  double             longitude;
+  float              level;
+  double             distance;                   /*  meters from lat, lon with geo_check, otherwise 0  */
+  double             width_seconds;              /*  window width  */
+  int32_t            count;                      /*  shots in the window  */
+  float              min;
+  float              max;
+  double             variance;
+} CL_WATER_LEVEL_SAMPLE;
+
+typedef void (*CL_WATER_LEVEL_FUNC) (CL_WATER_LEVEL_SAMPLE *sample, void *data);
+
+
+/*  Tide audit result from cl_audit, the fields of a --audit line.  */
+
+#define CL_AUDIT_TIDED       0
+#define CL_AUDIT_UNTIDED     1
+#define CL_AUDIT_NO_DATA     2
+#define CL_AUDIT_ERROR       3
+
+#define CL_AUDIT_FULL        0                   /*  every shot was checked  */
+#define CL_AUDIT_SAMPLE      1                   /*  sampled until the answer was certain enough  */
+#define CL_AUDIT_INDEX       2                   /*  counts from the --index sidecar  */
+
+typedef struct
+{
+  int32_t            status;                     /*  CL_AUDIT_TIDED ... CL_AUDIT_ERROR  */
+  int32_t            checked;                    /*  shots with a valid reported depth  */
+  int32_t            zero_tide;                  /*  checked shots with no tide correction  */
+  double             percent;                    /*  zero_tide / checked * 100  */
+  int32_t            records_read;
+  int32_t            method;                     /*  CL_AUDIT_FULL, CL_AUDIT_SAMPLE, or CL_AUDIT_INDEX  */
+} CL_AUDIT_RESULT;
+
+
+CL_FILE *cl_open (char *file, int32_t use_library);
+void cl_close (CL_FILE *cf);
+int32_t cl_type (CL_FILE *cf);
+int32_t cl_num_records (CL_FILE *cf);
+
+int32_t cl_read_records (CL_FILE *cf, int32_t first, int32_t count, void *records);
+void *cl_view_records (CL_FILE *cf, int32_t first, int32_t *count);
+
+int32_t cl_select (CL_FILE *cf, char *fields);
+int32_t cl_column_type (CL_FILE *cf, int32_t column);
+int32_t cl_column_size (CL_FILE *cf, int32_t column);
+int32_t cl_seek (CL_FILE *cf, int32_t record);
+int32_t cl_read_columns (CL_FILE *cf, int32_t count, void **columns);
+
+int32_t cl_water_level (char *file, CL_WATER_LEVEL_OPTIONS *wl_options, CL_WATER_LEVEL_FUNC func, void *data);
+int32_t cl_audit (char *file, double confidence, CL_AUDIT_RESULT *result);
+
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
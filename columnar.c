@@ -0,0 +1,258 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : columnar.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Writes selected HOF or TOF record fields to a binary columnar
+ *               file.  All values are in the byte order of the machine that
+ *               wrote the file (see byte_order in the header).
+ *
+ *               Layout:
+ *
+ *                 COLUMNAR_HEADER           (fixed size, see charts_list.h)
+ *                 COLUMNAR_COLUMN           one per column
+ *                 column data               one contiguous array per column,
+ *                                           each starting on a
+ *                                           COLUMNAR_ALIGN byte boundary
+ *
+ *               Each column keeps the field's storage type from
+ *               HYDRO_OUTPUT_T or TOPO_OUTPUT_T (type and width are in the
+ *               column descriptor) along with its minimum and maximum.  A
+ *               reader can map the file and use only the columns it needs.
+ *
+ *               Since the number of rows isn't known until the file has
+ *               been read (-d drops null records), each column is spooled
+ *               to its own temporary file and the output file is assembled
+ *               when it is closed.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+/*  Size of the per column spool buffers.  */
+
+#define COLUMNAR_SPOOL_SIZE (64 * 1024)
+
+
+
+/*  Set up a columnar writer for file.  The output is file.col, in dir if it isn't NULL.  Returns 0
+    on success or -1 on error.  */
+
+int32_t columnar_open (COLUMNAR_WRITER *col, char *file, char *dir, int32_t type, FIELD_SET *fields)
+{
+  int32_t            i;
+  char               *name;
+
+
+  memset (col, 0, sizeof (COLUMNAR_WRITER));
+
+  col->type = type;
+  col->fields = fields;
+
+  snprintf (col->source, sizeof (col->source), "%s", file);
+
+  if (dir != NULL)
+    {
+      if ((name = strrchr (file, '/')) == NULL) name = file;
+      else name++;
+
+      snprintf (col->path, sizeof (col->path), "%s/%s.col", dir, name);
+    }
+  else
+    {
+      snprintf (col->path, sizeof (col->path), "%s.col", file);
+    }
+
+
+  for (i = 0 ; i < fields->count ; i++)
+    {
+      if ((col->spool[i] = tmpfile ()) == NULL || (col->buffer[i] = (uint8_t *) malloc (COLUMNAR_SPOOL_SIZE)) == NULL)
+        {
+          perror ("Creating columnar spool file");
+          columnar_abort (col);
+          return (-1);
+        }
+
+      col->min[i] = 1.0e300;
+      col->max[i] = -1.0e300;
+    }
+
+  return (0);
+}
+
+
+
+static void columnar_spool (COLUMNAR_WRITER *col, int32_t column)
+{
+  if (col->used[column])
+    {
+      fwrite (col->buffer[column], 1, col->used[column], col->spool[column]);
+      col->used[column] = 0;
+    }
+}
+
+
+
+/*  Append one HYDRO_OUTPUT_T or TOPO_OUTPUT_T record.  */
+
+void columnar_add (COLUMNAR_WRITER *col, void *record)
+{
+  int32_t            i, width;
+  FIELD_DEF          *field;
+  double             value;
+
+
+  for (i = 0 ; i < col->fields->count ; i++)
+    {
+      field = col->fields->field[i];
+      width = field->size;
+
+      if (col->used[i] + width > COLUMNAR_SPOOL_SIZE) columnar_spool (col, i);
+
+      memcpy (col->buffer[i] + col->used[i], (uint8_t *) record + field->offset, width);
+      col->used[i] += width;
+
+      value = field_value (record, field);
+      if (value < col->min[i]) col->min[i] = value;
+      if (value > col->max[i]) col->max[i] = value;
+    }
+
+  col->rows++;
+}
+
+
+
+/*  Write the output file.  Returns 0 on success or -1 on error.  */
+
+int32_t columnar_close (COLUMNAR_WRITER *col)
+{
+  FILE               *fp;
+  COLUMNAR_HEADER    header;
+  COLUMNAR_COLUMN    column;
+  uint8_t            buffer[COLUMNAR_SPOOL_SIZE];
+  uint64_t           offset, pad;
+  size_t             size;
+  int32_t            i, status = 0;
+
+
+  if ((fp = fopen (col->path, "wb")) == NULL)
+    {
+      perror (col->path);
+      columnar_abort (col);
+      return (-1);
+    }
+
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, COLUMNAR_MAGIC, sizeof (header.magic));
+  header.byte_order = 0x01020304;
+  header.version = COLUMNAR_VERSION;
+  header.header_size = sizeof (COLUMNAR_HEADER);
+  header.column_size = sizeof (COLUMNAR_COLUMN);
+  header.num_columns = col->fields->count;
+  header.record_type = col->type;
+  header.num_rows = col->rows;
+  snprintf (header.source, sizeof (header.source), "%s", col->source);
+
+  fwrite (&header, sizeof (header), 1, fp);
+
+
+  offset = sizeof (COLUMNAR_HEADER) + col->fields->count * sizeof (COLUMNAR_COLUMN);
+
+  for (i = 0 ; i < col->fields->count ; i++)
+    {
+      offset = (offset + COLUMNAR_ALIGN - 1) & ~((uint64_t) COLUMNAR_ALIGN - 1);
+
+      memset (&column, 0, sizeof (column));
+      snprintf (column.name, sizeof (column.name), "%s", col->fields->field[i]->name);
+      column.type = col->fields->field[i]->type;
+      column.width = col->fields->field[i]->size;
+      column.offset = offset;
+      column.min = col->rows ? col->min[i] : 0.0;
+      column.max = col->rows ? col->max[i] : 0.0;
+
+      fwrite (&column, sizeof (column), 1, fp);
+
+      offset += col->rows * column.width;
+    }
+
+
+  /*  Copy the spooled columns into place.  */
+
+  memset (buffer, 0, COLUMNAR_ALIGN);
+  offset = sizeof (COLUMNAR_HEADER) + col->fields->count * sizeof (COLUMNAR_COLUMN);
+
+  for (i = 0 ; i < col->fields->count ; i++)
+    {
+      pad = ((offset + COLUMNAR_ALIGN - 1) & ~((uint64_t) COLUMNAR_ALIGN - 1)) - offset;
+
+      if (pad) fwrite (buffer, 1, pad, fp);
+      offset += pad;
+
+      columnar_spool (col, i);
+      rewind (col->spool[i]);
+
+      while ((size = fread (buffer, 1, sizeof (buffer), col->spool[i])) > 0)
+        {
+          if (fwrite (buffer, 1, size, fp) != size) status = -1;
+          offset += size;
+        }
+
+      memset (buffer, 0, COLUMNAR_ALIGN);
+    }
+
+
+  if (fclose (fp) || status)
+    {
+      perror (col->path);
+      status = -1;
+    }
+
+  columnar_abort (col);
+
+  return (status);
+}
+
+
+
+/*  Release the spool files and buffers without writing the output file.  */
+
+void columnar_abort (COLUMNAR_WRITER *col)
+{
+  int32_t            i;
+
+
+  for (i = 0 ; i < MAX_FIELDS ; i++)
+    {
+      if (col->spool[i] != NULL) fclose (col->spool[i]);
+      free (col->buffer[i]);
+
+      col->spool[i] = NULL;
+      col->buffer[i] = NULL;
+    }
+}
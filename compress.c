@@ -0,0 +1,450 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : compress.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --compress, gzip compressed standard output.
+ *
+ *               compress_start forks a compressor process and points stdout
+ *               at a pipe to it before any jobs are run, so everything that
+ *               would have gone to stdout (including the CHARTS library dump
+ *               text and the output of every worker, already in order) goes
+ *               through it.  The compressor cuts the stream into
+ *               COMPRESS_BLOCK byte blocks, compresses them on a pool of
+ *               threads, and writes each block as a separate gzip member in
+ *               the order it was read.  Concatenated members are a valid gzip
+ *               file (RFC 1952) that gunzip, zcat, and zlib read as one
+ *               stream.  Each block starts a new dictionary, which costs a
+ *               fraction of a percent against single threaded gzip.
+ *
+ *               The compressor is a separate process because the workers are
+ *               forked and forking a process that has threads running is
+ *               asking for trouble.  Not available on Windows.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+#ifndef NVWIN3X
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <zlib.h>
+#endif
+
+
+#define COMPRESS_BLOCK       (1024 * 1024)
+#define COMPRESS_MAX_THREADS 64
+
+#define BLOCK_EMPTY          0
+#define BLOCK_FILLED         1                   /*  waiting for a thread  */
+#define BLOCK_COMPRESSING    2
+#define BLOCK_DONE           3
+
+
+#ifndef NVWIN3X
+
+typedef struct
+{
+  int32_t            state;
+  int64_t            seq;
+  uint8_t            *in;
+  int32_t            in_size;
+  uint8_t            *out;
+  int32_t            out_size;
+  int32_t            status;                     /*  zlib status of the compression  */
+} COMPRESS_SLOT;
+
+
+typedef struct
+{
+  int32_t            level;
+  int32_t            num_blocks;
+  COMPRESS_SLOT      *block;
+  int32_t            out_max;
+  uint8_t            stop;
+
+  pthread_mutex_t    mutex;
+  pthread_cond_t     work;
+  pthread_cond_t     done;
+  pthread_cond_t     empty;
+} COMPRESSOR;
+
+
+static int32_t       compressor_pid = -1;
+
+
+
+/*  Read until size bytes have been read or the input ends.  */
+
+static int32_t full_read (int32_t fd, uint8_t *buffer, int32_t size)
+{
+  int32_t            done = 0;
+  ssize_t            n;
+
+
+  while (done < size)
+    {
+      if ((n = read (fd, buffer + done, size - done)) < 0)
+        {
+          if (errno == EINTR) continue;
+          return (-1);
+        }
+
+      if (!n) break;
+
+      done += n;
+    }
+
+  return (done);
+}
+
+
+
+static int32_t full_write (int32_t fd, uint8_t *buffer, int32_t size)
+{
+  int32_t            done = 0;
+  ssize_t            n;
+
+
+  while (done < size)
+    {
+      if ((n = write (fd, buffer + done, size - done)) < 0)
+        {
+          if (errno == EINTR) continue;
+          return (-1);
+        }
+
+      done += n;
+    }
+
+  return (0);
+}
+
+
+
+/*  Compress one block into a complete gzip member.  */
+
+static int32_t deflate_block (COMPRESSOR *comp, COMPRESS_SLOT *block)
+{
+  z_stream           stream;
+  int32_t            status;
+
+
+  memset (&stream, 0, sizeof (z_stream));
+
+  if ((status = deflateInit2 (&stream, comp->level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY)) != Z_OK) return (status);
+
+  stream.next_in = block->in;
+  stream.avail_in = block->in_size;
+  stream.next_out = block->out;
+  stream.avail_out = comp->out_max;
+
+  status = deflate (&stream, Z_FINISH);
+
+  block->out_size = comp->out_max - stream.avail_out;
+
+  deflateEnd (&stream);
+
+  return (status == Z_STREAM_END ? Z_OK : status);
+}
+
+
+
+static void *compress_thread (void *arg)
+{
+  COMPRESSOR         *comp = (COMPRESSOR *) arg;
+  COMPRESS_SLOT      *block;
+  int32_t            i;
+
+
+  pthread_mutex_lock (&comp->mutex);
+
+  while (1)
+    {
+      block = NULL;
+
+      for (i = 0 ; i < comp->num_blocks ; i++)
+        {
+          if (comp->block[i].state == BLOCK_FILLED && (block == NULL || comp->block[i].seq < block->seq)) block = &comp->block[i];
+        }
+
+      if (block == NULL)
+        {
+          if (comp->stop) break;
+
+          pthread_cond_wait (&comp->work, &comp->mutex);
+          continue;
+        }
+
+      block->state = BLOCK_COMPRESSING;
+
+      pthread_mutex_unlock (&comp->mutex);
+
+      block->status = deflate_block (comp, block);
+
+      pthread_mutex_lock (&comp->mutex);
+
+      block->state = BLOCK_DONE;
+      pthread_cond_broadcast (&comp->done);
+    }
+
+  pthread_mutex_unlock (&comp->mutex);
+
+  return (NULL);
+}
+
+
+
+/*  Writes the blocks to fd 1 in order as they finish.  */
+
+static void *write_thread (void *arg)
+{
+  COMPRESSOR         *comp = (COMPRESSOR *) arg;
+  COMPRESS_SLOT      *block;
+  int64_t            seq;
+  int32_t            failed = 0;
+
+
+  for (seq = 0 ; ; seq++)
+    {
+      block = &comp->block[seq % comp->num_blocks];
+
+      pthread_mutex_lock (&comp->mutex);
+
+      while (!(block->state == BLOCK_DONE && block->seq == seq) && !(comp->stop && block->state == BLOCK_EMPTY))
+        pthread_cond_wait (&comp->done, &comp->mutex);
+
+      if (block->state == BLOCK_EMPTY)
+        {
+          pthread_mutex_unlock (&comp->mutex);
+          break;
+        }
+
+      pthread_mutex_unlock (&comp->mutex);
+
+
+      if (!failed && block->status != Z_OK)
+        {
+          fprintf (stderr, "\nCompression failed, zlib error %d\n\n", block->status);
+          failed = 1;
+        }
+
+      if (!failed && full_write (1, block->out, block->out_size))
+        {
+          perror ("Writing compressed output");
+          failed = 1;
+        }
+
+
+      pthread_mutex_lock (&comp->mutex);
+
+      block->state = BLOCK_EMPTY;
+      pthread_cond_broadcast (&comp->empty);
+
+      pthread_mutex_unlock (&comp->mutex);
+    }
+
+  return (failed ? (void *) comp : NULL);
+}
+
+
+
+/*  The compressor process.  Reads fd 0 to the end and exits.  */
+
+static void compressor (int32_t level, int32_t num_threads)
+{
+  COMPRESSOR         comp;
+  COMPRESS_SLOT      *block;
+  pthread_t          thread[COMPRESS_MAX_THREADS], writer;
+  int32_t            i, size;
+  int64_t            seq, filled = 0;
+  void               *result;
+
+
+  comp.level = level;
+  comp.num_blocks = num_threads * 2;
+  comp.out_max = (int32_t) compressBound (COMPRESS_BLOCK) + 64;        /*  + the gzip header and trailer  */
+  comp.stop = NVFalse;
+
+  if ((comp.block = (COMPRESS_SLOT *) calloc (comp.num_blocks, sizeof (COMPRESS_SLOT))) == NULL)
+    {
+      perror ("Allocating compression memory");
+      _exit (1);
+    }
+
+  for (i = 0 ; i < comp.num_blocks ; i++)
+    {
+      comp.block[i].in = (uint8_t *) malloc (COMPRESS_BLOCK);
+      comp.block[i].out = (uint8_t *) malloc (comp.out_max);
+
+      if (comp.block[i].in == NULL || comp.block[i].out == NULL)
+        {
+          perror ("Allocating compression memory");
+          _exit (1);
+        }
+    }
+
+  pthread_mutex_init (&comp.mutex, NULL);
+  pthread_cond_init (&comp.work, NULL);
+  pthread_cond_init (&comp.done, NULL);
+  pthread_cond_init (&comp.empty, NULL);
+
+  for (i = 0 ; i < num_threads ; i++) pthread_create (&thread[i], NULL, compress_thread, &comp);
+  pthread_create (&writer, NULL, write_thread, &comp);
+
+
+  for (seq = 0 ; ; seq++)
+    {
+      block = &comp.block[seq % comp.num_blocks];
+
+      pthread_mutex_lock (&comp.mutex);
+      while (block->state != BLOCK_EMPTY) pthread_cond_wait (&comp.empty, &comp.mutex);
+      pthread_mutex_unlock (&comp.mutex);
+
+      if ((size = full_read (0, block->in, COMPRESS_BLOCK)) <= 0)
+        {
+          if (size < 0) perror ("Reading output to compress");
+          break;
+        }
+
+      pthread_mutex_lock (&comp.mutex);
+
+      block->in_size = size;
+      block->seq = seq;
+      block->state = BLOCK_FILLED;
+      pthread_cond_signal (&comp.work);
+      filled++;
+
+      pthread_mutex_unlock (&comp.mutex);
+
+      if (size < COMPRESS_BLOCK) break;
+    }
+
+
+  pthread_mutex_lock (&comp.mutex);
+
+  comp.stop = NVTrue;
+  pthread_cond_broadcast (&comp.work);
+  pthread_cond_broadcast (&comp.done);
+
+  pthread_mutex_unlock (&comp.mutex);
+
+  for (i = 0 ; i < num_threads ; i++) pthread_join (thread[i], NULL);
+  pthread_join (writer, &result);
+
+
+  /*  An empty stream is still a valid gzip file.  */
+
+  if (!filled && result == NULL)
+    {
+      comp.block[0].in_size = 0;
+      if ((comp.block[0].status = deflate_block (&comp, &comp.block[0])) != Z_OK || full_write (1, comp.block[0].out, comp.block[0].out_size))
+        result = &comp;
+    }
+
+  _exit (result == NULL ? 0 : 1);
+}
+
+#endif
+
+
+
+/*  Send stdout through a compressor process from here on.  level is the gzip level (1 - 9) and
+    num_threads the number of compression threads.  Returns 0 on success or -1 on error.  */
+
+int32_t compress_start (int32_t level, int32_t num_threads)
+{
+#ifdef NVWIN3X
+  fprintf (stderr, "\n--compress is not available on Windows\n\n");
+  return (-1);
+#else
+  int32_t            fd[2], pid;
+
+
+  if (num_threads > COMPRESS_MAX_THREADS) num_threads = COMPRESS_MAX_THREADS;
+
+  fflush (stdout);
+  fflush (stderr);
+
+  if (pipe (fd) < 0)
+    {
+      perror ("Creating compression pipe");
+      return (-1);
+    }
+
+  if ((pid = fork ()) < 0)
+    {
+      perror ("Starting compressor");
+      close (fd[0]);
+      close (fd[1]);
+      return (-1);
+    }
+
+
+  if (!pid)
+    {
+      dup2 (fd[0], 0);
+      close (fd[0]);
+      close (fd[1]);
+
+      compressor (level, num_threads);
+    }
+
+
+  dup2 (fd[1], 1);
+  close (fd[0]);
+  close (fd[1]);
+
+  compressor_pid = pid;
+
+  return (0);
+#endif
+}
+
+
+
+/*  Close stdout and wait for the compressor to write the rest.  Returns 0 on success or -1 if the
+    compressor failed.  */
+
+int32_t compress_finish ()
+{
+#ifndef NVWIN3X
+  int32_t            status;
+
+
+  if (compressor_pid < 0) return (0);
+
+  fflush (stdout);
+  close (1);
+
+  if (waitpid (compressor_pid, &status, 0) < 0 || !WIFEXITED (status) || WEXITSTATUS (status)) return (-1);
+
+  compressor_pid = -1;
+#endif
+
+  return (0);
+}
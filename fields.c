@@ -0,0 +1,248 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : fields.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Tables of the HYDRO_OUTPUT_T and TOPO_OUTPUT_T fields that can
+ *               be selected by name.  The storage type of each field is taken
+ *               from the structure definition at compile time so the tables
+ *               follow the CHARTS library headers.
+ *
+ ********************************************************************/
+
+#include <stddef.h>
+
+#include "charts_list.h"
+
+
+#define FIELD_TYPE(s, m) _Generic (((s *) 0)->m, \
+                                   int8_t: FIELD_INT8, uint8_t: FIELD_UINT8, \
+                                   int16_t: FIELD_INT16, uint16_t: FIELD_UINT16, \
+                                   int32_t: FIELD_INT32, uint32_t: FIELD_UINT32, \
+                                   int64_t: FIELD_INT64, uint64_t: FIELD_UINT64, \
+                                   float: FIELD_FLOAT, double: FIELD_DOUBLE)
+
+#define HOF_FIELD(m, p) {#m, (int32_t) offsetof (HYDRO_OUTPUT_T, m), FIELD_TYPE (HYDRO_OUTPUT_T, m), (int32_t) sizeof (((HYDRO_OUTPUT_T *) 0)->m), p}
+#define TOF_FIELD(m, p) {#m, (int32_t) offsetof (TOPO_OUTPUT_T, m), FIELD_TYPE (TOPO_OUTPUT_T, m), (int32_t) sizeof (((TOPO_OUTPUT_T *) 0)->m), p}
+
+
+/*  The last value is the number of decimal places used when the field is printed as text.
+    Positions use the -y precision, everything else the %.2f used for depths.  */
+
+static FIELD_DEF hof_fields[] =
+  {
+    HOF_FIELD (timestamp, 0),
+    HOF_FIELD (haps_version, 0),
+    HOF_FIELD (position_conf, 0),
+    HOF_FIELD (status, 0),
+    HOF_FIELD (suggested_dks, 0),
+    HOF_FIELD (suspect_status, 0),
+    HOF_FIELD (tide_status, 0),
+    HOF_FIELD (latitude, 11),
+    HOF_FIELD (longitude, 11),
+    HOF_FIELD (sec_latitude, 11),
+    HOF_FIELD (sec_longitude, 11),
+    HOF_FIELD (correct_depth, 2),
+    HOF_FIELD (correct_sec_depth, 2),
+    HOF_FIELD (abdc, 0),
+    HOF_FIELD (sec_abdc, 0),
+    HOF_FIELD (data_type, 0),
+    HOF_FIELD (land_mode, 0),
+    HOF_FIELD (classification_status, 0),
+    HOF_FIELD (wave_height, 2),
+    HOF_FIELD (elevation, 2),
+    HOF_FIELD (topo, 2),
+    HOF_FIELD (altitude, 2),
+    HOF_FIELD (kgps_topo, 2),
+    HOF_FIELD (kgps_datum, 2),
+    HOF_FIELD (kgps_water_level, 3),
+    HOF_FIELD (k, 2),
+    HOF_FIELD (intensity, 2),
+    HOF_FIELD (bot_conf, 0),
+    HOF_FIELD (sec_bot_conf, 0),
+    HOF_FIELD (nadir_angle, 2),
+    HOF_FIELD (scanner_azimuth, 2),
+    HOF_FIELD (sfc_fom_apd, 0),
+    HOF_FIELD (sfc_fom_ir, 0),
+    HOF_FIELD (sfc_fom_ram, 0),
+    HOF_FIELD (warnings, 0),
+    HOF_FIELD (warnings2, 0),
+    HOF_FIELD (warnings3, 0),
+    HOF_FIELD (tide_cor_depth, 2),
+    HOF_FIELD (reported_depth, 2),
+    HOF_FIELD (result_depth, 2)
+  };
+
+
+static FIELD_DEF tof_fields[] =
+  {
+    TOF_FIELD (timestamp, 0),
+    TOF_FIELD (latitude_first, 11),
+    TOF_FIELD (longitude_first, 11),
+    TOF_FIELD (elevation_first, 2),
+    TOF_FIELD (latitude_last, 11),
+    TOF_FIELD (longitude_last, 11),
+    TOF_FIELD (elevation_last, 2),
+    TOF_FIELD (altitude, 2),
+    TOF_FIELD (scanner_azimuth, 2),
+    TOF_FIELD (nadir_angle, 2)
+  };
+
+
+/*  Default columns when no list is given.  */
+
+static char *hof_default = "timestamp,latitude,longitude,correct_depth,abdc,data_type,kgps_water_level,tide_cor_depth";
+static char *tof_default = "timestamp,latitude_first,longitude_first,elevation_first,latitude_last,longitude_last,elevation_last";
+
+
+
+/*  Look up a field by name in the table for type (0 = HOF, 1 = TOF).  */
+
+FIELD_DEF *field_lookup (int32_t type, char *name)
+{
+  FIELD_DEF          *table;
+  int32_t            i, count;
+
+
+  if (type)
+    {
+      table = tof_fields;
+      count = sizeof (tof_fields) / sizeof (FIELD_DEF);
+    }
+  else
+    {
+      table = hof_fields;
+      count = sizeof (hof_fields) / sizeof (FIELD_DEF);
+    }
+
+  for (i = 0 ; i < count ; i++)
+    {
+      if (!strcmp (table[i].name, name)) return (&table[i]);
+    }
+
+  return (NULL);
+}
+
+
+
+/*  Resolve a comma separated list of field names (NULL for the defaults) for type.  On an unknown
+    name, set->count is set to -1 and set->bad holds the offending name.  */
+
+void field_set_parse (FIELD_SET *set, int32_t type, char *list)
+{
+  char               string[1024], *name, *save = NULL;
+
+
+  set->count = 0;
+  set->bad[0] = 0;
+
+  if (list == NULL) list = type ? tof_default : hof_default;
+
+  strncpy (string, list, sizeof (string) - 1);
+  string[sizeof (string) - 1] = 0;
+
+
+  for (name = strtok_r (string, ",", &save) ; name != NULL ; name = strtok_r (NULL, ",", &save))
+    {
+      if (set->count == MAX_FIELDS) break;
+
+      if ((set->field[set->count] = field_lookup (type, name)) == NULL)
+        {
+          strncpy (set->bad, name, sizeof (set->bad) - 1);
+          set->bad[sizeof (set->bad) - 1] = 0;
+          set->count = -1;
+          return;
+        }
+
+      set->count++;
+    }
+}
+
+
+
+/*  Return a field of record as a double.  */
+
+double field_value (void *record, FIELD_DEF *field)
+{
+  uint8_t            *ptr = (uint8_t *) record + field->offset;
+  int8_t             i8;
+  uint8_t            u8;
+  int16_t            i16;
+  uint16_t           u16;
+  int32_t            i32;
+  uint32_t           u32;
+  int64_t            i64;
+  uint64_t           u64;
+  float              f32;
+  double             f64;
+
+
+  switch (field->type)
+    {
+    case FIELD_INT8:
+      memcpy (&i8, ptr, 1);
+      return ((double) i8);
+
+    case FIELD_UINT8:
+      memcpy (&u8, ptr, 1);
+      return ((double) u8);
+
+    case FIELD_INT16:
+      memcpy (&i16, ptr, 2);
+      return ((double) i16);
+
+    case FIELD_UINT16:
+      memcpy (&u16, ptr, 2);
+      return ((double) u16);
+
+    case FIELD_INT32:
+      memcpy (&i32, ptr, 4);
+      return ((double) i32);
+
+    case FIELD_UINT32:
+      memcpy (&u32, ptr, 4);
+      return ((double) u32);
+
+    case FIELD_INT64:
+      memcpy (&i64, ptr, 8);
+      return ((double) i64);
+
+    case FIELD_UINT64:
+      memcpy (&u64, ptr, 8);
+      return ((double) u64);
+
+    case FIELD_FLOAT:
+      memcpy (&f32, ptr, 4);
+      return ((double) f32);
+
+    case FIELD_DOUBLE:
+      memcpy (&f64, ptr, 8);
+      return (f64);
+    }
+
+  return (0.0);
+}
@@ -0,0 +1,331 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : file_cache.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Keeps HOF, TOF, and waveform files open between --server
+ *               requests, along with their headers and record readers (the
+ *               mapping or the library file position).
+ *
+ *               process_file opens and closes its files through these
+ *               functions.  Until file_cache_init is called with a size they
+ *               just call the CHARTS library and record_reader.c, so nothing
+ *               changes outside of server mode.  With a cache, closing a file
+ *               keeps it open and the next open of the same path gets it back
+ *               as long as the file hasn't changed on disk (same inode, size,
+ *               and modification time).  When the cache is full the least
+ *               recently used file that isn't in use is closed.  If every
+ *               file is in use the new file isn't cached.
+ *
+ ********************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "charts_list.h"
+
+
+typedef struct
+{
+  char               *path;                      /*  NULL for an empty entry  */
+  int32_t            type;                       /*  FILE_CACHE_HOF, FILE_CACHE_TOF, or FILE_CACHE_WAVE  */
+  FILE               *fp;
+  ino_t              inode;
+  off_t              size;
+  time_t             mtime;
+  int64_t            mtime_ns;                   /*  nanoseconds part of the modification time (0 where there isn't one)  */
+  int64_t            last_used;
+  int32_t            in_use;
+  uint8_t            have_header;
+  HOF_HEADER_T       hof_header;
+  WAVE_HEADER_T      wave_header;
+  uint8_t            have_reader;
+  RECORD_READER      reader;
+} FILE_CACHE_ENTRY;
+
+
+static FILE_CACHE_ENTRY *entry = NULL;
+static int32_t       num_entries = 0;
+static int64_t       use_count = 0;
+
+
+
+/*  Keep up to max_files files open.  0 turns the cache off.  */
+
+void file_cache_init (int32_t max_files)
+{
+  file_cache_free ();
+
+  if (max_files <= 0) return;
+
+  if ((entry = (FILE_CACHE_ENTRY *) calloc (max_files, sizeof (FILE_CACHE_ENTRY))) == NULL)
+    {
+      perror ("Allocating file cache memory");
+      exit (-1);
+    }
+
+  num_entries = max_files;
+}
+
+
+
+static void evict (FILE_CACHE_ENTRY *e)
+{
+  if (e->have_reader) reader_close (&e->reader);
+
+  fclose (e->fp);
+  free (e->path);
+
+  memset (e, 0, sizeof (FILE_CACHE_ENTRY));
+}
+
+
+
+void file_cache_free ()
+{
+  int32_t            i;
+
+
+  for (i = 0 ; i < num_entries ; i++) if (entry[i].path != NULL) evict (&entry[i]);
+
+  free (entry);
+
+  entry = NULL;
+  num_entries = 0;
+}
+
+
+
+static FILE_CACHE_ENTRY *find_fp (FILE *fp)
+{
+  int32_t            i;
+
+
+  for (i = 0 ; i < num_entries ; i++) if (entry[i].path != NULL && entry[i].fp == fp) return (&entry[i]);
+
+  return (NULL);
+}
+
+
+
+static FILE *library_open (char *file, int32_t type)
+{
+  switch (type)
+    {
+    case FILE_CACHE_HOF:
+      return (open_hof_file (file));
+
+    case FILE_CACHE_TOF:
+      return (open_tof_file (file));
+    }
+
+  return (open_wave_file (file));
+}
+
+
+
+/*  Open file with the CHARTS library (type FILE_CACHE_HOF, FILE_CACHE_TOF, or FILE_CACHE_WAVE) or
+    get it from the cache.  Returns NULL if it can't be opened.  */
+
+FILE *file_cache_open (char *file, int32_t type)
+{
+  FILE_CACHE_ENTRY   *e, *lru = NULL;
+  struct stat        st;
+  FILE               *fp;
+  int64_t            mtime_ns;
+  int32_t            i;
+
+
+  if (!num_entries) return (library_open (file, type));
+
+  if (stat (file, &st)) return (NULL);
+
+#if defined (NVWIN3X)
+  mtime_ns = 0;
+#elif defined (__APPLE__)
+  mtime_ns = (int64_t) st.st_mtimespec.tv_nsec;
+#else
+  mtime_ns = (int64_t) st.st_mtim.tv_nsec;
+#endif
+
+
+  for (i = 0 ; i < num_entries ; i++)
+    {
+      e = &entry[i];
+
+      if (e->path != NULL && e->type == type && !strcmp (e->path, file))
+        {
+          if (e->inode == st.st_ino && e->size == st.st_size && e->mtime == st.st_mtime && e->mtime_ns == mtime_ns)
+            {
+              e->last_used = ++use_count;
+              e->in_use++;
+              return (e->fp);
+            }
+
+          if (e->in_use) return (library_open (file, type));
+
+          evict (e);
+          break;
+        }
+    }
+
+
+  if ((fp = library_open (file, type)) == NULL) return (NULL);
+
+  for (i = 0 ; i < num_entries ; i++)
+    {
+      e = &entry[i];
+
+      if (e->path == NULL)
+        {
+          lru = e;
+          break;
+        }
+
+      if (!e->in_use && (lru == NULL || e->last_used < lru->last_used)) lru = e;
+    }
+
+  if (lru == NULL) return (fp);
+
+  if (lru->path != NULL) evict (lru);
+
+  if ((lru->path = strdup (file)) == NULL)
+    {
+      perror ("Allocating file cache memory");
+      exit (-1);
+    }
+
+  lru->type = type;
+  lru->fp = fp;
+  lru->inode = st.st_ino;
+  lru->size = st.st_size;
+  lru->mtime = st.st_mtime;
+  lru->mtime_ns = mtime_ns;
+  lru->last_used = ++use_count;
+  lru->in_use = 1;
+
+  return (fp);
+}
+
+
+
+/*  Done with a file from file_cache_open.  */
+
+void file_cache_close (FILE *fp)
+{
+  FILE_CACHE_ENTRY   *e;
+
+
+  if ((e = find_fp (fp)) == NULL)
+    {
+      fclose (fp);
+      return;
+    }
+
+  e->in_use--;
+}
+
+
+
+void file_cache_hof_header (FILE *fp, HOF_HEADER_T *header)
+{
+  FILE_CACHE_ENTRY   *e;
+
+
+  if ((e = find_fp (fp)) == NULL)
+    {
+      hof_read_header (fp, header);
+      return;
+    }
+
+  if (!e->have_header)
+    {
+      hof_read_header (fp, &e->hof_header);
+      e->have_header = NVTrue;
+    }
+
+  *header = e->hof_header;
+}
+
+
+
+void file_cache_wave_header (FILE *fp, WAVE_HEADER_T *header)
+{
+  FILE_CACHE_ENTRY   *e;
+
+
+  if ((e = find_fp (fp)) == NULL)
+    {
+      wave_read_header (fp, header);
+      return;
+    }
+
+  if (!e->have_header)
+    {
+      wave_read_header (fp, &e->wave_header);
+      e->have_header = NVTrue;
+    }
+
+  *header = e->wave_header;
+}
+
+
+
+/*  reader_open and reader_close for a file from file_cache_open.  A cached file keeps its reader
+    between uses, including where the library's sequential reads left off.  Prefetch readers
+    aren't kept.  */
+
+void file_cache_reader_open (RECORD_READER *reader, FILE *fp, char *file, int32_t type, int32_t num_records, uint8_t use_library)
+{
+  FILE_CACHE_ENTRY   *e;
+
+
+  if ((e = find_fp (fp)) != NULL && e->have_reader)
+    {
+      *reader = e->reader;
+      return;
+    }
+
+  reader_open (reader, fp, file, type, num_records, use_library);
+}
+
+
+
+void file_cache_reader_close (RECORD_READER *reader)
+{
+  FILE_CACHE_ENTRY   *e;
+
+
+  if ((e = find_fp (reader->fp)) == NULL || reader->prefetch != NULL)
+    {
+      reader_close (reader);
+      return;
+    }
+
+  e->reader = *reader;
+  e->have_reader = NVTrue;
+}
@@ -0,0 +1,221 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : file_list.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Builds the list of input files for batch mode.  Files are kept
+ *               in the order they were given.  Directories are searched
+ *               recursively and their .hof/.tof files are added in sorted
+ *               name order so that the output order does not depend on the
+ *               order the file system returns directory entries.
+ *
+ ********************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+#include "charts_list.h"
+
+
+void file_list_init (FILE_LIST *list)
+{
+  list->name = NULL;
+  list->count = 0;
+  list->size = 0;
+}
+
+
+
+static void file_list_append (FILE_LIST *list, char *path)
+{
+  if (list->count == list->size)
+    {
+      list->size = list->size ? list->size * 2 : 64;
+
+      list->name = (char **) realloc (list->name, list->size * sizeof (char *));
+
+      if (list->name == NULL)
+        {
+          perror ("Allocating file list memory");
+          exit (-1);
+        }
+    }
+
+  list->name[list->count] = strdup (path);
+  list->count++;
+}
+
+
+
+static int32_t compare_names (const void *a, const void *b)
+{
+  return (strcmp (*(char * const *) a, *(char * const *) b));
+}
+
+
+
+static uint8_t wanted_file (char *name, uint8_t hof_only)
+{
+  int32_t            len = strlen (name);
+
+
+  if (len < 4) return (NVFalse);
+
+  if (!strcmp (&name[len - 4], ".hof")) return (NVTrue);
+
+  if (!hof_only && !strcmp (&name[len - 4], ".tof")) return (NVTrue);
+
+  return (NVFalse);
+}
+
+
+
+static int32_t file_list_scan (FILE_LIST *list, char *dir_name, uint8_t hof_only)
+{
+  DIR                *dir;
+  struct dirent      *entry;
+  struct stat        st;
+  FILE_LIST          entries;
+  char               path[1024];
+  int32_t            i;
+
+
+  if ((dir = opendir (dir_name)) == NULL)
+    {
+      perror (dir_name);
+      return (-1);
+    }
+
+
+  file_list_init (&entries);
+
+  while ((entry = readdir (dir)) != NULL)
+    {
+      if (!strcmp (entry->d_name, ".") || !strcmp (entry->d_name, "..")) continue;
+
+      snprintf (path, sizeof (path), "%s/%s", dir_name, entry->d_name);
+
+      file_list_append (&entries, path);
+    }
+
+  closedir (dir);
+
+
+  qsort (entries.name, entries.count, sizeof (char *), compare_names);
+
+
+  for (i = 0 ; i < entries.count ; i++)
+    {
+      if (stat (entries.name[i], &st)) continue;
+
+      if (S_ISDIR (st.st_mode))
+        {
+          file_list_scan (list, entries.name[i], hof_only);
+        }
+      else if (wanted_file (entries.name[i], hof_only))
+        {
+          file_list_append (list, entries.name[i]);
+        }
+    }
+
+  file_list_free (&entries);
+
+
+  return (0);
+}
+
+
+
+/*  Add a file or, if path is a directory, every .hof (and .tof unless hof_only is set) file below it.  */
+
+int32_t file_list_add (FILE_LIST *list, char *path, uint8_t hof_only)
+{
+  struct stat        st;
+
+
+  if (!stat (path, &st) && S_ISDIR (st.st_mode)) return (file_list_scan (list, path, hof_only));
+
+
+  /*  Plain files are passed through as given.  Unknown extensions are reported when the file is processed.  */
+
+  file_list_append (list, path);
+
+  return (0);
+}
+
+
+
+/*  Read file or directory names, one per line, from list_file ("-" for stdin).  */
+
+int32_t file_list_read (FILE_LIST *list, char *list_file, uint8_t hof_only)
+{
+  FILE               *fp;
+  char               string[1024];
+  int32_t            len;
+
+
+  if (!strcmp (list_file, "-"))
+    {
+      fp = stdin;
+    }
+  else if ((fp = fopen (list_file, "r")) == NULL)
+    {
+      perror (list_file);
+      return (-1);
+    }
+
+
+  while (fgets (string, sizeof (string), fp))
+    {
+      len = strlen (string);
+      while (len && (string[len - 1] == '\n' || string[len - 1] == '\r' || string[len - 1] == ' ')) string[--len] = 0;
+
+      if (!len || string[0] == '#') continue;
+
+      file_list_add (list, string, hof_only);
+    }
+
+
+  if (fp != stdin) fclose (fp);
+
+  return (0);
+}
+
+
+
+void file_list_free (FILE_LIST *list)
+{
+  int32_t            i;
+
+
+  for (i = 0 ; i < list->count ; i++) free (list->name[i]);
+
+  free (list->name);
+
+  file_list_init (list);
+}
@@ -0,0 +1,447 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : filter.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --bbox, --polygon, --time, and --radius record filters.
+ *
+ *               HOF and TOF timestamps increase through the file so a time
+ *               window is turned into a record range with a binary search
+ *               before the file is read (filter_time_range).  When the file
+ *               has a current summary sidecar (see summary.c) whole blocks
+ *               whose time or position bounds miss the filter are skipped
+ *               without being read (filter_span).  Every record that is read
+ *               is still checked individually (filter_record), a batch at a
+ *               time so that --radius distances go through the batched
+ *               distance kernel (filter_batch).
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+
+void filter_init (RECORD_FILTER *filter)
+{
+  memset (filter, 0, sizeof (RECORD_FILTER));
+
+  filter->min_lat = filter->min_lon = -1.0e300;
+  filter->max_lat = filter->max_lon = 1.0e300;
+  filter->start_time = INT64_MIN;
+  filter->end_time = INT64_MAX;
+}
+
+
+
+/*  Shrink the position envelope to the intersection with the given bounds.  */
+
+static void filter_envelope (RECORD_FILTER *filter, double min_lat, double min_lon, double max_lat, double max_lon)
+{
+  if (min_lat > filter->min_lat) filter->min_lat = min_lat;
+  if (min_lon > filter->min_lon) filter->min_lon = min_lon;
+  if (max_lat < filter->max_lat) filter->max_lat = max_lat;
+  if (max_lon < filter->max_lon) filter->max_lon = max_lon;
+
+  filter->area = NVTrue;
+  filter->active = NVTrue;
+}
+
+
+
+/*  --bbox "min_lat,min_lon,max_lat,max_lon".  Returns 0 on success or -1 on error.  */
+
+int32_t filter_parse_bbox (RECORD_FILTER *filter, char *string)
+{
+  double             min_lat, min_lon, max_lat, max_lon;
+
+
+  if (sscanf (string, "%lf,%lf,%lf,%lf", &min_lat, &min_lon, &max_lat, &max_lon) != 4 || min_lat > max_lat || min_lon > max_lon)
+    {
+      fprintf (stderr, "\nBad bounding box %s (min_lat,min_lon,max_lat,max_lon)\n\n", string);
+      return (-1);
+    }
+
+  filter_envelope (filter, min_lat, min_lon, max_lat, max_lon);
+
+  return (0);
+}
+
+
+
+/*  --polygon FILE.  One lat,lon vertex per line, # starts a comment.  The polygon is closed
+    automatically.  Returns 0 on success or -1 on error.  */
+
+int32_t filter_read_polygon (RECORD_FILTER *filter, char *file)
+{
+  FILE               *fp;
+  char               string[1024];
+  double             lat, lon, min_lat = 1.0e300, min_lon = 1.0e300, max_lat = -1.0e300, max_lon = -1.0e300;
+  int32_t            size = 0;
+
+
+  if ((fp = fopen (file, "r")) == NULL)
+    {
+      perror (file);
+      return (-1);
+    }
+
+
+  while (fgets (string, sizeof (string), fp) != NULL)
+    {
+      if (string[0] == '#' || sscanf (string, "%lf%*[ ,\t]%lf", &lat, &lon) != 2) continue;
+
+      if (filter->poly_count == size)
+        {
+          size = size ? size * 2 : 64;
+
+          if ((filter->poly_lat = (double *) realloc (filter->poly_lat, size * sizeof (double))) == NULL ||
+              (filter->poly_lon = (double *) realloc (filter->poly_lon, size * sizeof (double))) == NULL)
+            {
+              perror ("Allocating polygon memory");
+              exit (-1);
+            }
+        }
+
+      filter->poly_lat[filter->poly_count] = lat;
+      filter->poly_lon[filter->poly_count] = lon;
+      filter->poly_count++;
+
+      if (lat < min_lat) min_lat = lat;
+      if (lat > max_lat) max_lat = lat;
+      if (lon < min_lon) min_lon = lon;
+      if (lon > max_lon) max_lon = lon;
+    }
+
+  fclose (fp);
+
+
+  if (filter->poly_count < 3)
+    {
+      fprintf (stderr, "\nPolygon file %s must have at least 3 vertices\n\n", file);
+      return (-1);
+    }
+
+  filter_envelope (filter, min_lat, min_lon, max_lat, max_lon);
+
+  return (0);
+}
+
+
+
+/*  A time is either a raw CHARTS timestamp (microseconds from 01/01/1970) or YYYY-DDD-HH:MM:SS.SS.  */
+
+static int32_t parse_time (char *string, int64_t *timestamp)
+{
+  int32_t            year, jday, hour, minute;
+  float              second;
+  time_t             tv_sec;
+  long               tv_nsec;
+  long long          value;
+
+
+  if (sscanf (string, "%d%*[-/ ]%d%*[-/ ]%d:%d:%f", &year, &jday, &hour, &minute, &second) == 5)
+    {
+      inv_cvtime (year - 1900, jday, hour, minute, second, &tv_sec, &tv_nsec);
+
+      *timestamp = (int64_t) tv_sec * 1000000 + (int64_t) (tv_nsec / 1000);
+
+      return (0);
+    }
+
+  if (!strchr (string, ':') && sscanf (string, "%lld", &value) == 1)
+    {
+      *timestamp = (int64_t) value;
+
+      return (0);
+    }
+
+  return (-1);
+}
+
+
+
+/*  --time "START,END".  Returns 0 on success or -1 on error.  */
+
+int32_t filter_parse_time (RECORD_FILTER *filter, char *string)
+{
+  char               start[256], *end;
+
+
+  strncpy (start, string, sizeof (start) - 1);
+  start[sizeof (start) - 1] = 0;
+
+  if ((end = strchr (start, ',')) == NULL)
+    {
+      fprintf (stderr, "\nBad time window %s (START,END)\n\n", string);
+      return (-1);
+    }
+
+  *end++ = 0;
+
+  if (parse_time (start, &filter->start_time) || parse_time (end, &filter->end_time) || filter->start_time > filter->end_time)
+    {
+      fprintf (stderr, "\nBad time window %s (START,END)\n\n", string);
+      return (-1);
+    }
+
+  filter->time = NVTrue;
+  filter->active = NVTrue;
+
+  return (0);
+}
+
+
+
+/*  --radius METERS around lat, lon (degrees, the -g position).  The bounding box is narrowed to a
+    box that is sure to hold the circle so that blocks can be skipped.  */
+
+void filter_set_radius (RECORD_FILTER *filter, double lat, double lon, double meters)
+{
+  double             dlat, dlon, max_lat, min_lon = -1.0e300, max_lon = 1.0e300;
+
+
+  filter->radius = NVTrue;
+  filter->max_distance = meters;
+
+  geo_distance_init (&filter->center, lat, lon);
+
+
+  /*  A degree of latitude is at least 110574 meters and a degree of longitude at least
+      111319.49 * cos (lat) meters.  */
+
+  dlat = meters / 110574.0 * 1.001;
+
+  if (lat + dlat < 90.0 && lat - dlat > -90.0)
+    {
+      max_lat = fabs (lat) + dlat;
+      dlon = meters / (111319.49 * cos (max_lat * M_PI / 180.0)) * 1.001;
+
+      if (lon - dlon > -180.0 && lon + dlon < 180.0)
+        {
+          min_lon = lon - dlon;
+          max_lon = lon + dlon;
+        }
+    }
+
+  filter_envelope (filter, lat - dlat, min_lon, lat + dlat, max_lon);
+}
+
+
+
+void filter_free (RECORD_FILTER *filter)
+{
+  free (filter->poly_lat);
+  free (filter->poly_lon);
+
+  filter->poly_lat = filter->poly_lon = NULL;
+  filter->poly_count = 0;
+}
+
+
+
+/*  Even-odd point in polygon test.  */
+
+static uint8_t inside_polygon (RECORD_FILTER *filter, double lat, double lon)
+{
+  int32_t            i, j;
+  uint8_t            inside = NVFalse;
+
+
+  for (i = 0, j = filter->poly_count - 1 ; i < filter->poly_count ; j = i++)
+    {
+      if ((filter->poly_lat[i] > lat) != (filter->poly_lat[j] > lat) &&
+          lon < (filter->poly_lon[j] - filter->poly_lon[i]) * (lat - filter->poly_lat[i]) / (filter->poly_lat[j] - filter->poly_lat[i]) +
+          filter->poly_lon[i])
+        inside = !inside;
+    }
+
+  return (inside);
+}
+
+
+
+/*  Returns NVTrue if a record with this timestamp and position passes the filter.  */
+
+uint8_t filter_record (RECORD_FILTER *filter, int64_t timestamp, double lat, double lon)
+{
+  if (timestamp < filter->start_time || timestamp > filter->end_time) return (NVFalse);
+
+  if (filter->area)
+    {
+      if (lat < filter->min_lat || lat > filter->max_lat || lon < filter->min_lon || lon > filter->max_lon) return (NVFalse);
+
+      if (filter->poly_count && !inside_polygon (filter, lat, lon)) return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+/*  Set pass[k] for each of count HYDRO_OUTPUT_T (type 0) or TOPO_OUTPUT_T (type 1) records.  */
+
+void filter_batch (RECORD_FILTER *filter, int32_t type, void *records, int32_t count, uint8_t *pass)
+{
+  HYDRO_OUTPUT_T     *hof = (HYDRO_OUTPUT_T *) records;
+  TOPO_OUTPUT_T      *tof = (TOPO_OUTPUT_T *) records;
+  double             lat[GEO_BATCH], lon[GEO_BATCH];
+  int32_t            start, n, k, rejected = 0;
+  STAT_TIMER         timer = stats_start ();
+
+
+  for (start = 0 ; start < count ; start += GEO_BATCH)
+    {
+      n = count - start;
+      if (n > GEO_BATCH) n = GEO_BATCH;
+
+      for (k = 0 ; k < n ; k++)
+        {
+          if (type)
+            {
+              lat[k] = tof[start + k].latitude_last;
+              lon[k] = tof[start + k].longitude_last;
+              pass[start + k] = filter_record (filter, tof[start + k].timestamp, lat[k], lon[k]);
+            }
+          else
+            {
+              lat[k] = hof[start + k].latitude;
+              lon[k] = hof[start + k].longitude;
+              pass[start + k] = filter_record (filter, hof[start + k].timestamp, lat[k], lon[k]);
+            }
+        }
+
+      if (filter->radius) geo_within_batch (&filter->center, lat, lon, filter->max_distance, &pass[start], n);
+    }
+
+  for (k = 0 ; k < count ; k++) rejected += !pass[k];
+
+  stats_count (STAT_REJECTED_FILTER, rejected);
+  stats_stop (STAT_FILTER, timer);
+}
+
+
+
+/*  Narrow *first through *last (1 based) to the records inside the time window.  The records
+    must be in time order, which HOF and TOF files always are.  *first is greater than *last if
+    no records are in the window.  */
+
+void filter_time_range (RECORD_FILTER *filter, RECORD_READER *reader, int32_t *first, int32_t *last)
+{
+  union
+  {
+    HYDRO_OUTPUT_T   hof;
+    TOPO_OUTPUT_T    tof;
+  } record;
+  int32_t            low, high, mid, before = *last - *first + 1;
+  int64_t            timestamp;
+  STAT_TIMER         timer = stats_start ();
+
+
+  /*  First record at or after the start time.  */
+
+  low = *first;
+  high = *last + 1;
+
+  while (low < high)
+    {
+      mid = low + (high - low) / 2;
+
+      if (!reader_read (reader, mid, 1, &record)) break;
+      timestamp = reader->type ? record.tof.timestamp : record.hof.timestamp;
+
+      if (timestamp < filter->start_time)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+
+  *first = low;
+
+
+  /*  Last record at or before the end time.  */
+
+  high = *last + 1;
+
+  while (low < high)
+    {
+      mid = low + (high - low) / 2;
+
+      if (!reader_read (reader, mid, 1, &record)) break;
+      timestamp = reader->type ? record.tof.timestamp : record.hof.timestamp;
+
+      if (timestamp <= filter->end_time)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+
+  *last = low - 1;
+
+  stats_count (STAT_REJECTED_FILTER, before - (*last >= *first ? *last - *first + 1 : 0));
+  stats_stop (STAT_FILTER, timer);
+}
+
+
+
+/*  Decide what to do with the next count records starting at record index start (0 based) using
+    the block bounds from a summary sidecar.  Returns the number of records to read (never crossing
+    a block boundary) or minus the number of records that can be skipped because their block can't
+    contain anything that passes the filter.  */
+
+int32_t filter_span (RECORD_FILTER *filter, SUMMARY *summary, int32_t start, int32_t count)
+{
+  SUMMARY_BLOCK      *block;
+  int32_t            b, left;
+
+
+  b = start / SUMMARY_BLOCK_SIZE;
+
+  if (b >= summary->header.num_blocks) return (count);
+
+  left = (b + 1) * SUMMARY_BLOCK_SIZE - start;
+  if (left < count) count = left;
+
+  block = &summary->block[b];
+
+  if (block->max_time < filter->start_time || block->min_time > filter->end_time ||
+      (filter->area && (block->max_lat < filter->min_lat || block->min_lat > filter->max_lat ||
+                        block->max_lon < filter->min_lon || block->min_lon > filter->max_lon)))
+    {
+      stats_count (STAT_REJECTED_FILTER, count);
+      return (-count);
+    }
+
+  return (count);
+}
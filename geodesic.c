@@ -0,0 +1,277 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : geodesic.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Ellipsoidal distances from a fixed reference point.
+ *
+ *               The kernel is the NGS inverse solution (T. Vincenty's
+ *               modification of Rainsford's method with Helmert's elliptical
+ *               terms) with the azimuth computation removed and the reference
+ *               point terms computed once in geo_distance_init.  It works on
+ *               GEO_BATCH positions at a time, iterating all of them in lock
+ *               step.  The loops call the scalar libm tan, sin, cos, and atan2
+ *               for every position, so the compiler doesn't vectorize them;
+ *               the saving over invgp is the reference terms and the azimuth.
+ *               Positions that haven't converged after GEO_MAX_ITERATIONS
+ *               (nearly antipodal) and positions at the poles are handed to
+ *               invgp.
+ *
+ *               geo_within_batch is for --radius.  Any position within
+ *               GEO_CHECK_TOLERANCE of the radius is redone with invgp, so
+ *               records pass or fail exactly as they would with invgp.
+ *
+ *               geo_distance is for the -g distances, one sample at a time as
+ *               they're written.  They're printed to the millimeter, and any
+ *               distance within GEO_CHECK_TOLERANCE of a rounding boundary is
+ *               redone with invgp, so the output is the same to the last digit
+ *               as it's always been.
+ *
+ *               geo_distance_init compares the kernel with invgp for a ring
+ *               of test points around the reference point and uses invgp for
+ *               everything if they disagree by more than GEO_CHECK_TOLERANCE.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+#define GEO_MAX_ITERATIONS   50
+#define GEO_EPS              0.5e-13
+#define GEO_CHECK_TOLERANCE  1.0e-6                              /*  meters  */
+
+
+
+static void distance_batch (GEO_REFERENCE *ref, const double *lat, const double *lon, double *dist, int32_t count);
+
+
+
+/*  Set up the reference point (degrees).  */
+
+void geo_distance_init (GEO_REFERENCE *ref, double lat, double lon)
+{
+  static double      offset[] = {0.0001, 0.001, 0.01, 0.1, 0.5, 1.0, 3.0};
+  double             tu1, d2r = M_PI / 180.0, test_lat[56], test_lon[56], dist[56], check, az, diff, max_diff = 0.0;
+  int32_t            i, j, n = 0;
+
+
+  ref->lat = lat;
+  ref->lon = lon;
+  ref->a = NV_A0;
+  ref->f = (NV_A0 - NV_B0) / NV_A0;
+  ref->r = 1.0 - ref->f;
+  ref->lon_rad = lon * d2r;
+
+  tu1 = ref->r * tan (lat * d2r);
+  ref->cu1 = 1.0 / sqrt (tu1 * tu1 + 1.0);
+  ref->su1 = ref->cu1 * tu1;
+  ref->tu1 = tu1;
+
+  ref->use_invgp = (fabs (lat) > 89.999999);
+
+
+  /*  Check the kernel against invgp.  */
+
+  for (i = 0 ; i < (int32_t) (sizeof (offset) / sizeof (double)) ; i++)
+    {
+      for (j = 0 ; j < 8 ; j++)
+        {
+          test_lat[n] = lat + offset[i] * cos (j * M_PI / 4.0);
+          test_lon[n] = lon + offset[i] * sin (j * M_PI / 4.0);
+
+          if (test_lat[n] > 89.0) test_lat[n] = 89.0;
+          if (test_lat[n] < -89.0) test_lat[n] = -89.0;
+
+          n++;
+        }
+    }
+
+  distance_batch (ref, test_lat, test_lon, dist, n);
+
+  for (i = 0 ; i < n ; i++)
+    {
+      invgp (NV_A0, NV_B0, lat, lon, test_lat[i], test_lon[i], &check, &az);
+
+      diff = fabs (dist[i] - check);
+      if (!(diff <= max_diff)) max_diff = diff;
+    }
+
+  if (!(max_diff <= GEO_CHECK_TOLERANCE))
+    {
+      fprintf (stderr, "\nDistance kernel differs from invgp by %g meters, using invgp\n\n", max_diff);
+      ref->use_invgp = NVTrue;
+    }
+}
+
+
+
+static void distance_batch (GEO_REFERENCE *ref, const double *lat, const double *lon, double *dist, int32_t count)
+{
+  double             s[GEO_BATCH], baz[GEO_BATCH], faz[GEO_BATCH], cu2[GEO_BATCH], dlon[GEO_BATCH], x[GEO_BATCH];
+  double             sy[GEO_BATCH], cy[GEO_BATCH], y[GEO_BATCH], c2a[GEO_BATCH], cz[GEO_BATCH], e[GEO_BATCH], delta[GEO_BATCH];
+  double             tu2, sx, cx, t1, t2, sa, c, d, xx, ss, d2r = M_PI / 180.0, f = ref->f, r = ref->r, max_delta, az;
+  int32_t            start, n, k, iter;
+
+
+  if (ref->use_invgp)
+    {
+      for (k = 0 ; k < count ; k++) invgp (NV_A0, NV_B0, ref->lat, ref->lon, lat[k], lon[k], &dist[k], &az);
+      return;
+    }
+
+
+  for (start = 0 ; start < count ; start += GEO_BATCH)
+    {
+      n = count - start;
+      if (n > GEO_BATCH) n = GEO_BATCH;
+
+
+      /*  Terms that only depend on the second point.  */
+
+      for (k = 0 ; k < n ; k++)
+        {
+          tu2 = r * tan (lat[start + k] * d2r);
+          cu2[k] = 1.0 / sqrt (tu2 * tu2 + 1.0);
+          s[k] = ref->cu1 * cu2[k];
+          baz[k] = s[k] * tu2;
+          faz[k] = baz[k] * ref->tu1;
+          dlon[k] = lon[start + k] * d2r - ref->lon_rad;
+          x[k] = dlon[k];
+        }
+
+
+      /*  Iterate every position until the slowest one converges.  */
+
+      for (iter = 0 ; iter < GEO_MAX_ITERATIONS ; iter++)
+        {
+          max_delta = 0.0;
+
+          for (k = 0 ; k < n ; k++)
+            {
+              sx = sin (x[k]);
+              cx = cos (x[k]);
+              t1 = cu2[k] * sx;
+              t2 = baz[k] - ref->su1 * cu2[k] * cx;
+              sy[k] = sqrt (t1 * t1 + t2 * t2);
+              cy[k] = s[k] * cx + faz[k];
+              y[k] = atan2 (sy[k], cy[k]);
+              sa = sy[k] > 0.0 ? s[k] * sx / sy[k] : 0.0;
+              c2a[k] = 1.0 - sa * sa;
+              cz[k] = faz[k] + faz[k];
+              cz[k] = c2a[k] > 0.0 ? cy[k] - cz[k] / c2a[k] : cz[k];
+              e[k] = cz[k] * cz[k] * 2.0 - 1.0;
+              c = ((-3.0 * c2a[k] + 4.0) * f + 4.0) * c2a[k] * f / 16.0;
+              d = x[k];
+              xx = ((e[k] * cy[k] * c + cz[k]) * sy[k] * c + y[k]) * sa;
+              x[k] = (1.0 - c) * xx * f + dlon[k];
+              delta[k] = fabs (d - x[k]);
+              max_delta = delta[k] > max_delta ? delta[k] : max_delta;
+            }
+
+          if (max_delta <= GEO_EPS) break;
+        }
+
+
+      /*  Helmert's elliptical terms.  */
+
+      for (k = 0 ; k < n ; k++)
+        {
+          xx = sqrt ((1.0 / r / r - 1.0) * c2a[k] + 1.0) + 1.0;
+          xx = (xx - 2.0) / xx;
+          c = (xx * xx / 4.0 + 1.0) / (1.0 - xx);
+          d = (0.375 * xx * xx - 1.0) * xx;
+          ss = 1.0 - e[k] - e[k];
+          dist[start + k] = ((((sy[k] * sy[k] * 4.0 - 3.0) * ss * cz[k] * d / 6.0 - e[k] * cy[k]) * d / 4.0 + cz[k]) * sy[k] * d + y[k]) *
+            c * ref->a * r;
+        }
+
+
+      /*  Anything that didn't converge, or is at a pole, goes to invgp.  */
+
+      for (k = 0 ; k < n ; k++)
+        {
+          if (!(delta[k] <= GEO_EPS) || fabs (lat[start + k]) > 89.999999)
+            invgp (NV_A0, NV_B0, ref->lat, ref->lon, lat[start + k], lon[start + k], &dist[start + k], &az);
+        }
+    }
+}
+
+
+
+/*  Distance in meters from the reference point to a position (degrees), for printing to the
+    millimeter.  A kernel distance that is within GEO_CHECK_TOLERANCE of a rounding boundary is
+    redone with invgp so the printed value is always the one invgp gives.  */
+
+double geo_distance (GEO_REFERENCE *ref, double lat, double lon)
+{
+  STAT_TIMER         timer = stats_start ();
+  double             dist, mm, az;
+
+
+  distance_batch (ref, &lat, &lon, &dist, 1);
+
+  mm = dist * 1000.0;
+  if (fabs ((mm - floor (mm)) - 0.5) <= GEO_CHECK_TOLERANCE * 1000.0) invgp (NV_A0, NV_B0, ref->lat, ref->lon, lat, lon, &dist, &az);
+
+  stats_stop (STAT_GEODESIC, timer);
+
+  return (dist);
+}
+
+
+
+/*  Clear pass[k] for each of count positions (degrees) that is more than max_distance meters from
+    the reference point.  */
+
+void geo_within_batch (GEO_REFERENCE *ref, const double *lat, const double *lon, double max_distance, uint8_t *pass, int32_t count)
+{
+  STAT_TIMER         timer = stats_start ();
+  double             dist[GEO_BATCH], az;
+  int32_t            start, n, k;
+
+
+  for (start = 0 ; start < count ; start += GEO_BATCH)
+    {
+      n = count - start;
+      if (n > GEO_BATCH) n = GEO_BATCH;
+
+      distance_batch (ref, &lat[start], &lon[start], dist, n);
+
+
+      /*  Too close to call with the kernel.  */
+
+      for (k = 0 ; k < n ; k++)
+        {
+          if (fabs (dist[k] - max_distance) <= GEO_CHECK_TOLERANCE)
+            invgp (NV_A0, NV_B0, ref->lat, ref->lon, lat[start + k], lon[start + k], &dist[k], &az);
+
+          pass[start + k] &= (dist[k] <= max_distance);
+        }
+    }
+
+  stats_stop (STAT_GEODESIC, timer);
+}
@@ -0,0 +1,518 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : grid.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --grid, binning of HOF correct_depth or TOF elevations
+ *               into a regular lat/lon grid.
+ *
+ *               Every chunk job (grid_file) bins its records into a partial
+ *               grid of its own, made of GRID_TILE x GRID_TILE cell tiles
+ *               that are only allocated when a point lands in them.  Each
+ *               cell keeps the count, mean, sum of squared differences from
+ *               the mean (Welford), minimum, and maximum.  When a job holds
+ *               GRID_JOB_MB of tiles, or at the end of the chunk, the tiles
+ *               are written to the job's spool and freed.
+ *
+ *               grid_merge combines the spooled tiles into one cell per grid
+ *               cell in a temporary file (Chan's parallel update for the
+ *               mean and variance), a row of a tile at a time, and then
+ *               writes the output file a grid row at a time.  Nothing ever
+ *               holds the whole grid in memory, so the grid can be larger
+ *               than RAM.
+ *
+ *               The output file is a GRID_HEADER followed by, for each grid
+ *               row from south to north, cols uint32_t counts and then cols
+ *               float means, minimums, maximums, and standard deviations.
+ *               Empty cells are GRID_NULL.  Null (-998.0) values are never
+ *               binned.  TOF files bin the first and/or last returns at
+ *               their own positions (--grid-return).
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+#define GRID_TILE            64
+#define GRID_TILE_CELLS      (GRID_TILE * GRID_TILE)
+#define GRID_JOB_MB          64
+
+
+typedef struct
+{
+  double             mean;
+  double             m2;
+  uint32_t           count;
+  float              min;
+  float              max;
+} GRID_CELL;
+
+
+typedef struct
+{
+  GRID_SPEC          *spec;
+  int32_t            tile_cols;
+  int32_t            num_tiles;
+  GRID_CELL          **tile;
+  int32_t            allocated;
+  int32_t            max_tiles;
+} GRID_PARTIAL;
+
+
+
+/*  --grid "MIN_LAT,MIN_LON,MAX_LAT,MAX_LON,CELL[,CELL_LON]" (degrees).  Returns 0 on success or
+    -1 on error.  */
+
+int32_t grid_parse (GRID_SPEC *spec, char *string)
+{
+  double             max_lat, max_lon, rows, cols;
+  int32_t            n;
+
+
+  n = sscanf (string, "%lf,%lf,%lf,%lf,%lf,%lf", &spec->min_lat, &spec->min_lon, &max_lat, &max_lon, &spec->cell_lat, &spec->cell_lon);
+
+  if (n == 5) spec->cell_lon = spec->cell_lat;
+
+  if (n < 5 || max_lat <= spec->min_lat || max_lon <= spec->min_lon || spec->cell_lat <= 0.0 || spec->cell_lon <= 0.0)
+    {
+      fprintf (stderr, "\nBad grid %s\n\n", string);
+      return (-1);
+    }
+
+
+  rows = ceil ((max_lat - spec->min_lat) / spec->cell_lat);
+  cols = ceil ((max_lon - spec->min_lon) / spec->cell_lon);
+
+  if (rows * cols > 4.0e12 || rows > INT32_MAX / 2 || cols > INT32_MAX / 2)
+    {
+      fprintf (stderr, "\nGrid %s has too many cells\n\n", string);
+      return (-1);
+    }
+
+  spec->rows = (int32_t) rows;
+  spec->cols = (int32_t) cols;
+
+  return (0);
+}
+
+
+
+static inline void cell_add (GRID_CELL *cell, float value)
+{
+  double             delta;
+
+
+  cell->count++;
+
+  if (cell->count == 1)
+    {
+      cell->mean = value;
+      cell->m2 = 0.0;
+      cell->min = cell->max = value;
+      return;
+    }
+
+  delta = value - cell->mean;
+  cell->mean += delta / (double) cell->count;
+  cell->m2 += delta * (value - cell->mean);
+
+  if (value < cell->min) cell->min = value;
+  if (value > cell->max) cell->max = value;
+}
+
+
+
+static inline void cell_merge (GRID_CELL *dst, GRID_CELL *src)
+{
+  double             n, delta;
+
+
+  if (!src->count) return;
+
+  if (!dst->count)
+    {
+      *dst = *src;
+      return;
+    }
+
+  n = (double) dst->count + (double) src->count;
+  delta = src->mean - dst->mean;
+
+  dst->mean += delta * (double) src->count / n;
+  dst->m2 += src->m2 + delta * delta * (double) dst->count * (double) src->count / n;
+  dst->count += src->count;
+
+  if (src->min < dst->min) dst->min = src->min;
+  if (src->max > dst->max) dst->max = src->max;
+}
+
+
+
+/*  Write every allocated tile to the spool (stdout) as the tile number followed by its cells, and
+    free them.  */
+
+static void partial_spill (GRID_PARTIAL *grid)
+{
+  int32_t            i;
+
+
+  for (i = 0 ; i < grid->num_tiles ; i++)
+    {
+      if (grid->tile[i] == NULL) continue;
+
+      fwrite (&i, sizeof (int32_t), 1, stdout);
+      fwrite (grid->tile[i], sizeof (GRID_CELL), GRID_TILE_CELLS, stdout);
+
+      free (grid->tile[i]);
+      grid->tile[i] = NULL;
+    }
+
+  grid->allocated = 0;
+}
+
+
+
+static void partial_add (GRID_PARTIAL *grid, double lat, double lon, float value)
+{
+  GRID_SPEC          *spec = grid->spec;
+  int32_t            row, col, t;
+  double             r, c;
+
+
+  if (value == -998.0) return;
+
+  r = floor ((lat - spec->min_lat) / spec->cell_lat);
+  c = floor ((lon - spec->min_lon) / spec->cell_lon);
+
+  if (!(r >= 0.0 && r < spec->rows && c >= 0.0 && c < spec->cols)) return;
+
+  row = (int32_t) r;
+  col = (int32_t) c;
+
+  t = (row / GRID_TILE) * grid->tile_cols + col / GRID_TILE;
+
+  if (grid->tile[t] == NULL)
+    {
+      if (grid->allocated == grid->max_tiles) partial_spill (grid);
+
+      if ((grid->tile[t] = (GRID_CELL *) calloc (GRID_TILE_CELLS, sizeof (GRID_CELL))) == NULL)
+        {
+          perror ("Allocating grid memory");
+          exit (-1);
+        }
+
+      grid->allocated++;
+    }
+
+  cell_add (&grid->tile[t][(row % GRID_TILE) * GRID_TILE + col % GRID_TILE], value);
+}
+
+
+
+/*  Bin records first_rec through last_rec (1 based, -1 for the end of the file) of file into a
+    partial grid written to stdout.  Returns 0 on success or -1 on error.  */
+
+int32_t grid_file (OPTIONS *options, char *file, int32_t first_rec, int32_t last_rec)
+{
+  GRID_SPEC          *spec = &options->grid;
+  GRID_PARTIAL       grid;
+  FILE               *fp;
+  HOF_HEADER_T       hof_header;
+  HYDRO_OUTPUT_T     *hof_batch = NULL;
+  TOPO_OUTPUT_T      *tof_batch = NULL;
+  RECORD_READER      reader;
+  uint8_t            pass[READ_BATCH];
+  int32_t            type, start, count, i, last;
+  void               *batch;
+
+
+  if (strstr (file, ".hof"))
+    {
+      if ((fp = open_hof_file (file)) == NULL)
+        {
+          perror (file);
+          return (-1);
+        }
+
+      type = 0;
+
+      hof_read_header (fp, &hof_header);
+
+      reader_open (&reader, fp, file, type, hof_header.text.number_shots, options->use_library);
+
+      batch = hof_batch = (HYDRO_OUTPUT_T *) malloc (READ_BATCH * sizeof (HYDRO_OUTPUT_T));
+    }
+  else if (strstr (file, ".tof"))
+    {
+      if ((fp = open_tof_file (file)) == NULL)
+        {
+          perror (file);
+          return (-1);
+        }
+
+      type = 1;
+
+      reader_open (&reader, fp, file, type, -1, options->use_library);
+
+      batch = tof_batch = (TOPO_OUTPUT_T *) malloc (READ_BATCH * sizeof (TOPO_OUTPUT_T));
+    }
+  else
+    {
+      fprintf (stderr,"\nUnknown file extension %s\n", file);
+      return (-1);
+    }
+
+
+  if (batch == NULL)
+    {
+      perror ("Allocating record memory");
+      exit (-1);
+    }
+
+
+  grid.spec = spec;
+  grid.tile_cols = (spec->cols + GRID_TILE - 1) / GRID_TILE;
+  grid.num_tiles = grid.tile_cols * ((spec->rows + GRID_TILE - 1) / GRID_TILE);
+  grid.allocated = 0;
+  grid.max_tiles = (int32_t) (((int64_t) GRID_JOB_MB * 1048576) / (GRID_TILE_CELLS * sizeof (GRID_CELL)));
+
+  if ((grid.tile = (GRID_CELL **) calloc (grid.num_tiles, sizeof (GRID_CELL *))) == NULL)
+    {
+      perror ("Allocating grid memory");
+      exit (-1);
+    }
+
+
+  last = last_rec < 0 ? INT32_MAX : last_rec;
+
+  for (start = first_rec < 1 ? 1 : first_rec ; start <= last ; start += count)
+    {
+      count = READ_BATCH;
+      if (last - start < count) count = last - start + 1;
+
+      if ((count = reader_read (&reader, start, count, batch)) <= 0) break;
+
+      if (options->filter.active) filter_batch (&options->filter, type, batch, count, pass);
+
+      for (i = 0 ; i < count ; i++)
+        {
+          if (options->filter.active && !pass[i]) continue;
+
+          if (type)
+            {
+              if (spec->returns & GRID_FIRST_RETURN)
+                partial_add (&grid, tof_batch[i].latitude_first, tof_batch[i].longitude_first, tof_batch[i].elevation_first);
+
+              if (spec->returns & GRID_LAST_RETURN)
+                partial_add (&grid, tof_batch[i].latitude_last, tof_batch[i].longitude_last, tof_batch[i].elevation_last);
+            }
+          else
+            {
+              partial_add (&grid, hof_batch[i].latitude, hof_batch[i].longitude, hof_batch[i].correct_depth);
+            }
+        }
+    }
+
+
+  partial_spill (&grid);
+
+  fflush (stdout);
+
+  free (grid.tile);
+  reader_close (&reader);
+  free (hof_batch);
+  free (tof_batch);
+  fclose (fp);
+
+  return (0);
+}
+
+
+
+/*  Merge the num_spools partial grids and write the grid to spec->out.  The spools are closed.
+    Returns 0 on success or -1 on error.  */
+
+int32_t grid_merge (GRID_SPEC *spec, FILE **spool, int32_t num_spools)
+{
+  GRID_HEADER        header;
+  GRID_CELL          *tile, *row_cells;
+  FILE               *acc, *fp;
+  uint32_t           *counts;
+  float              *values;
+  int32_t            i, t, r, c, k, row, col0, width, tile_cols, status = 0;
+  int64_t            row_bytes = (int64_t) spec->cols * sizeof (GRID_CELL);
+
+
+  tile_cols = (spec->cols + GRID_TILE - 1) / GRID_TILE;
+
+  if ((tile = (GRID_CELL *) malloc (GRID_TILE_CELLS * sizeof (GRID_CELL))) == NULL ||
+      (row_cells = (GRID_CELL *) malloc (row_bytes)) == NULL ||
+      (counts = (uint32_t *) malloc (spec->cols * sizeof (uint32_t))) == NULL ||
+      (values = (float *) malloc (spec->cols * sizeof (float))) == NULL)
+    {
+      perror ("Allocating grid memory");
+      exit (-1);
+    }
+
+
+  /*  The merged cells, one GRID_CELL per grid cell in row order.  Untouched cells read back as
+      zero (empty).  */
+
+  if ((acc = tmpfile ()) == NULL)
+    {
+      perror ("Creating grid work file");
+      exit (-1);
+    }
+
+#ifndef NVWIN3X
+  if (ftruncate (fileno (acc), (off_t) spec->rows * row_bytes))
+    {
+      perror ("Creating grid work file");
+      exit (-1);
+    }
+#endif
+
+
+  for (i = 0 ; i < num_spools ; i++)
+    {
+      if (spool[i] == NULL) continue;
+
+      while (fread (&t, sizeof (int32_t), 1, spool[i]) == 1 && fread (tile, sizeof (GRID_CELL), GRID_TILE_CELLS, spool[i]) == GRID_TILE_CELLS)
+        {
+          col0 = (t % tile_cols) * GRID_TILE;
+          width = spec->cols - col0;
+          if (width > GRID_TILE) width = GRID_TILE;
+
+          for (r = 0 ; r < GRID_TILE ; r++)
+            {
+              row = (t / tile_cols) * GRID_TILE + r;
+              if (row >= spec->rows) break;
+
+              fseeko (acc, ((off_t) row * spec->cols + col0) * sizeof (GRID_CELL), SEEK_SET);
+              memset (row_cells, 0, width * sizeof (GRID_CELL));
+              if (fread (row_cells, sizeof (GRID_CELL), width, acc) != (size_t) width) memset (row_cells, 0, width * sizeof (GRID_CELL));
+
+              for (c = 0 ; c < width ; c++) cell_merge (&row_cells[c], &tile[r * GRID_TILE + c]);
+
+              fseeko (acc, ((off_t) row * spec->cols + col0) * sizeof (GRID_CELL), SEEK_SET);
+              fwrite (row_cells, sizeof (GRID_CELL), width, acc);
+            }
+        }
+
+      fclose (spool[i]);
+      spool[i] = NULL;
+    }
+
+
+  /*  Write the grid.  */
+
+  if ((fp = fopen (spec->out, "wb")) == NULL)
+    {
+      perror (spec->out);
+      fclose (acc);
+      free (tile);
+      free (row_cells);
+      free (counts);
+      free (values);
+      return (-1);
+    }
+
+
+  memset (&header, 0, sizeof (GRID_HEADER));
+  memcpy (header.magic, GRID_MAGIC, 8);
+  header.version = GRID_VERSION;
+  header.rows = spec->rows;
+  header.cols = spec->cols;
+  header.value_type = spec->value_type;
+  header.min_lat = spec->min_lat;
+  header.min_lon = spec->min_lon;
+  header.cell_lat = spec->cell_lat;
+  header.cell_lon = spec->cell_lon;
+  header.null_value = GRID_NULL;
+
+  fwrite (&header, sizeof (GRID_HEADER), 1, fp);
+
+  fflush (acc);
+  rewind (acc);
+
+  for (row = 0 ; row < spec->rows ; row++)
+    {
+      if (fread (row_cells, sizeof (GRID_CELL), spec->cols, acc) != (size_t) spec->cols) memset (row_cells, 0, row_bytes);
+
+      for (c = 0 ; c < spec->cols ; c++) counts[c] = row_cells[c].count;
+      fwrite (counts, sizeof (uint32_t), spec->cols, fp);
+
+      for (k = 0 ; k < 4 ; k++)
+        {
+          for (c = 0 ; c < spec->cols ; c++)
+            {
+              if (!row_cells[c].count)
+                {
+                  values[c] = GRID_NULL;
+                }
+              else
+                {
+                  switch (k)
+                    {
+                    case 0:
+                      values[c] = (float) row_cells[c].mean;
+                      break;
+
+                    case 1:
+                      values[c] = row_cells[c].min;
+                      break;
+
+                    case 2:
+                      values[c] = row_cells[c].max;
+                      break;
+
+                    case 3:
+                      values[c] = (float) sqrt (row_cells[c].m2 / (double) row_cells[c].count);
+                      break;
+                    }
+                }
+            }
+
+          fwrite (values, sizeof (float), spec->cols, fp);
+        }
+    }
+
+
+  if (fclose (fp))
+    {
+      perror (spec->out);
+      status = -1;
+    }
+
+  fclose (acc);
+  free (tile);
+  free (row_cells);
+  free (counts);
+  free (values);
+
+  return (status);
+}
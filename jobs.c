@@ -0,0 +1,379 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : jobs.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Runs numbered jobs on a pool of worker processes and emits
+ *               their output in job order.
+ *
+ *               The CHARTS library dump functions (hof_dump_record,
+ *               tof_dump_record) write straight to stdout and the SRTM mask
+ *               code keeps static state, so jobs can't safely share one
+ *               process.  Each job is forked with its stdout and stderr
+ *               redirected to temporary files.  The parent copies a job's
+ *               output to the real stdout/stderr as soon as it and every job
+ *               before it have finished, so each job's output stays in one
+ *               piece and the result is identical to running the jobs one
+ *               after another.
+ *
+ *               run_spooled_jobs does the same but leaves each job's output
+ *               in its own temporary file for the caller (see merge.c).
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+#ifndef NVWIN3X
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+
+/*  Maximum number of finished-but-not-yet-emitted jobs per worker.  This bounds the temporary
+    disk space used when one early job is much larger than the jobs after it.  */
+
+#define JOB_LOOKAHEAD 4
+
+
+typedef struct
+{
+  int32_t            pid;
+  FILE               *out;
+  FILE               *err;
+  uint8_t            done;
+  int32_t            status;
+} JOB_STATE;
+
+
+
+/*  Monotonic wall clock time in seconds.  */
+
+double wall_clock ()
+{
+#ifdef NVWIN3X
+  return ((double) clock () / (double) CLOCKS_PER_SEC);
+#else
+  struct timespec    ts;
+
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return ((double) ts.tv_sec + (double) ts.tv_nsec * 1.0e-9);
+#endif
+}
+
+
+
+/*  Return the number of workers to use.  0 means one per online processor.  */
+
+int32_t get_worker_count (int32_t requested)
+{
+  int32_t            count = requested;
+
+
+#ifdef _SC_NPROCESSORS_ONLN
+  if (count <= 0) count = (int32_t) sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (count < 1) count = 1;
+
+  return (count);
+}
+
+
+
+#ifndef NVWIN3X
+
+static void copy_stream (FILE *src, FILE *dst)
+{
+  char               buffer[65536];
+  size_t             size;
+
+
+  rewind (src);
+
+  while ((size = fread (buffer, 1, sizeof (buffer), src)) > 0) fwrite (buffer, 1, size, dst);
+
+  fclose (src);
+}
+
+
+
+static void emit_job (JOB_STATE *job, FILE **spool)
+{
+  copy_stream (job->err, stderr);
+
+  if (spool)
+    {
+      rewind (job->out);
+      *spool = job->out;
+    }
+  else
+    {
+      copy_stream (job->out, stdout);
+    }
+
+  fflush (stderr);
+  fflush (stdout);
+}
+
+
+
+static int32_t launch_job (JOB_STATE *job, int32_t job_num, JOB_FUNC func, void *data)
+{
+  pid_t              pid;
+  int32_t            status;
+
+
+  job->out = tmpfile ();
+  job->err = tmpfile ();
+
+  if (job->out == NULL || job->err == NULL)
+    {
+      perror ("Creating job output file");
+      if (job->out) fclose (job->out);
+      if (job->err) fclose (job->err);
+      return (-1);
+    }
+
+
+  /*  Anything still buffered would be written twice if we didn't flush before forking.  */
+
+  fflush (stdout);
+  fflush (stderr);
+
+
+  if ((pid = fork ()) < 0)
+    {
+      perror ("Starting worker process");
+      fclose (job->out);
+      fclose (job->err);
+      return (-1);
+    }
+
+
+  if (!pid)
+    {
+      dup2 (fileno (job->out), 1);
+      dup2 (fileno (job->err), 2);
+
+      status = (*func) (job_num, data);
+
+      fflush (stdout);
+      fflush (stderr);
+
+      stats_flush ();
+
+      _exit (status ? 1 : 0);
+    }
+
+
+  job->pid = pid;
+  job->done = NVFalse;
+
+  return (0);
+}
+
+#endif
+
+
+
+/*  Run one job in this process.  If spool is set the job's stdout goes to a new temporary file
+    that is returned in *spool.  */
+
+static int32_t run_job_here (int32_t job_num, JOB_FUNC func, void *data, FILE **spool)
+{
+  int32_t            status, saved;
+
+
+  if (!spool) return ((*func) (job_num, data));
+
+
+  if ((*spool = tmpfile ()) == NULL)
+    {
+      perror ("Creating job output file");
+      return (-1);
+    }
+
+  fflush (stdout);
+
+
+  /*  If stdout can't be saved it couldn't be put back, so don't move it.  */
+
+  if ((saved = dup (1)) < 0 || dup2 (fileno (*spool), 1) < 0)
+    {
+      perror ("Redirecting job output");
+      if (saved >= 0) close (saved);
+      fclose (*spool);
+      *spool = NULL;
+      return (-1);
+    }
+
+  status = (*func) (job_num, data);
+
+  fflush (stdout);
+
+  dup2 (saved, 1);
+  close (saved);
+
+  rewind (*spool);
+
+  return (status);
+}
+
+
+
+/*  Run jobs 0 through num_jobs - 1 and return the number of jobs that failed.  With spool, job i's
+    output is left in spool[i] (NULL if it couldn't be run) instead of being written to stdout.
+    Every spool is kept until the caller closes it, so there is no lookahead limit.  */
+
+static int32_t run_jobs (int32_t num_jobs, int32_t workers, JOB_FUNC func, void *data, FILE **spool)
+{
+  int32_t            i, failed = 0;
+
+
+#ifndef NVWIN3X
+
+  JOB_STATE          *job;
+  int32_t            next_launch = 0, next_emit = 0, running = 0, status;
+  pid_t              pid;
+
+
+  if (workers > 1 && num_jobs > 1)
+    {
+      if ((job = (JOB_STATE *) calloc (num_jobs, sizeof (JOB_STATE))) == NULL)
+        {
+          perror ("Allocating job memory");
+          exit (-1);
+        }
+
+
+      while (next_emit < num_jobs)
+        {
+          /*  Keep the pool full.  */
+
+          while (running < workers && next_launch < num_jobs && (spool || next_launch - next_emit < workers * JOB_LOOKAHEAD))
+            {
+              if (launch_job (&job[next_launch], next_launch, func, data))
+                {
+                  /*  If we can't fork, wait for the pool to drain and then run the job here.  */
+
+                  if (next_launch == next_emit && !running)
+                    {
+                      if (run_job_here (next_launch, func, data, spool ? &spool[next_launch] : NULL)) failed++;
+                      next_emit++;
+                    }
+                  else
+                    {
+                      break;
+                    }
+                }
+              else
+                {
+                  running++;
+                }
+
+              next_launch++;
+            }
+
+
+          /*  Emit every finished job that is next in line.  */
+
+          while (next_emit < next_launch && job[next_emit].done)
+            {
+              emit_job (&job[next_emit], spool ? &spool[next_emit] : NULL);
+
+              if (job[next_emit].status) failed++;
+
+              next_emit++;
+            }
+
+
+          if (next_emit == num_jobs || !running) continue;
+
+
+          /*  Wait for any worker to finish.  */
+
+          if ((pid = wait (&status)) < 0)
+            {
+              if (errno == EINTR) continue;
+
+              perror ("Waiting for worker process");
+              exit (-1);
+            }
+
+          for (i = next_emit ; i < next_launch ; i++)
+            {
+              if (job[i].pid == pid && !job[i].done)
+                {
+                  job[i].done = NVTrue;
+                  job[i].status = (WIFEXITED (status) && !WEXITSTATUS (status)) ? 0 : -1;
+                  running--;
+                  break;
+                }
+            }
+        }
+
+      free (job);
+
+      return (failed);
+    }
+
+#endif
+
+
+  /*  Serial processing.  */
+
+  for (i = 0 ; i < num_jobs ; i++)
+    {
+      if (run_job_here (i, func, data, spool ? &spool[i] : NULL)) failed++;
+    }
+
+  return (failed);
+}
+
+
+
+int32_t run_ordered_jobs (int32_t num_jobs, int32_t workers, JOB_FUNC func, void *data)
+{
+  return (run_jobs (num_jobs, workers, func, data, NULL));
+}
+
+
+
+/*  Same as run_ordered_jobs but job i's output is returned, rewound, in spool[i] (which must have
+    room for num_jobs entries).  The caller closes the spools.  */
+
+int32_t run_spooled_jobs (int32_t num_jobs, int32_t workers, JOB_FUNC func, void *data, FILE **spool)
+{
+  int32_t            i;
+
+
+  for (i = 0 ; i < num_jobs ; i++) spool[i] = NULL;
+
+  return (run_jobs (num_jobs, workers, func, data, spool));
+}
@@ -0,0 +1,418 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : joint.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --joint, one combined bathymetry and topography Y,X,Z listing
+ *               per flight line from its .hof and .tof files in one pass.
+ *
+ *               The input files are paired by name (everything before the
+ *               extension), and each line is one job.  Both files are read in
+ *               READ_BATCH record batches through their own record reader, so
+ *               the mapping read ahead (or --prefetch) is running on both at
+ *               once, and the two streams are merged on the record timestamp.
+ *               Each file has to be in time order, which they are as
+ *               collected.  On equal times the HOF record comes first.
+ *
+ *               Lines are
+ *
+ *                 lat,lon,z,H        HOF correct_depth
+ *                 lat,lon,z,T        TOF first or last return elevation
+ *
+ *               with the same records and numbers as -y (-d drops the nulls),
+ *               except that a TOF first return that is the same point as the
+ *               last return (a single return) is listed once instead of twice.
+ *               A line with only one of the files is listed on its own.  The
+ *               --bbox, --polygon, --time, and --radius filters apply.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+typedef struct
+{
+  char               *hof;                       /*  NULL if the line has no HOF file  */
+  char               *tof;                       /*  NULL if the line has no TOF file  */
+  int32_t            order;                      /*  position of the first of the two in the file list  */
+} JOINT_LINE;
+
+
+typedef struct
+{
+  OPTIONS            *options;
+  JOINT_LINE         *line;
+} JOINT_JOBS;
+
+
+typedef struct
+{
+  int32_t            type;                       /*  0 = HOF, 1 = TOF  */
+  FILE               *fp;
+  RECORD_READER      reader;
+  void               *batch;
+  uint8_t            pass[READ_BATCH];
+  int32_t            count;                      /*  records in batch  */
+  int32_t            pos;                        /*  next record in batch  */
+  int32_t            next;                       /*  next record number to read (1 based)  */
+  int32_t            end;                        /*  last record number, -1 for the end of the file  */
+} JOINT_STREAM;
+
+
+
+/*  Open one side of a line.  Returns 0 on success or -1 on error.  */
+
+static int32_t joint_open (OPTIONS *options, JOINT_STREAM *stream, char *file, int32_t type)
+{
+  HOF_HEADER_T       hof_header;
+
+
+  memset (stream, 0, sizeof (JOINT_STREAM));
+
+  stream->type = type;
+  stream->next = 1;
+  stream->end = -1;
+
+  if ((stream->fp = type ? open_tof_file (file) : open_hof_file (file)) == NULL)
+    {
+      perror (file);
+      return (-1);
+    }
+
+  if (type)
+    {
+      stream->batch = malloc (READ_BATCH * sizeof (TOPO_OUTPUT_T));
+      reader_open (&stream->reader, stream->fp, file, type, -1, options->use_library);
+    }
+  else
+    {
+      hof_read_header (stream->fp, &hof_header);
+      stream->end = hof_header.text.number_shots;
+
+      stream->batch = malloc (READ_BATCH * sizeof (HYDRO_OUTPUT_T));
+      reader_open (&stream->reader, stream->fp, file, type, hof_header.text.number_shots, options->use_library);
+    }
+
+  if (stream->batch == NULL)
+    {
+      perror ("Allocating record memory");
+      exit (-1);
+    }
+
+  fprintf (stderr, "\n\nFile : %s\n\n", file);
+
+  stats_count (STAT_FILES, 1);
+
+  return (0);
+}
+
+
+
+static void joint_close (JOINT_STREAM *stream)
+{
+  if (stream->fp == NULL) return;
+
+  reader_close (&stream->reader);
+  fclose (stream->fp);
+  free (stream->batch);
+
+  stream->fp = NULL;
+}
+
+
+
+/*  Make sure the stream has a record ready.  Returns NVFalse at the end of the file.  */
+
+static uint8_t joint_ready (OPTIONS *options, JOINT_STREAM *stream)
+{
+  int32_t            count;
+
+
+  if (stream->fp == NULL) return (NVFalse);
+
+  if (stream->pos < stream->count) return (NVTrue);
+
+  count = READ_BATCH;
+  if (stream->end >= 0 && stream->next + count - 1 > stream->end) count = stream->end - stream->next + 1;
+
+  if (count <= 0 || (stream->count = reader_read (&stream->reader, stream->next, count, stream->batch)) <= 0)
+    {
+      stream->count = 0;
+      joint_close (stream);
+      return (NVFalse);
+    }
+
+  if (options->filter.active) filter_batch (&options->filter, stream->type, stream->batch, stream->count, stream->pass);
+
+  stream->next += stream->count;
+  stream->pos = 0;
+
+  return (NVTrue);
+}
+
+
+
+static inline int64_t joint_time (JOINT_STREAM *stream)
+{
+  if (stream->type) return (((TOPO_OUTPUT_T *) stream->batch)[stream->pos].timestamp);
+
+  return (((HYDRO_OUTPUT_T *) stream->batch)[stream->pos].timestamp);
+}
+
+
+
+/*  List HOF records up to and including time limit from the current batch.  */
+
+static void joint_hof (OPTIONS *options, JOINT_STREAM *stream, OUTPUT_BUFFER *out, int64_t limit)
+{
+  HYDRO_OUTPUT_T     *hof = (HYDRO_OUTPUT_T *) stream->batch;
+  int32_t            j, rejected = 0;
+
+
+  for (j = stream->pos ; j < stream->count && hof[j].timestamp <= limit ; j++)
+    {
+      if (options->filter.active && !stream->pass[j]) continue;
+
+      if (!options->list_null && hof[j].correct_depth == -998.0)
+        {
+          rejected++;
+          continue;
+        }
+
+      output_yxz_source (out, hof[j].latitude, hof[j].longitude, hof[j].correct_depth, 'H');
+    }
+
+  stream->pos = j;
+
+  if (rejected) stats_count (STAT_REJECTED_NULL, rejected);
+}
+
+
+
+/*  List TOF records before time limit from the current batch.  */
+
+static void joint_tof (OPTIONS *options, JOINT_STREAM *stream, OUTPUT_BUFFER *out, int64_t limit)
+{
+  TOPO_OUTPUT_T      *tof = (TOPO_OUTPUT_T *) stream->batch;
+  int32_t            j, rejected = 0;
+
+
+  for (j = stream->pos ; j < stream->count && tof[j].timestamp < limit ; j++)
+    {
+      if (options->filter.active && !stream->pass[j]) continue;
+
+      if (!options->list_null && tof[j].elevation_last == -998.0)
+        {
+          rejected++;
+          continue;
+        }
+
+      /*  A single return is stored as both the first and the last return.  */
+
+      if (tof[j].elevation_first != -998.0 &&
+          (tof[j].elevation_first != tof[j].elevation_last || tof[j].latitude_first != tof[j].latitude_last ||
+           tof[j].longitude_first != tof[j].longitude_last))
+        output_yxz_source (out, tof[j].latitude_first, tof[j].longitude_first, tof[j].elevation_first, 'T');
+
+      output_yxz_source (out, tof[j].latitude_last, tof[j].longitude_last, tof[j].elevation_last, 'T');
+    }
+
+  stream->pos = j;
+
+  if (rejected) stats_count (STAT_REJECTED_NULL, rejected);
+}
+
+
+
+/*  List one flight line.  Returns 0 on success or -1 on error.  */
+
+static int32_t joint_line (OPTIONS *options, JOINT_LINE *line)
+{
+  JOINT_STREAM       hof, tof;
+  OUTPUT_BUFFER      out;
+  STAT_TIMER         timer = stats_start ();
+  uint8_t            hof_ready, tof_ready;
+
+
+  hof.fp = tof.fp = NULL;
+
+  if ((line->hof != NULL && joint_open (options, &hof, line->hof, 0)) || (line->tof != NULL && joint_open (options, &tof, line->tof, 1)))
+    {
+      joint_close (&hof);
+      return (-1);
+    }
+
+  output_init (&out, stdout);
+
+
+  /*  Take the stream with the earlier record, and then every record from it up to the other
+      stream's next time, so the comparison is made once per run of records from one file rather
+      than once per record.  */
+
+  while (1)
+    {
+      hof_ready = joint_ready (options, &hof);
+      tof_ready = joint_ready (options, &tof);
+
+      if (!hof_ready && !tof_ready) break;
+
+      if (hof_ready && (!tof_ready || joint_time (&hof) <= joint_time (&tof)))
+        {
+          joint_hof (options, &hof, &out, tof_ready ? joint_time (&tof) : INT64_MAX);
+        }
+      else
+        {
+          joint_tof (options, &tof, &out, hof_ready ? joint_time (&hof) : INT64_MAX);
+        }
+    }
+
+  output_close (&out);
+
+  joint_close (&hof);
+  joint_close (&tof);
+
+  stats_stop (STAT_FORMAT, timer);
+
+  return (0);
+}
+
+
+
+static int32_t joint_job (int32_t job, void *data)
+{
+  JOINT_JOBS         *jobs = (JOINT_JOBS *) data;
+
+
+  return (joint_line (jobs->options, &jobs->line[job]));
+}
+
+
+
+/*  Sort the file list positions by name without the extension, then by the full name.  */
+
+static FILE_LIST     *sort_list;
+
+static int32_t compare_base (const void *a, const void *b)
+{
+  char               *name_a = sort_list->name[*(const int32_t *) a], *name_b = sort_list->name[*(const int32_t *) b];
+  int32_t            length_a = strlen (name_a) - 4, length_b = strlen (name_b) - 4, result;
+
+
+  if ((result = strncmp (name_a, name_b, length_a < length_b ? length_a : length_b))) return (result);
+
+  if (length_a != length_b) return (length_a < length_b ? -1 : 1);
+
+  return (strcmp (name_a, name_b));
+}
+
+
+
+static int32_t compare_order (const void *a, const void *b)
+{
+  return (((const JOINT_LINE *) a)->order - ((const JOINT_LINE *) b)->order);
+}
+
+
+
+/*  List the HOF and TOF files in list as flight lines, in the order they were given.  Returns the
+    number of lines that failed.  */
+
+int32_t joint_files (OPTIONS *options, FILE_LIST *list)
+{
+  JOINT_JOBS         jobs;
+  JOINT_LINE         *line;
+  int32_t            *index, i, k, count = 0, failed;
+  uint8_t            hof;
+
+
+  if ((index = (int32_t *) malloc (list->count * sizeof (int32_t))) == NULL ||
+      (jobs.line = (JOINT_LINE *) calloc (list->count, sizeof (JOINT_LINE))) == NULL)
+    {
+      perror ("Allocating line memory");
+      exit (-1);
+    }
+
+  for (i = 0 ; i < list->count ; i++)
+    {
+      if (strstr (list->name[i], ".hof") == NULL && strstr (list->name[i], ".tof") == NULL)
+        {
+          fprintf (stderr, "\n%s is not a HOF or TOF file\n\n", list->name[i]);
+          exit (-1);
+        }
+
+      index[i] = i;
+    }
+
+  sort_list = list;
+  qsort (index, list->count, sizeof (int32_t), compare_base);
+
+
+  /*  After the sort the two files of a line are next to each other, the .hof first.  */
+
+  for (i = 0 ; i < list->count ; i++)
+    {
+      k = index[i];
+      hof = strstr (list->name[k], ".hof") != NULL;
+
+      if (count && !hof)
+        {
+          line = &jobs.line[count - 1];
+
+          if (line->hof != NULL && line->tof == NULL && strlen (line->hof) == strlen (list->name[k]) &&
+              !strncmp (line->hof, list->name[k], strlen (list->name[k]) - 4))
+            {
+              line->tof = list->name[k];
+              if (k < line->order) line->order = k;
+              continue;
+            }
+        }
+
+      line = &jobs.line[count++];
+
+      if (hof)
+        {
+          line->hof = list->name[k];
+        }
+      else
+        {
+          line->tof = list->name[k];
+        }
+      line->order = k;
+    }
+
+  qsort (jobs.line, count, sizeof (JOINT_LINE), compare_order);
+
+
+  jobs.options = options;
+
+  failed = run_ordered_jobs (count, options->workers, joint_job, &jobs);
+
+  free (jobs.line);
+  free (index);
+
+  return (failed);
+}
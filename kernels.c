@@ -0,0 +1,365 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : kernels.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Record loop kernels, one for each combination of the options
+ *               that change what happens to a record (output form, -d,
+ *               filtering, -s, -t, -w, and the SRTM check).  process_file
+ *               picks the kernel once per file with kernel_select and hands
+ *               it each batch of records, so the per record work has no
+ *               option tests left in it.
+ *
+ *               Each loop is written once as an always inline function whose
+ *               mode arguments are constants in the KERNEL macros that
+ *               instantiate it.  The compiler drops the branches that can't
+ *               be taken for that combination.  Rejected record counts are
+ *               kept locally and added to the --stats counters once per
+ *               batch.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+#ifdef __GNUC__
+#define KERNEL_INLINE        static inline __attribute__ ((always_inline))
+#else
+#define KERNEL_INLINE        static inline
+#endif
+
+
+/*  Output forms.  */
+
+#define EMIT_DUMP            0                   /*  the CHARTS library dump  */
+#define EMIT_YXZ             1
+#define EMIT_FIELDS          2
+#define EMIT_COLUMNAR        3
+
+
+
+/*  HOF records for a listing (everything but -t and -w).  values is the decoded shot data for the
+    batch with -s.  */
+
+KERNEL_INLINE int32_t hof_list (KERNEL_STATE *state, HYDRO_OUTPUT_T *hof, int32_t count, uint8_t *pass, SHOT_VALUES *values,
+                                const int32_t emit, const uint8_t list_null, const uint8_t filter, const uint8_t shots)
+{
+  int32_t            j, rejected = 0;
+
+
+  for (j = 0 ; j < count ; j++)
+    {
+      if (filter && !pass[j]) continue;
+
+      if (!list_null && hof[j].correct_depth == -998.0)
+        {
+          rejected++;
+          continue;
+        }
+
+      if (shots) output_shot_data (state->out, &values[j]);
+
+      switch (emit)
+        {
+        case EMIT_DUMP:
+          output_flush (state->out);
+          hof_dump_record (&hof[j]);
+          break;
+
+        case EMIT_YXZ:
+          output_yxz (state->out, hof[j].latitude, hof[j].longitude, hof[j].correct_depth);
+          break;
+
+        case EMIT_FIELDS:
+          output_record (state->out, state->format, &hof[j]);
+          break;
+
+        case EMIT_COLUMNAR:
+          columnar_add (state->col, &hof[j]);
+          break;
+        }
+    }
+
+  if (rejected) stats_count (STAT_REJECTED_NULL, rejected);
+
+  return (0);
+}
+
+
+
+KERNEL_INLINE int32_t tof_list (KERNEL_STATE *state, TOPO_OUTPUT_T *tof, int32_t count, uint8_t *pass, const int32_t emit,
+                                const uint8_t list_null, const uint8_t filter)
+{
+  int32_t            j, rejected = 0;
+
+
+  for (j = 0 ; j < count ; j++)
+    {
+      if (filter && !pass[j]) continue;
+
+      if (!list_null && tof[j].elevation_last == -998.0)
+        {
+          rejected++;
+          continue;
+        }
+
+      switch (emit)
+        {
+        case EMIT_DUMP:
+          output_flush (state->out);
+          tof_dump_record (&tof[j]);
+          break;
+
+        case EMIT_YXZ:
+          if (tof[j].elevation_first != -998.0) output_yxz (state->out, tof[j].latitude_first, tof[j].longitude_first, tof[j].elevation_first);
+          output_yxz (state->out, tof[j].latitude_last, tof[j].longitude_last, tof[j].elevation_last);
+          break;
+
+        case EMIT_FIELDS:
+          output_record (state->out, state->format, &tof[j]);
+          break;
+
+        case EMIT_COLUMNAR:
+          columnar_add (state->col, &tof[j]);
+          break;
+        }
+    }
+
+  if (rejected) stats_count (STAT_REJECTED_NULL, rejected);
+
+  return (0);
+}
+
+
+
+/*  -t, count the valid depths and the ones with no tide correction.  */
+
+KERNEL_INLINE int32_t hof_tide (KERNEL_STATE *state, HYDRO_OUTPUT_T *hof, int32_t count, uint8_t *pass, const uint8_t filter)
+{
+  int32_t            j, rejected = 0;
+
+
+  for (j = 0 ; j < count ; j++)
+    {
+      if (filter && !pass[j]) continue;
+
+      if (hof[j].reported_depth != -998.0)
+        {
+          if ((hof[j].reported_depth + hof[j].tide_cor_depth) == 0.0) state->zero_tide++;
+          state->total++;
+        }
+      else
+        {
+          rejected++;
+        }
+    }
+
+  if (rejected) stats_count (STAT_REJECTED_NULL, rejected);
+
+  return (0);
+}
+
+
+
+/*  -w and -W.  start is the 0 based record number of hof[0].  Returns -1 if the file isn't KGPS.  */
+
+KERNEL_INLINE int32_t hof_water_level (KERNEL_STATE *state, HYDRO_OUTPUT_T *hof, int32_t start, int32_t count, uint8_t *pass,
+                                       const uint8_t filter, const uint8_t srtm_check)
+{
+  int32_t            i, j, null = 0, land = 0, abdc = 0, edge = 0, status = 0;
+
+
+  for (j = 0 ; j < count ; j++)
+    {
+      if (filter && !pass[j]) continue;
+
+      i = start + j;
+
+
+      /*  Valid depth, valid water level, KGPS, not Shoreline Depth Swapped, not Shallow Water Algorithm, greater than 70 (70 = land),
+          skip the first and last ten seconds, and check SRTM land mask.  */
+
+      if (hof[j].correct_depth != -998.0 && hof[j].kgps_water_level != -998.0 && hof[j].data_type == 1 && hof[j].abdc != 72 &&
+          hof[j].abdc != 74 && hof[j].abdc > 70 && i > state->per_ten_sec && i < state->number_shots - state->per_ten_sec)
+        {
+          if (srtm_check && !srtm_cache_read (hof[j].latitude, hof[j].longitude))
+            {
+              wl_add (state->wl, hof[j].timestamp, hof[j].latitude, hof[j].longitude, hof[j].kgps_water_level);
+            }
+          else
+            {
+              land++;
+            }
+        }
+      else if (hof[j].data_type != 1)
+        {
+          stats_count (STAT_REJECTED_DATA_TYPE, 1);
+
+          fprintf (stderr, "\nCannot get water level from non-KGPS HOF files - Doh!\n\n");
+          status = -1;
+          break;
+        }
+      else if (hof[j].correct_depth == -998.0 || hof[j].kgps_water_level == -998.0)
+        {
+          null++;
+        }
+      else if (hof[j].abdc == 72 || hof[j].abdc == 74 || hof[j].abdc <= 70)
+        {
+          abdc++;
+        }
+      else
+        {
+          edge++;
+        }
+    }
+
+  if (null) stats_count (STAT_REJECTED_NULL, null);
+  if (land) stats_count (STAT_REJECTED_LAND, land);
+  if (abdc) stats_count (STAT_REJECTED_ABDC, abdc);
+  if (edge) stats_count (STAT_REJECTED_EDGE, edge);
+
+  return (status);
+}
+
+
+
+/*  The instances.  Every kernel has the RECORD_KERNEL arguments whether it uses them or not.  */
+
+#define HOF_LIST_KERNEL(emit, null, filter, shots) \
+  static int32_t hof_list_##emit##_##null##_##filter##_##shots (KERNEL_STATE *state, void *records, int32_t start, \
+                                                              int32_t count, uint8_t *pass, SHOT_VALUES *values) \
+  { \
+    (void) start; \
+    return (hof_list (state, (HYDRO_OUTPUT_T *) records, count, pass, values, emit, null, filter, shots)); \
+  }
+
+#define TOF_LIST_KERNEL(emit, null, filter) \
+  static int32_t tof_list_##emit##_##null##_##filter (KERNEL_STATE *state, void *records, int32_t start, \
+                                                      int32_t count, uint8_t *pass, SHOT_VALUES *values) \
+  { \
+    (void) start; (void) values; \
+    return (tof_list (state, (TOPO_OUTPUT_T *) records, count, pass, emit, null, filter)); \
+  }
+
+#define HOF_LIST_KERNELS(emit) \
+  HOF_LIST_KERNEL (emit, 0, 0, 0) HOF_LIST_KERNEL (emit, 0, 0, 1) HOF_LIST_KERNEL (emit, 0, 1, 0) HOF_LIST_KERNEL (emit, 0, 1, 1) \
+  HOF_LIST_KERNEL (emit, 1, 0, 0) HOF_LIST_KERNEL (emit, 1, 0, 1) HOF_LIST_KERNEL (emit, 1, 1, 0) HOF_LIST_KERNEL (emit, 1, 1, 1)
+
+#define TOF_LIST_KERNELS(emit) \
+  TOF_LIST_KERNEL (emit, 0, 0) TOF_LIST_KERNEL (emit, 0, 1) TOF_LIST_KERNEL (emit, 1, 0) TOF_LIST_KERNEL (emit, 1, 1)
+
+HOF_LIST_KERNELS (EMIT_DUMP)
+HOF_LIST_KERNELS (EMIT_YXZ)
+HOF_LIST_KERNELS (EMIT_FIELDS)
+HOF_LIST_KERNELS (EMIT_COLUMNAR)
+
+TOF_LIST_KERNELS (EMIT_DUMP)
+TOF_LIST_KERNELS (EMIT_YXZ)
+TOF_LIST_KERNELS (EMIT_FIELDS)
+TOF_LIST_KERNELS (EMIT_COLUMNAR)
+
+
+#define HOF_TIDE_KERNEL(filter) \
+  static int32_t hof_tide_##filter (KERNEL_STATE *state, void *records, int32_t start, int32_t count, \
+                                    uint8_t *pass, SHOT_VALUES *values) \
+  { \
+    (void) start; (void) values; \
+    return (hof_tide (state, (HYDRO_OUTPUT_T *) records, count, pass, filter)); \
+  }
+
+#define HOF_WATER_LEVEL_KERNEL(filter, srtm) \
+  static int32_t hof_water_level_##filter##_##srtm (KERNEL_STATE *state, void *records, int32_t start, int32_t count, uint8_t *pass, \
+                                                    SHOT_VALUES *values) \
+  { \
+    (void) values; \
+    return (hof_water_level (state, (HYDRO_OUTPUT_T *) records, start, count, pass, filter, srtm)); \
+  }
+
+HOF_TIDE_KERNEL (0)
+HOF_TIDE_KERNEL (1)
+
+HOF_WATER_LEVEL_KERNEL (0, 0)
+HOF_WATER_LEVEL_KERNEL (0, 1)
+HOF_WATER_LEVEL_KERNEL (1, 0)
+HOF_WATER_LEVEL_KERNEL (1, 1)
+
+
+/*  Tables indexed the same way as the instance names.  The emit argument is expanded to its number
+    on the way through HOF_LIST_KERNELS and HOF_LIST_ROW, so both use names like hof_list_1_0_1_0.  */
+
+#define HOF_LIST_NAME(emit, null, filter, shots) hof_list_##emit##_##null##_##filter##_##shots
+#define TOF_LIST_NAME(emit, null, filter) tof_list_##emit##_##null##_##filter
+
+#define HOF_LIST_ROW(emit) \
+  {{{HOF_LIST_NAME (emit, 0, 0, 0), HOF_LIST_NAME (emit, 0, 0, 1)}, {HOF_LIST_NAME (emit, 0, 1, 0), HOF_LIST_NAME (emit, 0, 1, 1)}}, \
+   {{HOF_LIST_NAME (emit, 1, 0, 0), HOF_LIST_NAME (emit, 1, 0, 1)}, {HOF_LIST_NAME (emit, 1, 1, 0), HOF_LIST_NAME (emit, 1, 1, 1)}}}
+
+#define TOF_LIST_ROW(emit) \
+  {{TOF_LIST_NAME (emit, 0, 0), TOF_LIST_NAME (emit, 0, 1)}, {TOF_LIST_NAME (emit, 1, 0), TOF_LIST_NAME (emit, 1, 1)}}
+
+static RECORD_KERNEL hof_list_kernel[4][2][2][2] = {HOF_LIST_ROW (EMIT_DUMP), HOF_LIST_ROW (EMIT_YXZ), HOF_LIST_ROW (EMIT_FIELDS),
+                                                    HOF_LIST_ROW (EMIT_COLUMNAR)};
+
+static RECORD_KERNEL tof_list_kernel[4][2][2] = {TOF_LIST_ROW (EMIT_DUMP), TOF_LIST_ROW (EMIT_YXZ), TOF_LIST_ROW (EMIT_FIELDS),
+                                                 TOF_LIST_ROW (EMIT_COLUMNAR)};
+
+static RECORD_KERNEL hof_tide_kernel[2] = {hof_tide_0, hof_tide_1};
+
+static RECORD_KERNEL hof_water_level_kernel[2][2] = {{hof_water_level_0_0, hof_water_level_0_1}, {hof_water_level_1_0, hof_water_level_1_1}};
+
+
+
+/*  The kernel for a file of type (0 = HOF, 1 = TOF) with these options.  srtm_check is whether the
+    SRTM land mask is available for -w and -W.  */
+
+RECORD_KERNEL kernel_select (OPTIONS *options, int32_t type, uint8_t srtm_check)
+{
+  int32_t            emit = EMIT_DUMP;
+  uint8_t            filter = options->filter.active ? 1 : 0, list_null = options->list_null ? 1 : 0;
+
+
+  if (options->columnar)
+    {
+      emit = EMIT_COLUMNAR;
+    }
+  else if (options->fields)
+    {
+      emit = EMIT_FIELDS;
+    }
+  else if (options->yxz)
+    {
+      emit = EMIT_YXZ;
+    }
+
+  if (type) return (tof_list_kernel[emit][list_null][filter]);
+
+  if (options->tide_check) return (hof_tide_kernel[filter]);
+
+  if (options->water_level) return (hof_water_level_kernel[filter][srtm_check ? 1 : 0]);
+
+  return (hof_list_kernel[emit][list_null][filter][options->shot_data ? 1 : 0]);
+}
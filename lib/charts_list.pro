@@ -0,0 +1,16 @@
+INCLUDEPATH += /c/PFM_ABEv7.0.0_Win64/include
+DEFINES += NVWIN3X
+######################################################################
+# The charts_list library (libcharts_list.a), everything but main.c.
+# Written by ../mk, see ../charts_list_api.h.
+######################################################################
+
+TEMPLATE = lib
+CONFIG += staticlib
+TARGET = charts_list
+DEPENDPATH += ..
+INCLUDEPATH += ..
+
+# Input
+HEADERS += ../charts_list.h ../charts_list_api.h ../version.h
+SOURCES += ../api.c ../audit.c ../columnar.c ../compress.c ../fields.c ../file_cache.c ../file_list.c ../filter.c ../geodesic.c ../grid.c ../jobs.c ../joint.c ../kernels.c ../merge.c ../output.c ../prefetch.c ../process_file.c ../record_list.c ../record_reader.c ../server.c ../shot_reader.c ../srtm_cache.c ../state.c ../stats.c ../summary.c ../water_level.c
@@ -31,33 +31,59 @@
  *
  ********************************************************************/
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <errno.h>
-#include <string.h>
-#include <getopt.h>
-#include <math.h>
-
-
-/* Local Includes. */
-
-#include "nvutility.h"
-
-#include "FileHydroOutput.h"
-#include "FileTopoOutput.h"
-#include "FileWave.h"
-
-#include "version.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "charts_list.h"
+
+
+/*  Codes for the options that only have a long form.  */
+
+#define OPT_COLUMNAR       256
+#define OPT_COLUMNS        257
+#define OPT_FIELDS         258
+#define OPT_DELIMITER      259
+#define OPT_INDEX          260
+#define OPT_SUMMARY        261
+#define OPT_BBOX           262
+#define OPT_POLYGON        263
+#define OPT_TIME           264
+#define OPT_SRTM_CACHE     265
+#define OPT_RADIUS         266
+#define OPT_WINDOWS        267
+#define OPT_MERGE          268
+#define OPT_SOURCE         269
+#define OPT_AUDIT          270
+#define OPT_GRID           271
+#define OPT_GRID_OUT       272
+#define OPT_GRID_RETURN    273
+#define OPT_PREFETCH       274
+#define OPT_STATS          275
+#define OPT_COMPRESS       276
+#define OPT_SERVER         277
+#define OPT_INCREMENTAL    278
+#define OPT_JOINT          279
 
 
 void usage ()
 {
-  fprintf (stderr, "\nUsage: charts_list [-n RECORD NUMBER] [-s] [-t] [-d] [-y] [-w | -W] [-g \"lat,lon\"] HOF_OR_TOF_FILENAME\n");
+  fprintf (stderr, "\nUsage: charts_list [-n RECORDS] [-s] [-t] [-d] [-y] [-w | -W] [-g \"lat,lon\"] [-j WORKERS] [-c CHUNK_RECORDS]\n");
+  fprintf (stderr, "\t[-l LIST_FILE] [-L] [--columnar[=DIR]] [--columns LIST] [--fields LIST [--delimiter C]]\n");
+  fprintf (stderr, "\t[--index] [--summary] [--bbox BOUNDS] [--polygon POLYGON_FILE] [--time START,END]\n");
+  fprintf (stderr, "\t[--srtm-cache MB] [--radius METERS] [--windows SECONDS,...]\n");
+  fprintf (stderr, "\t[--merge [--source]] [--audit[=CONFIDENCE]]\n");
+  fprintf (stderr, "\t[--grid BOUNDS,CELL --grid-out GRID_FILE [--grid-return first|last|both]]\n");
+  fprintf (stderr, "\t[--prefetch DEPTH[,MB]] [--stats[=json]] [--compress gzip[,LEVEL]] [--server SOCKET[,FILES]]\n");
+  fprintf (stderr, "\t[--incremental STATE_DIR] [--joint]\n");
+  fprintf (stderr, "\t[HOF_OR_TOF_FILENAME | DIRECTORY ...]\n");
   fprintf (stderr, "\nWhere:\n\n");
   fprintf (stderr, "\t-s  =  dump the shot data from the associated waveform file (HOF only).\n");
   fprintf (stderr, "\t-t  =  check the entire file for tide corrections.\n");
-  fprintf (stderr, "\t-n  =  list RECORD NUMBER only.\n");
+  fprintf (stderr, "\t-n  =  list RECORDS only.  RECORDS is a comma separated list of\n");
+  fprintf (stderr, "\t\trecord numbers and START:END ranges (START: for the rest\n");
+  fprintf (stderr, "\t\tof the file), or @FILE to read the list from FILE.\n");
+  fprintf (stderr, "\t\tRecords are listed in the order given and contiguous\n");
+  fprintf (stderr, "\t\truns are read in one pass.\n");
   fprintf (stderr, "\t-d  =  don't list null (-998.0) records.\n");
   fprintf (stderr, "\t-y  =  output ASCII Y,X,Z instead of entire record\n");
   fprintf (stderr, "\t-w  =  output water levels (HOF only) averaged over 2 second intervals\n");
@@ -65,118 +91,557 @@ void usage ()
   fprintf (stderr, "\t-g  =  when used with -w or -W, append distance in meters from\n");
   fprintf (stderr, "\t\tthe provided lat,lon position.  The lat,lon position must\n");
   fprintf (stderr, "\t\tbe comma separated.  Latitude and longitude may be in any\n");
-  fprintf (stderr, "\t\tof the following formats:\n\n");
+  fprintf (stderr, "\t\tof the following formats (also the center for --radius):\n\n");
   fprintf (stderr, "\t\t\tHemisphere Degrees Minutes Seconds.decimal\n");
   fprintf (stderr, "\t\t\tHemisphere Degrees Minutes.decimal\n");
   fprintf (stderr, "\t\t\tHemisphere Degrees.decimal\n");
   fprintf (stderr, "\t\t\tSign Degrees Minutes Seconds.decimal\n");
   fprintf (stderr, "\t\t\tSign Degrees Minutes.decimal\n");
   fprintf (stderr, "\t\t\tSign Degrees.decimal\n\n");
-  fprintf (stderr, "\t\tUse the find command to output all of the averaged water level\n");
-  fprintf (stderr, "\t\tvalues from a number of files to a single file.\n\n");
+  fprintf (stderr, "\t-j  =  process files using WORKERS worker processes (0 = one per\n");
+  fprintf (stderr, "\t\tprocessor, default is 1).\n");
+  fprintf (stderr, "\t-l  =  read file and directory names, one per line, from LIST_FILE\n");
+  fprintf (stderr, "\t\t(- for standard input).\n");
+  fprintf (stderr, "\t-L  =  read records one at a time through the CHARTS library instead\n");
+  fprintf (stderr, "\t\tof memory mapping the file.\n");
+  fprintf (stderr, "\t-c  =  with more than one worker, split files into chunks of\n");
+  fprintf (stderr, "\t\tCHUNK_RECORDS records that are processed in parallel (full\n");
+  fprintf (stderr, "\t\tdump, -y, and -d modes only, default is automatic).\n");
+  fprintf (stderr, "\t--columnar  =  instead of listing the records, write the --columns\n");
+  fprintf (stderr, "\t\tfields of each record to a binary columnar file named\n");
+  fprintf (stderr, "\t\tINPUT_FILE.col, beside the input file or in DIR.  -d\n");
+  fprintf (stderr, "\t\tand -n apply.  See columnar.c for the file layout.\n");
+  fprintf (stderr, "\t--columns  =  comma separated HOF and/or TOF field names for\n");
+  fprintf (stderr, "\t\t--columnar (see fields.c).  The default for HOF files is\n");
+  fprintf (stderr, "\t\ttimestamp,latitude,longitude,correct_depth,abdc,data_type,\n");
+  fprintf (stderr, "\t\tkgps_water_level,tide_cor_depth and for TOF files is\n");
+  fprintf (stderr, "\t\ttimestamp,latitude_first,longitude_first,elevation_first,\n");
+  fprintf (stderr, "\t\tlatitude_last,longitude_last,elevation_last.\n");
+  fprintf (stderr, "\t--fields  =  instead of the entire record, list only the comma\n");
+  fprintf (stderr, "\t\tseparated HOF and/or TOF fields (see fields.c), one line\n");
+  fprintf (stderr, "\t\tper record.  Positions are printed with 11 decimal places,\n");
+  fprintf (stderr, "\t\tother floating point fields with 2 (3 for kgps_water_level).\n");
+  fprintf (stderr, "\t--delimiter  =  character to put between --fields values\n");
+  fprintf (stderr, "\t\t(default is a comma, use tab for a tab).\n");
+  fprintf (stderr, "\t--index  =  write a summary sidecar file named INPUT_FILE%s\n", SUMMARY_SUFFIX);
+  fprintf (stderr, "\t\tbeside each input file (see summary.c).  -t and --summary\n");
+  fprintf (stderr, "\t\tuse the sidecar instead of reading the file as long as the\n");
+  fprintf (stderr, "\t\tfile hasn't changed since the sidecar was written.\n");
+  fprintf (stderr, "\t--summary  =  list the record count, time range, bounds, null\n");
+  fprintf (stderr, "\t\tcounts, and data_type/abdc histograms of each file.\n");
+  fprintf (stderr, "\t--bbox  =  only use records inside BOUNDS, given as\n");
+  fprintf (stderr, "\t\tmin_lat,min_lon,max_lat,max_lon in decimal degrees.\n");
+  fprintf (stderr, "\t--polygon  =  only use records inside the polygon in POLYGON_FILE\n");
+  fprintf (stderr, "\t\t(one lat,lon vertex per line in decimal degrees).\n");
+  fprintf (stderr, "\t--time  =  only use records from START to END, each given as\n");
+  fprintf (stderr, "\t\tYYYY-DDD-HH:MM:SS.SS or as a CHARTS timestamp.\n");
+  fprintf (stderr, "\t\tThe filters apply to every output mode but --index and\n");
+  fprintf (stderr, "\t\t--summary.  TOF records are selected by their last return\n");
+  fprintf (stderr, "\t\tposition.  With --index sidecars, blocks of records outside\n");
+  fprintf (stderr, "\t\tthe filter aren't read.\n");
+  fprintf (stderr, "\t--srtm-cache  =  MB of memory for caching the SRTM land mask used\n");
+  fprintf (stderr, "\t\tby -w and -W, shared by all workers (default %d, 0 = off).\n", SRTM_CACHE_DEFAULT_MB);
+  fprintf (stderr, "\t--radius  =  only use records within METERS of the -g position.\n");
+  fprintf (stderr, "\t--windows  =  with -w, average over each of these window widths in\n");
+  fprintf (stderr, "\t\tone pass (at most %d) instead of 2 seconds.  Each line also has\n", WL_MAX_WINDOWS);
+  fprintf (stderr, "\t\tthe window width, number of shots, minimum, maximum, and\n");
+  fprintf (stderr, "\t\tvariance of the water levels averaged.\n");
+  fprintf (stderr, "\t--merge  =  write the water levels (-w unless -W is given) of all\n");
+  fprintf (stderr, "\t\tthe files as one series in time order.  Files other than HOF\n");
+  fprintf (stderr, "\t\tfiles are read as saved -w or -W output, so earlier runs can\n");
+  fprintf (stderr, "\t\tbe merged without reprocessing them.  Each file must already\n");
+  fprintf (stderr, "\t\tbe in time order.\n");
+  fprintf (stderr, "\t--source  =  with --merge, add the source file name to each line.\n");
+  fprintf (stderr, "\t--audit  =  tide correction check (-t) of HOF files with one line per\n");
+  fprintf (stderr, "\t\tfile on stdout:  file,status,checked,zero_tide,percent,\n");
+  fprintf (stderr, "\t\trecords_read,method  (status is tided, untided, no_data, or\n");
+  fprintf (stderr, "\t\terror).  Only the two depth fields are read.  With CONFIDENCE\n");
+  fprintf (stderr, "\t\t(for example 0.99) shots are sampled until the untided fraction\n");
+  fprintf (stderr, "\t\tis above or below 2%% at that confidence.\n");
+  fprintf (stderr, "\t--grid  =  bin HOF correct_depth or TOF elevations into a lat/lon grid\n");
+  fprintf (stderr, "\t\tgiven as min_lat,min_lon,max_lat,max_lon,cell[,cell_lon] in\n");
+  fprintf (stderr, "\t\tdegrees, and write the count, mean, min, max, and standard\n");
+  fprintf (stderr, "\t\tdeviation of each cell to the binary GRID_FILE (--grid-out).\n");
+  fprintf (stderr, "\t\tAll of the files must be HOF or all TOF.  --grid-return picks\n");
+  fprintf (stderr, "\t\tthe TOF returns that are binned (default both).\n");
+  fprintf (stderr, "\t--prefetch  =  keep DEPTH reads of MB megabytes (default %d) in flight\n", PREFETCH_DEFAULT_MB);
+  fprintf (stderr, "\t\tahead of the records being listed (io_uring on Linux, otherwise\n");
+  fprintf (stderr, "\t\tthreads) instead of memory mapping the files.  The time spent\n");
+  fprintf (stderr, "\t\twaiting for I/O is reported for each file.\n");
+  fprintf (stderr, "\t--stats  =  print the run time, CPU time, records and bytes read and\n");
+  fprintf (stderr, "\t\twritten, time spent in each phase (summed over the workers),\n");
+  fprintf (stderr, "\t\tand the number of records rejected for each reason to stderr\n");
+  fprintf (stderr, "\t\twhen the run finishes.  --stats=json prints one JSON object.\n");
+  fprintf (stderr, "\t--compress  =  gzip the standard output at LEVEL (1 - 9, default 6)\n");
+  fprintf (stderr, "\t\tusing one compression thread per processor.  The output is\n");
+  fprintf (stderr, "\t\ta series of gzip members that gunzip reads as one file.\n");
+  fprintf (stderr, "\t--server  =  instead of listing files, answer requests on the Unix\n");
+  fprintf (stderr, "\t\tsocket SOCKET, keeping up to FILES (default %d) files open\n", SERVER_DEFAULT_FILES);
+  fprintf (stderr, "\t\tbetween requests.  Each connection sends one line of -n, -y,\n");
+  fprintf (stderr, "\t\t-d, -s, -w, -W, and -g options and a file name and gets back\n");
+  fprintf (stderr, "\t\tthe same output charts_list would write.  Send quit to stop\n");
+  fprintf (stderr, "\t\tthe server (see server.c).\n");
+  fprintf (stderr, "\t--incremental  =  save the output of each file in STATE_DIR and\n");
+  fprintf (stderr, "\t\treplay it on later runs with the same options instead of\n");
+  fprintf (stderr, "\t\tprocessing the file again, unless the file has changed.\n");
+  fprintf (stderr, "\t\tNot with --columnar or --index (see state.c).\n");
+  fprintf (stderr, "\t--joint  =  list the .hof and .tof files of each flight line together\n");
+  fprintf (stderr, "\t\tin one pass as lat,lon,z,H (HOF) and lat,lon,z,T (TOF) lines\n");
+  fprintf (stderr, "\t\tin time order, with the -y records and numbers (-d drops\n");
+  fprintf (stderr, "\t\tthe nulls), but a TOF single return is listed once.  Files\n");
+  fprintf (stderr, "\t\tare paired by name without the extension (see joint.c).\n\n");
+  fprintf (stderr, "\tAny number of files and directories may be given.  Directories are\n");
+  fprintf (stderr, "\tsearched recursively for .hof and .tof files (.hof only with -s, -t,\n");
+  fprintf (stderr, "\t-w, or -W).  Output for each file is written in one piece, in the\n");
+  fprintf (stderr, "\torder the files were given (sorted by name within a directory),\n");
+  fprintf (stderr, "\tregardless of the number of workers.\n\n");
   fprintf (stderr, "\t\tExample:\n\n");
-  fprintf (stderr, "\t\tfind . -name \\*.hof -exec charts_list -w {} >>output_file.txt \\;\n\n");
-  fprintf (stderr, "\tIf RECORD NUMBER is not specified all records will be listed.\n");
-  fprintf (stderr, "\tIf using -w and appending using the find command make sure that\n");
-  fprintf (stderr, "\toutput_file.txt does not exist prior to running the find command.\n");
+  fprintf (stderr, "\t\tcharts_list -j 0 -w . >output_file.txt\n\n");
+  fprintf (stderr, "\tIf RECORDS is not specified all records will be listed.\n");
   fprintf (stderr, "\t-w, -t, and -n are mutually exclusive.\n\n");
   exit (-1);
 }
 
 
 
-void dump_shot_data (WAVE_DATA_T *wave_data)
+
+
+
+/*  Smallest chunk we'll split a file into.  Below this the fork and copy overhead isn't worth it.  */
+
+#define MIN_CHUNK_RECORDS (16 * READ_BATCH)
+
+
+/*  Batch job data.  Each job is one chunk of one file from the list.  */
+
+typedef struct
+{
+  OPTIONS            *options;
+  FILE_CHUNK         *chunk;
+  int32_t            count;
+} FILE_JOBS;
+
+
+static int32_t file_job (int32_t job, void *data)
+{
+  FILE_JOBS          *jobs = (FILE_JOBS *) data;
+
+
+  return (process_file (jobs->options, jobs->chunk[job].file, jobs->chunk[job].first, jobs->chunk[job].last));
+}
+
+
+
+/*  Build the job list.  Each file is one job unless we have more than one worker and the mode
+    handles every record independently (full dumps, -y, and -d), in which case large files are
+    split into record ranges (not with --incremental, which saves whole files).  Every record
+    still comes out in file order since the jobs are emitted in order.  */
+
+static void build_chunks (OPTIONS *options, FILE_LIST *list, FILE_JOBS *jobs)
 {
-  int32_t            i, j;
-
-  union 
-  {
-    float            f;
-    int32_t          i32;
-    int16_t          i16[2];
-    uint8_t          b[4];
-  } shot;
-    
-
-  for (i = 0 ; i < 24 ; i++)
+  int32_t            i, records, chunk_records, first, size = list->count;
+  uint8_t            split;
+
+
+  split = (options->workers > 1 && options->rec_num == -1 && !options->tide_check && !options->water_level && !options->columnar &&
+           !options->index && !options->summary && !options->audit && options->state_dir == NULL);
+
+  jobs->options = options;
+  jobs->count = 0;
+  jobs->chunk = NULL;
+
+
+  for (i = 0 ; i < list->count ; i++)
     {
-      for (j = 0 ; j < 4 ; j++)
+      records = split ? count_file_records (options, list->name[i]) : -1;
+
+
+      chunk_records = options->chunk_records;
+
+      if (!chunk_records)
         {
-          shot.b[j] = wave_data->shot_data[i * 4 + j];
-        }          
-      printf ("%d %f %d %hd %hd\n", i, shot.f, shot.i32, shot.i16[0], shot.i16[1]);
+          chunk_records = records / (options->workers * 4) + 1;
+          if (chunk_records < MIN_CHUNK_RECORDS) chunk_records = MIN_CHUNK_RECORDS;
+        }
+
+
+      first = 1;
+
+      do
+        {
+          if (jobs->chunk == NULL || jobs->count == size)
+            {
+              size *= 2;
+
+              if ((jobs->chunk = (FILE_CHUNK *) realloc (jobs->chunk, size * sizeof (FILE_CHUNK))) == NULL)
+                {
+                  perror ("Allocating chunk memory");
+                  exit (-1);
+                }
+            }
+
+          jobs->chunk[jobs->count].file = list->name[i];
+          jobs->chunk[jobs->count].first = first;
+          jobs->chunk[jobs->count].last = -1;
+
+          if (records > 0 && first + chunk_records <= records) jobs->chunk[jobs->count].last = first + chunk_records - 1;
+
+          first = jobs->chunk[jobs->count].last + 1;
+          jobs->count++;
+        } while (first > 1);
     }
 }
 
 
 
+/*  --incremental option signature, the version and every option given except the ones that don't
+    change the output of a file.  Files listed under a different signature are processed again.
+    Anything unrecognized (bundled short options, for example) is kept, which at worst costs a
+    replay.  What --polygon and -n @FILE read is added by state_sign_options.  */
+
+static char *state_signature (char **argv, int32_t optind)
+{
+  static char        *skip[] = {"-j", "-c", "-l", "-L", "--stats", "--prefetch", "--compress", "--incremental", "--srtm-cache", NULL};
+  static char        *skip_arg[] = {"-j", "-c", "-l", "--prefetch", "--compress", "--incremental", "--srtm-cache", NULL};
+  char               *signature;
+  int32_t            i, j, size;
+  uint8_t            keep;
+
+
+  for (i = 1, size = strlen (VERSION) + 2 ; i < optind ; i++) size += strlen (argv[i]) + 1;
+
+  if ((signature = (char *) malloc (size)) == NULL)
+    {
+      perror ("Allocating signature memory");
+      exit (-1);
+    }
+
+  strcpy (signature, VERSION);
+
+
+  for (i = 1 ; i < optind ; i++)
+    {
+      keep = NVTrue;
+
+      for (j = 0 ; skip[j] != NULL ; j++)
+        {
+          if (!strncmp (argv[i], skip[j], strlen (skip[j])))
+            {
+              keep = NVFalse;
+              break;
+            }
+        }
+
+      if (keep)
+        {
+          strcat (signature, "\n");
+          strcat (signature, argv[i]);
+          continue;
+        }
+
+
+      /*  The option's value was the next argument.  */
+
+      for (j = 0 ; skip_arg[j] != NULL ; j++) if (!strcmp (argv[i], skip_arg[j]) && i + 1 < optind) i++;
+    }
+
+  return (signature);
+}
+
+
+
 int32_t main (int32_t argc, char **argv)
 {
-  char               file[512], tmp_file[512], wave_file[512], string[1024], cut[1024];
-  int32_t            type = 0, rec_num = -1, i, total = 0, zero_tide = 0, wl_count = 0, year, jday, hour, minute;
-  int64_t            timestamp, start_time = -1, last_time = -1;
-  double             sum = 0.0, sumlat = 0.0, sumlon = 0.0, lat, lon, dist, az, per_ten_sec = 10000.0;
-  float              second, level;
-  NV_F64_COORD2      geo = {-999.0, -999.0};
-  FILE               *fp = NULL, *wfp = NULL;
-  HOF_HEADER_T       hof_header;
-  HYDRO_OUTPUT_T     hof;
-  TOPO_OUTPUT_T      tof;
-  WAVE_HEADER_T      wave_header;
-  WAVE_DATA_T        wave_data;
-  uint8_t            tide_check = NVFalse, list_null = NVTrue, water_level = NVFalse, average = NVTrue, yxz = NVFalse, shot_data = NVFalse, geo_check = NVFalse,
-                     srtm_check = NVFalse;
-  char               c;
+  char               string[1024], cut[1024], *list_file = NULL, *column_list = NULL, *field_list = NULL, *comma, delimiter = ',';
+  int32_t            i, failed;
+  double             radius = -1.0;
+  OPTIONS            options;
+  FILE_LIST          list;
+  FILE_JOBS          jobs;
+  FILE               **spool;
+  uint8_t            hof_only;
+  int32_t            c, option_index;
   extern char        *optarg;
   extern int         optind;
+  static struct option long_options[] = {{"columnar", optional_argument, 0, OPT_COLUMNAR},
+                                         {"columns", required_argument, 0, OPT_COLUMNS},
+                                         {"fields", required_argument, 0, OPT_FIELDS},
+                                         {"delimiter", required_argument, 0, OPT_DELIMITER},
+                                         {"index", no_argument, 0, OPT_INDEX},
+                                         {"summary", no_argument, 0, OPT_SUMMARY},
+                                         {"bbox", required_argument, 0, OPT_BBOX},
+                                         {"polygon", required_argument, 0, OPT_POLYGON},
+                                         {"time", required_argument, 0, OPT_TIME},
+                                         {"srtm-cache", required_argument, 0, OPT_SRTM_CACHE},
+                                         {"radius", required_argument, 0, OPT_RADIUS},
+                                         {"windows", required_argument, 0, OPT_WINDOWS},
+                                         {"merge", no_argument, 0, OPT_MERGE},
+                                         {"source", no_argument, 0, OPT_SOURCE},
+                                         {"audit", optional_argument, 0, OPT_AUDIT},
+                                         {"grid", required_argument, 0, OPT_GRID},
+                                         {"grid-out", required_argument, 0, OPT_GRID_OUT},
+                                         {"grid-return", required_argument, 0, OPT_GRID_RETURN},
+                                         {"prefetch", required_argument, 0, OPT_PREFETCH},
+                                         {"stats", optional_argument, 0, OPT_STATS},
+                                         {"compress", required_argument, 0, OPT_COMPRESS},
+                                         {"server", required_argument, 0, OPT_SERVER},
+                                         {"incremental", required_argument, 0, OPT_INCREMENTAL},
+                                         {"joint", no_argument, 0, OPT_JOINT},
+                                         {0, no_argument, 0, 0}};
 
 
   fprintf (stderr, "\n\n %s \n\n\n", VERSION);
 
 
-  while ((c = getopt (argc, argv, "tdwWysn:g:")) != EOF)
+  options.rec_num = -1;
+  record_list_init (&options.records);
+  options.tide_check = NVFalse;
+  options.list_null = NVTrue;
+  options.water_level = NVFalse;
+  options.average = NVTrue;
+  options.yxz = NVFalse;
+  options.shot_data = NVFalse;
+  options.geo_check = NVFalse;
+  options.geo.x = options.geo.y = -999.0;
+  options.workers = 1;
+  options.use_library = NVFalse;
+  options.chunk_records = 0;
+  options.columnar = NVFalse;
+  options.columnar_dir = NULL;
+  options.fields = NVFalse;
+  options.index = NVFalse;
+  options.summary = NVFalse;
+  filter_init (&options.filter);
+  options.srtm_cache_mb = SRTM_CACHE_DEFAULT_MB;
+  options.wl_num_windows = 1;
+  options.wl_width[0] = 2000000;
+  options.wl_stats = NVFalse;
+  options.merge = NVFalse;
+  options.merge_source = NVFalse;
+  options.audit = NVFalse;
+  options.audit_confidence = 0.0;
+  options.gridding = NVFalse;
+  options.grid.returns = GRID_FIRST_RETURN | GRID_LAST_RETURN;
+  options.grid.out = NULL;
+  options.prefetch_depth = 0;
+  options.prefetch_mb = PREFETCH_DEFAULT_MB;
+  options.stats = STATS_OFF;
+  options.compress = NVFalse;
+  options.compress_level = 6;
+  options.server = NULL;
+  options.server_files = SERVER_DEFAULT_FILES;
+  options.state_dir = NULL;
+  options.state_signature = NULL;
+  options.joint = NVFalse;
+  options.quiet = NVFalse;
+  options.wl_func = NULL;
+  options.wl_data = NULL;
+
+
+  while ((c = getopt_long (argc, argv, "tdwWysLn:g:j:l:c:", long_options, &option_index)) != EOF)
     {
       switch (c)
         {
         case 's':
-          shot_data = NVTrue;
+          options.shot_data = NVTrue;
           break;
 
         case 't':
-          tide_check = NVTrue;
+          options.tide_check = NVTrue;
           break;
 
         case 'd':
-          list_null = NVFalse;
+          options.list_null = NVFalse;
           break;
 
         case 'y':
-          yxz = NVTrue;
+          options.yxz = NVTrue;
           break;
 
         case 'n':
-          sscanf (optarg, "%d", &rec_num);
+          if (record_list_parse (&options.records, optarg)) exit (-1);
+          options.rec_num = options.records.range[0].first;
           break;
 
         case 'w':
-          water_level = NVTrue;
-          average = NVTrue;
+          options.water_level = NVTrue;
+          options.average = NVTrue;
           break;
 
         case 'W':
-          water_level = NVTrue;
-          average = NVFalse;
+          options.water_level = NVTrue;
+          options.average = NVFalse;
           break;
 
         case 'g':
           strcpy (string, optarg);
 
           strcpy (cut, strtok (string, ","));
-          posfix (cut, &geo.y, POS_LAT);
+          posfix (cut, &options.geo.y, POS_LAT);
           strcpy (cut, strtok (NULL, ","));
-          posfix (cut, &geo.x, POS_LON);
+          posfix (cut, &options.geo.x, POS_LON);
+
+          options.geo_check = NVTrue;
+          break;
+
+        case 'j':
+          sscanf (optarg, "%d", &options.workers);
+          break;
+
+        case 'c':
+          sscanf (optarg, "%d", &options.chunk_records);
+          if (options.chunk_records < 0) options.chunk_records = 0;
+          break;
+
+        case 'l':
+          list_file = optarg;
+          break;
+
+        case 'L':
+          options.use_library = NVTrue;
+          break;
+
+        case OPT_COLUMNAR:
+          options.columnar = NVTrue;
+          options.columnar_dir = optarg;
+          break;
+
+        case OPT_COLUMNS:
+          column_list = optarg;
+          break;
+
+        case OPT_FIELDS:
+          options.fields = NVTrue;
+          field_list = optarg;
+          break;
+
+        case OPT_DELIMITER:
+          if (!strcmp (optarg, "tab") || !strcmp (optarg, "\\t"))
+            {
+              delimiter = '\t';
+            }
+          else if (optarg[0])
+            {
+              delimiter = optarg[0];
+            }
+          break;
+
+        case OPT_INDEX:
+          options.index = NVTrue;
+          break;
+
+        case OPT_SUMMARY:
+          options.summary = NVTrue;
+          break;
+
+        case OPT_BBOX:
+          if (filter_parse_bbox (&options.filter, optarg)) exit (-1);
+          break;
+
+        case OPT_POLYGON:
+          if (filter_read_polygon (&options.filter, optarg)) exit (-1);
+          break;
+
+        case OPT_TIME:
+          if (filter_parse_time (&options.filter, optarg)) exit (-1);
+          break;
+
+        case OPT_SRTM_CACHE:
+          sscanf (optarg, "%d", &options.srtm_cache_mb);
+          if (options.srtm_cache_mb < 0) options.srtm_cache_mb = 0;
+          break;
+
+        case OPT_RADIUS:
+          sscanf (optarg, "%lf", &radius);
+          break;
 
-          geo_check = NVTrue;
+        case OPT_WINDOWS:
+          if (wl_parse_windows (&options, optarg)) usage ();
+          break;
+
+        case OPT_MERGE:
+          options.merge = NVTrue;
+          break;
+
+        case OPT_SOURCE:
+          options.merge_source = NVTrue;
+          break;
+
+        case OPT_AUDIT:
+          options.audit = NVTrue;
+          if (optarg != NULL && (sscanf (optarg, "%lf", &options.audit_confidence) != 1 || options.audit_confidence <= 0.0 ||
+                                 options.audit_confidence >= 1.0)) usage ();
+          break;
+
+        case OPT_GRID:
+          if (grid_parse (&options.grid, optarg)) exit (-1);
+          options.gridding = NVTrue;
+          break;
+
+        case OPT_GRID_OUT:
+          options.grid.out = optarg;
+          break;
+
+        case OPT_PREFETCH:
+          if (sscanf (optarg, "%d,%d", &options.prefetch_depth, &options.prefetch_mb) < 1 || options.prefetch_depth < 0 ||
+              options.prefetch_mb < 1) usage ();
+          break;
+
+        case OPT_STATS:
+          if (optarg == NULL)
+            {
+              options.stats = STATS_TEXT;
+            }
+          else if (!strcmp (optarg, "json"))
+            {
+              options.stats = STATS_JSON;
+            }
+          else
+            {
+              usage ();
+            }
+          break;
+
+        case OPT_COMPRESS:
+          if (strncmp (optarg, "gzip", 4) || (optarg[4] && (optarg[4] != ',' || sscanf (&optarg[5], "%d", &options.compress_level) != 1 ||
+                                                               options.compress_level < 1 || options.compress_level > 9))) usage ();
+          options.compress = NVTrue;
+          break;
+
+        case OPT_SERVER:
+          options.server = optarg;
+          if ((comma = strchr (optarg, ',')) != NULL)
+            {
+              *comma = 0;
+              if (sscanf (comma + 1, "%d", &options.server_files) != 1 || options.server_files < 1) usage ();
+            }
+          break;
+
+        case OPT_INCREMENTAL:
+          options.state_dir = optarg;
+          break;
+
+        case OPT_JOINT:
+          options.joint = NVTrue;
+          break;
+
+        case OPT_GRID_RETURN:
+          if (!strcmp (optarg, "first"))
+            {
+              options.grid.returns = GRID_FIRST_RETURN;
+            }
+          else if (!strcmp (optarg, "last"))
+            {
+              options.grid.returns = GRID_LAST_RETURN;
+            }
+          else if (!strcmp (optarg, "both"))
+            {
+              options.grid.returns = GRID_FIRST_RETURN | GRID_LAST_RETURN;
+            }
+          else
+            {
+              usage ();
+            }
           break;
 
         default:
@@ -186,303 +651,232 @@ int32_t main (int32_t argc, char **argv)
     }
 
 
-  /* Make sure we got the mandatory file name argument.  */
+  /*  --server gets its files and listing options from the requests.  */
+
+  if (options.server != NULL)
+    {
+      if (optind < argc || list_file != NULL || options.merge || options.audit || options.gridding || options.columnar || options.fields ||
+          options.index || options.summary || options.compress || options.tide_check || options.water_level || options.shot_data ||
+          options.yxz || options.rec_num != -1 || options.geo_check || radius >= 0.0 || options.state_dir != NULL || options.joint) usage ();
+
+      srtm_cache_init (options.srtm_cache_mb);
+
+      if (!options.use_library) reader_set_prefetch (options.prefetch_depth, options.prefetch_mb);
+
+      failed = server_run (&options, options.server, options.server_files);
+
+      srtm_cache_free ();
+      filter_free (&options.filter);
+
+      if (failed) return (-1);
+
+      return (0);
+    }
+
+
+  /* Make sure we got at least one file name argument.  */
+
+  if (optind >= argc && list_file == NULL) usage ();
+
+
+  /*  --merge is always a water level run, -w unless -W was given.  */
+
+  if (options.merge && !options.water_level)
+    {
+      options.water_level = NVTrue;
+      options.average = NVTrue;
+    }
+
+  if (options.merge_source && !options.merge) usage ();
+
+  if (options.merge && (options.tide_check || options.shot_data || options.yxz)) usage ();
 
-  if (optind >= argc) usage ();
+  if (options.audit && (options.tide_check || options.water_level || options.shot_data || options.columnar || options.fields ||
+                        options.yxz || options.index || options.summary || options.rec_num != -1)) usage ();
 
-  if (geo_check && !water_level) usage ();
+  if (options.gridding != (options.grid.out != NULL)) usage ();
 
-  if (tide_check || water_level) rec_num = -1;
+  if (options.gridding && (options.tide_check || options.water_level || options.shot_data || options.columnar || options.fields ||
+                           options.yxz || options.index || options.summary || options.audit || options.rec_num != -1)) usage ();
 
+  if (options.geo_check && !options.water_level && radius < 0.0) usage ();
 
-  strcpy (file, argv[optind]);
+  if (options.state_dir != NULL && (options.columnar || options.index)) usage ();
 
+  if (options.joint && (options.tide_check || options.water_level || options.shot_data || options.columnar || options.fields ||
+                        options.yxz || options.index || options.summary || options.audit || options.merge || options.gridding ||
+                        options.rec_num != -1 || options.state_dir != NULL)) usage ();
 
-  if (strstr (file, ".hof"))
+  if (options.state_dir != NULL)
     {
-      if ((fp = open_hof_file (file)) == NULL)
+      if (mkdir (options.state_dir, 0755) && errno != EEXIST)
         {
-          perror (file);
+          perror (options.state_dir);
           exit (-1);
         }
-      type = 0;
 
+      options.state_signature = state_signature (argv, optind);
+      state_sign_options (&options);
+    }
 
-      if (water_level)
-        {
-          srtm_check = NVFalse;
-          if (!check_srtm_mask (3)) srtm_check = NVTrue;
+  if (radius >= 0.0 && !options.geo_check) usage ();
 
-          printf ("#%s\n", file);
-        }
+  if (options.wl_stats && (!options.water_level || !options.average)) usage ();
 
+  if (options.geo_check) geo_distance_init (&options.geo_ref, options.geo.y, options.geo.x);
 
-      hof_read_header (fp, &hof_header);
+  if (radius >= 0.0) filter_set_radius (&options.filter, options.geo.y, options.geo.x, radius);
 
-      last_time = -1;
+  if (options.tide_check || options.water_level) options.rec_num = -1;
 
-      per_ten_sec = (double) hof_header.text.system_rep_rate * 10.0L;
+  if (options.columnar && (options.tide_check || options.water_level || options.shot_data)) usage ();
 
+  if (options.fields && (options.tide_check || options.water_level || options.columnar || options.yxz)) usage ();
 
-      if (shot_data)
-        {
-          strcpy (wave_file, file);
-          sprintf (&wave_file[strlen (wave_file) - 4], ".inh");
+  if ((options.index || options.summary) && (options.tide_check || options.water_level || options.shot_data || options.columnar ||
+                                             options.fields || options.yxz || options.rec_num != -1 || options.filter.active)) usage ();
 
-          wfp = open_wave_file (wave_file);
 
-          if (wfp == NULL)
-            {
-              perror (wave_file);
-              exit (-1);
-            }
+  /*  Resolve the column names once for each record type.  A name that only exists for one type
+      is reported when a file of the other type is processed.  */
 
-          wave_read_header (wfp, &wave_header);
-        }
-    }
-  else if (strstr (file, ".tof"))
+  if (options.columnar)
     {
-      if (water_level)
+      field_set_parse (&options.hof_columns, 0, column_list);
+      field_set_parse (&options.tof_columns, 1, column_list);
+
+      if (options.hof_columns.count < 0 && options.tof_columns.count < 0)
         {
-          fprintf (stderr, "\nCannot get water level from TOF files - Doh!\n\n");
+          fprintf (stderr, "\nUnknown field %s\n\n", options.hof_columns.bad);
           exit (-1);
         }
+    }
 
 
-      if (tide_check)
-        {
-          fprintf (stderr, "\nCannot tide check TOF files - Doh!\n\n");
-          exit (-1);
-        }
+  /*  Same for --fields, and build the formatters the record loops use.  */
+
+  if (options.fields)
+    {
+      field_set_parse (&options.hof_fields, 0, field_list);
+      field_set_parse (&options.tof_fields, 1, field_list);
 
-      if ((fp = open_tof_file (file)) == NULL)
+      if (options.hof_fields.count < 0 && options.tof_fields.count < 0)
         {
-          perror (file);
+          fprintf (stderr, "\nUnknown field %s\n\n", options.hof_fields.bad);
           exit (-1);
         }
-      type = 1;
-    }
-  else
-    {
-      fprintf (stderr,"\nUnknown file extension %s\n", file);
-      exit (-1);
+
+      output_compile_fields (&options.hof_fields, delimiter, &options.hof_format);
+      output_compile_fields (&options.tof_fields, delimiter, &options.tof_format);
     }
 
 
-  if (type && shot_data) usage ();
+  /*  Directory searches skip TOF files in the modes that only work on HOF files.  */
+
+  hof_only = (options.shot_data || options.tide_check || options.water_level || options.audit);
+
 
+  file_list_init (&list);
 
-  fprintf (stderr, "\n\nFile : %s\n\n", file);
+  for (i = optind ; i < argc ; i++) file_list_add (&list, argv[i], hof_only);
 
+  if (list_file != NULL && file_list_read (&list, list_file, hof_only)) exit (-1);
 
-  if (rec_num != -1)
+  if (!list.count)
     {
-      fprintf (stderr, "\n\n");
+      fprintf (stderr, "\nNo HOF or TOF files found\n\n");
+      exit (-1);
+    }
 
 
-      if (type)
+  if (options.shot_data)
+    {
+      for (i = 0 ; i < list.count ; i++)
         {
-          tof_read_record (fp, rec_num, &tof);
+          if (!strstr (list.name[i], ".hof") && strstr (list.name[i], ".tof")) usage ();
+        }
+    }
 
-          if (list_null || tof.elevation_last != -998.0)
-            {
-              if (yxz)
-                {
-                  if (tof.elevation_first != -998.0) printf ("%.11f,%.11f,%.2f\n", tof.latitude_first, tof.longitude_first, tof.elevation_first);
-                  printf ("%.11f,%.11f,%.2f\n", tof.latitude_last, tof.longitude_last, tof.elevation_last);
-                }
-              else
-                {
-                  tof_dump_record (&tof);
-                }
 
-              timestamp = tof.timestamp;
+  /*  A grid holds either depths or elevations, not both.  */
+
+  if (options.gridding)
+    {
+      options.grid.value_type = strstr (list.name[0], ".tof") ? 1 : 0;
+
+      for (i = 1 ; i < list.count ; i++)
+        {
+          if ((strstr (list.name[i], ".tof") ? 1 : 0) != options.grid.value_type)
+            {
+              fprintf (stderr, "\nCan't grid HOF and TOF files together\n\n");
+              exit (-1);
             }
         }
-      else
-        {
-          hof_read_record (fp, rec_num, &hof);
+    }
 
-          if (list_null || hof.correct_depth != -998.0)
-            {
-              if (shot_data)
-                {
-                  wave_read_record (wfp, rec_num, &wave_data);
 
-                  dump_shot_data (&wave_data);
-                }
+  options.workers = get_worker_count (options.workers);
 
-              if (yxz)
-                {
-                  printf ("%.11f,%.11f,%.2f\n", hof.latitude, hof.longitude, hof.correct_depth);
-                }
-              else
-                {
-                  hof_dump_record (&hof);
-                }
 
-              timestamp = hof.timestamp;
-            }
-        }
+  /*  The SRTM mask cache has to exist before the workers are forked so that they share it.  */
 
-      remove (tmp_file);
+  if (options.water_level) srtm_cache_init (options.srtm_cache_mb);
+
+  if (!options.use_library) reader_set_prefetch (options.prefetch_depth, options.prefetch_mb);
+
+  stats_init (options.stats);
+
+  if (options.compress && compress_start (options.compress_level, get_worker_count (0))) exit (-1);
+
+  jobs.chunk = NULL;
+
+  if (options.merge)
+    {
+      failed = merge_files (&options, &list);
     }
-  else
+  else if (options.joint)
+    {
+      failed = joint_files (&options, &list);
+    }
+  else if (options.gridding)
     {
-      /*
-       * Read all of the data from this file.  
-       */
+      build_chunks (&options, &list, &jobs);
 
-      if (type)
+      if ((spool = (FILE **) malloc (jobs.count * sizeof (FILE *))) == NULL)
         {
-          while (tof_read_record (fp, TOF_NEXT_RECORD, &tof))
-            {
-              if (list_null || tof.elevation_last != -998.0)
-                {
-                  if (yxz)
-                    {
-                      if (tof.elevation_first != -998.0) printf ("%.11f,%.11f,%.2f\n", tof.latitude_first, tof.longitude_first, tof.elevation_first);
-                      printf ("%.11f,%.11f,%.2f\n", tof.latitude_last, tof.longitude_last, tof.elevation_last);
-                    }
-                  else
-                    {
-                      tof_dump_record (&tof);
-                    }
-                }
-            }
+          perror ("Allocating job memory");
+          exit (-1);
         }
-      else
-        {
-          for (i = 0 ; i < hof_header.text.number_shots ; i++)
-            {
-              hof_read_record (fp, i + 1, &hof);
 
-              if (tide_check)
-                {
-                  if (hof.reported_depth != -998.0)
-                    {
-                      if ((hof.reported_depth + hof.tide_cor_depth) == 0.0) zero_tide++;
-                      total++;
-                    }
-                }
-              else if (water_level)
-                {
-                  /*  Valid depth, valid water level, KGPS, not Shoreline Depth Swapped, not Shallow Water Algorithm, greater than 70 (70 = land),
-                      skip the first and last ten seconds, and check SRTM land mask.  */
-
-                  if (hof.correct_depth != -998.0 && hof.kgps_water_level != -998.0 && hof.data_type == 1 && hof.abdc != 72 &&
-                      hof.abdc != 74 && hof.abdc > 70 && i > per_ten_sec && i < hof_header.text.number_shots - per_ten_sec)
-                    {
-                      if (srtm_check && !read_srtm_mask (hof.latitude, hof.longitude))
-                        {
-                          if (start_time < 0) start_time = hof.timestamp;
-
-
-                          /*  If we're averaging and we encounter more than a second of bad data we don't want to use this section.  */
-
-                          if (average && hof.timestamp - last_time > 1000000)
-                            {
-                              start_time = hof.timestamp;
-
-                              sum = 0.0;
-                              sumlat = 0.0;
-                              sumlon = 0.0;
-                              wl_count = 0;
-                            }
-
-                          if ((!average || hof.timestamp - start_time > 2000000) && last_time != -1)
-                            {
-                              timestamp = start_time + (last_time - start_time) / 2;
-                              start_time = timestamp;
-
-                              if (average)
-                                {
-                                  level = (float) (sum / (double) wl_count);
-                                  lat = sumlat / (double) wl_count;
-                                  lon = sumlon / (double) wl_count;
-                                }
-                              else
-                                {
-                                  level = hof.kgps_water_level;
-                                  lat = hof.latitude;
-                                  lon = hof.longitude;
-                                }
-
-                              charts_cvtime (timestamp, &year, &jday, &hour, &minute, &second);
-
-                              if (geo_check)
-                                {
-                                  invgp (NV_A0, NV_B0, geo.y, geo.x, lat, lon, &dist, &az);
-
-                                  printf ("%.9f %.9f %d %03d %02d:%02d:%05.2f %.3f %.3f\n", lat, lon, year + 1900, jday, hour, minute, second, level, dist);
-                                }
-                              else
-                                {
-                                  printf ("%.9f %.9f %d %03d %02d:%02d:%05.2f %.3f\n", lat, lon, year + 1900, jday, hour, minute, second, level);
-                                }
-
-                              sum = 0.0;
-                              sumlat = 0.0;
-                              sumlon = 0.0;
-                              wl_count = 0;
-                            }
-
-                          wl_count++;
-                          sum += hof.kgps_water_level;
-                          sumlat += hof.latitude;
-                          sumlon += hof.longitude;
-                          last_time = hof.timestamp;
-                        }
-                    }
-                  else
-                    {
-                      if (hof.data_type != 1)
-                        {
-                          fprintf (stderr, "\nCannot get water level from non-KGPS HOF files - Doh!\n\n");
-                          exit (-1);
-                        }
-                    }
-                }
-              else
-                {
-                  if (list_null || hof.correct_depth != -998.0)
-                    {
-                      if (shot_data)
-                        {
-                          wave_read_record (wfp, i + 1, &wave_data);
-
-                          dump_shot_data (&wave_data);
-                        }
-
-                      if (yxz)
-                        {
-                          printf ("%.11f,%.11f,%.2f\n", hof.latitude, hof.longitude, hof.correct_depth);
-                        }
-                      else
-                        {
-                          hof_dump_record (&hof);
-                        }
-                    }
-                }
-            }
-        }
+      failed = run_spooled_jobs (jobs.count, options.workers, file_job, &jobs, spool);
+
+      if (grid_merge (&options.grid, spool, jobs.count)) failed++;
+
+      free (spool);
+    }
+  else
+    {
+      build_chunks (&options, &list, &jobs);
+
+      if (options.audit) printf ("#file,status,checked,zero_tide,percent,records_read,method\n");
+
+      failed = run_ordered_jobs (jobs.count, options.workers, file_job, &jobs);
     }
 
 
-    fclose (fp);
+  free (jobs.chunk);
+  file_list_free (&list);
+  filter_free (&options.filter);
+  record_list_free (&options.records);
+  srtm_cache_free ();
+  free (options.state_signature);
 
+  if (compress_finish ()) failed++;
 
-    if (tide_check)
-      {
-        i = ((float) zero_tide / (float) total) * 100.0;
+  stats_report ();
 
-        if (i > 1)
-          {
-            fprintf (stderr, "\nFile : %s not tide corrected\n", file);
-            fprintf (stderr, "Total = %d, no tide correction = %d\n", total, zero_tide);
-          }
-      }
 
+  if (failed) return (-1);
 
-    return (0);
+  return (0);
 }
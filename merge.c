@@ -0,0 +1,420 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : merge.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --merge, one time ordered water level series from many
+ *               files.
+ *
+ *               HOF files are run through process_file (-w or -W) on the
+ *               worker pool with each file's output kept in its own
+ *               temporary file.  Any other file is taken to be the saved -w
+ *               or -W output of earlier runs.  Each file's samples are
+ *               already in time order, so the streams are merged with a
+ *               binary heap keyed on the sample time.  Only the current line
+ *               of each stream is held in memory.  Samples with the same time
+ *               come out in the order the files were given.  Large lists are
+ *               merged in groups through temporary runs so the number of open
+ *               files stays under the descriptor limit (see merge_files).
+ *
+ *               The "#file" lines are dropped.  With --source the name of the
+ *               file each sample came from is added as the last column.
+ *
+ ********************************************************************/
+
+#ifndef NVWIN3X
+#include <sys/resource.h>
+#endif
+
+#include "charts_list.h"
+
+
+#define MERGE_LINE         1024
+#define MERGE_FAN_IN       256                 /*  most streams merged at once  */
+#define MERGE_RESERVED_FDS 16                  /*  descriptors left for stdio, the CHARTS library, and so on  */
+
+
+typedef struct
+{
+  FILE               *fp;
+  char               *source;                    /*  from the last "#file" line, or the file name  */
+  char               line[MERGE_LINE];
+  int64_t            key;                        /*  sample time in hundredths of a second  */
+  uint8_t            unordered;                  /*  already warned that the file isn't in time order  */
+} MERGE_STREAM;
+
+
+typedef struct
+{
+  OPTIONS            *options;
+  char               **name;
+} MERGE_JOBS;
+
+
+
+static int32_t merge_job (int32_t job, void *data)
+{
+  MERGE_JOBS         *jobs = (MERGE_JOBS *) data;
+
+
+  return (process_file (jobs->options, jobs->name[job], 1, -1));
+}
+
+
+
+/*  Read the next sample line from a stream.  Returns 0, or -1 at the end of the stream.  */
+
+static int32_t merge_next (MERGE_STREAM *stream)
+{
+  int32_t            len, year, jday, hour, minute;
+  int64_t            key;
+  double             second;
+
+
+  while (fgets (stream->line, MERGE_LINE, stream->fp))
+    {
+      len = strlen (stream->line);
+      while (len && (stream->line[len - 1] == '\n' || stream->line[len - 1] == '\r')) stream->line[--len] = 0;
+
+
+      if (stream->line[0] == '#')
+        {
+          free (stream->source);
+          stream->source = strdup (&stream->line[1]);
+          continue;
+        }
+
+
+      /*  lat lon year jday hh:mm:ss.ss level ...  */
+
+      if (sscanf (stream->line, "%*s %*s %d %d %d:%d:%lf", &year, &jday, &hour, &minute, &second) != 5) continue;
+
+      key = ((((int64_t) year * 1000 + jday) * 24 + hour) * 60 + minute) * 6000 + (int64_t) (second * 100.0 + 0.5);
+
+      if (key < stream->key && !stream->unordered)
+        {
+          fprintf (stderr, "\n%s is not in time order, the merged output won't be either\n\n", stream->source);
+          stream->unordered = NVTrue;
+        }
+
+      stream->key = key;
+
+      return (0);
+    }
+
+  return (-1);
+}
+
+
+
+/*  Heap order, earlier time first and then earlier file.  */
+
+static inline uint8_t merge_before (MERGE_STREAM *stream, int32_t a, int32_t b)
+{
+  return (stream[a].key < stream[b].key || (stream[a].key == stream[b].key && a < b));
+}
+
+
+
+static void merge_down (MERGE_STREAM *stream, int32_t *heap, int32_t count, int32_t i)
+{
+  int32_t            child, top = heap[i];
+
+
+  while ((child = 2 * i + 1) < count)
+    {
+      if (child + 1 < count && merge_before (stream, heap[child + 1], heap[child])) child++;
+
+      if (!merge_before (stream, heap[child], top)) break;
+
+      heap[i] = heap[child];
+      i = child;
+    }
+
+  heap[i] = top;
+}
+
+
+
+/*  Number of streams merged at once.  Each HOF stream is a temporary file, so a group of files
+    needs about twice this many descriptors (the group's spools plus the runs so far), and the
+    workers need two each.  The soft RLIMIT_NOFILE is raised to the hard limit first.  */
+
+static int32_t merge_fan_in (OPTIONS *options)
+{
+  int32_t            fan_in = MERGE_FAN_IN;
+
+
+#ifndef NVWIN3X
+
+  struct rlimit      limit;
+  int64_t            free_fds;
+
+
+  if (!getrlimit (RLIMIT_NOFILE, &limit))
+    {
+      if (limit.rlim_cur < limit.rlim_max)
+        {
+          limit.rlim_cur = limit.rlim_max;
+          if (setrlimit (RLIMIT_NOFILE, &limit)) getrlimit (RLIMIT_NOFILE, &limit);
+        }
+
+      if (limit.rlim_cur != RLIM_INFINITY)
+        {
+          free_fds = (int64_t) limit.rlim_cur - MERGE_RESERVED_FDS - 2 * options->workers;
+
+          if (free_fds / 2 < fan_in) fan_in = free_fds / 2;
+        }
+    }
+
+#endif
+
+  if (fan_in < 2) fan_in = 2;
+
+  return (fan_in);
+}
+
+
+
+/*  Merge count streams (closing them) to out.  With runs the output is another stream, with a
+    "#source" line whenever the source changes, otherwise it's the final --merge output.  */
+
+static void merge_streams (OPTIONS *options, MERGE_STREAM *stream, int32_t num_streams, FILE *out, uint8_t runs)
+{
+  int32_t            *heap, i, count = 0;
+  char               *last = NULL;
+
+
+  if ((heap = (int32_t *) malloc (num_streams * sizeof (int32_t))) == NULL)
+    {
+      perror ("Allocating merge memory");
+      exit (-1);
+    }
+
+  for (i = 0 ; i < num_streams ; i++)
+    {
+      stream[i].key = INT64_MIN;
+
+      if (stream[i].fp != NULL && !merge_next (&stream[i])) heap[count++] = i;
+    }
+
+  for (i = count / 2 - 1 ; i >= 0 ; i--) merge_down (stream, heap, count, i);
+
+
+  while (count)
+    {
+      i = heap[0];
+
+      if (runs)
+        {
+          if (last == NULL || strcmp (last, stream[i].source))
+            {
+              fprintf (out, "#%s\n", stream[i].source);
+              free (last);
+              last = strdup (stream[i].source);
+            }
+
+          fprintf (out, "%s\n", stream[i].line);
+        }
+      else if (options->merge_source)
+        {
+          fprintf (out, "%s %s\n", stream[i].line, stream[i].source);
+        }
+      else
+        {
+          fprintf (out, "%s\n", stream[i].line);
+        }
+
+      if (merge_next (&stream[i])) heap[0] = heap[--count];
+
+      if (count) merge_down (stream, heap, count, 0);
+    }
+
+
+  for (i = 0 ; i < num_streams ; i++)
+    {
+      if (stream[i].fp != NULL) fclose (stream[i].fp);
+      stream[i].fp = NULL;
+      free (stream[i].source);
+      stream[i].source = NULL;
+      stream[i].unordered = NVFalse;
+    }
+
+  free (last);
+  free (heap);
+}
+
+
+
+/*  Merge runs into one new run, which becomes runs[0].  */
+
+static void merge_runs (OPTIONS *options, MERGE_STREAM *stream, FILE **runs, int32_t num_runs)
+{
+  FILE               *fp;
+  int32_t            i;
+
+
+  if ((fp = tmpfile ()) == NULL)
+    {
+      perror ("Creating merge file");
+      exit (-1);
+    }
+
+  for (i = 0 ; i < num_runs ; i++)
+    {
+      stream[i].fp = runs[i];
+      stream[i].source = strdup ("");
+
+
+      /*  Out of order inputs were reported when they were first read.  */
+
+      stream[i].unordered = NVTrue;
+    }
+
+  merge_streams (options, stream, num_runs, fp, NVTrue);
+
+  rewind (fp);
+  runs[0] = fp;
+}
+
+
+
+/*  Write the merged water levels for every file in list.  Returns the number of files that failed.
+
+    The files are merged in groups of merge_fan_in streams.  If there is more than one group, each
+    group is merged into a temporary run, and the runs are merged at the end (and along the way
+    whenever there are fan in of them).  Groups and runs are consecutive in the file list, so samples
+    with the same time still come out in file order.  */
+
+int32_t merge_files (OPTIONS *options, FILE_LIST *list)
+{
+  MERGE_STREAM       *stream;
+  MERGE_JOBS         jobs;
+  FILE               **spool, **runs;
+  int32_t            *job_file, i, first, count, fan_in, num_jobs, num_runs = 0, failed = 0;
+
+
+  fan_in = merge_fan_in (options);
+
+  if ((stream = (MERGE_STREAM *) calloc (fan_in, sizeof (MERGE_STREAM))) == NULL ||
+      (job_file = (int32_t *) malloc (fan_in * sizeof (int32_t))) == NULL ||
+      (spool = (FILE **) malloc (fan_in * sizeof (FILE *))) == NULL ||
+      (runs = (FILE **) malloc (fan_in * sizeof (FILE *))) == NULL ||
+      (jobs.name = (char **) malloc (fan_in * sizeof (char *))) == NULL)
+    {
+      perror ("Allocating merge memory");
+      exit (-1);
+    }
+
+  jobs.options = options;
+
+
+  for (first = 0 ; first < list->count ; first += count)
+    {
+      count = list->count - first < fan_in ? list->count - first : fan_in;
+
+
+      /*  Run the HOF files.  */
+
+      num_jobs = 0;
+
+      for (i = 0 ; i < count ; i++)
+        {
+          if (strstr (list->name[first + i], ".hof"))
+            {
+              job_file[num_jobs] = i;
+              jobs.name[num_jobs++] = list->name[first + i];
+            }
+        }
+
+      if (num_jobs) failed += run_spooled_jobs (num_jobs, options->workers, merge_job, &jobs, spool);
+
+      for (i = 0 ; i < num_jobs ; i++) stream[job_file[i]].fp = spool[i];
+
+
+      /*  Open the saved outputs.  */
+
+      for (i = 0 ; i < count ; i++)
+        {
+          if (!strstr (list->name[first + i], ".hof") && (stream[i].fp = fopen (list->name[first + i], "r")) == NULL)
+            {
+              perror (list->name[first + i]);
+              failed++;
+            }
+
+          stream[i].source = strdup (list->name[first + i]);
+        }
+
+
+      /*  Everything fits in one group, so there's no need for runs.  */
+
+      if (count == list->count)
+        {
+          merge_streams (options, stream, count, stdout, NVFalse);
+          break;
+        }
+
+      if ((runs[num_runs] = tmpfile ()) == NULL)
+        {
+          perror ("Creating merge file");
+          exit (-1);
+        }
+
+      merge_streams (options, stream, count, runs[num_runs], NVTrue);
+      rewind (runs[num_runs++]);
+
+      if (num_runs == fan_in)
+        {
+          merge_runs (options, stream, runs, num_runs);
+          num_runs = 1;
+        }
+    }
+
+
+  /*  Merge the runs.  */
+
+  if (num_runs)
+    {
+      for (i = 0 ; i < num_runs ; i++)
+        {
+          stream[i].fp = runs[i];
+          stream[i].source = strdup ("");
+          stream[i].unordered = NVTrue;
+        }
+
+      merge_streams (options, stream, num_runs, stdout, NVFalse);
+    }
+
+
+  free (stream);
+  free (job_file);
+  free (spool);
+  free (runs);
+  free (jobs.name);
+
+  return (failed);
+}
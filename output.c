@@ -0,0 +1,576 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : output.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Buffered text output with fast fixed precision number
+ *               formatting for the -y, --fields, and water level lines.
+ *
+ *               output_fixed produces exactly what printf's %.Nf does.  The
+ *               value is scaled by 10^N and rounded as a 64 bit integer.
+ *               The multiply is off by at most half an ulp so the rounding
+ *               can only differ from printf's (which rounds the exact binary
+ *               value, ties to even) when the scaled fraction is within a
+ *               few ulps of one half.  Those values, and anything too large
+ *               to scale exactly, are formatted with snprintf.
+ *
+ *               Text is collected in a large buffer and handed to stdio with
+ *               one fwrite per buffer.  Anything else that writes to the same
+ *               FILE (e.g. hof_dump_record) must be preceded by output_flush.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+/*  Default output buffer size.  */
+
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+
+/*  Most characters a single formatted number can take ("%.17f" of -DBL_MAX is 328).  */
+
+#define FIXED_MAX_CHARS 352
+
+
+static const double pow10_table[] = {1.0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7, 1.0e8, 1.0e9,
+                                      1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15, 1.0e16, 1.0e17};
+
+static const uint64_t ipow10_table[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+                                         1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                                         100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL};
+
+
+/*  2^52.  Scaled values have to be below this so the integer part and fraction are exact.  */
+
+#define MAX_SCALED 4503599627370496.0
+
+
+
+void output_init (OUTPUT_BUFFER *out, FILE *fp)
+{
+  out->fp = fp;
+  out->size = OUTPUT_BUFFER_SIZE;
+  out->used = 0;
+
+  if ((out->buffer = (char *) malloc (out->size)) == NULL)
+    {
+      perror ("Allocating output buffer");
+      exit (-1);
+    }
+}
+
+
+
+void output_flush (OUTPUT_BUFFER *out)
+{
+  STAT_TIMER         timer;
+
+
+  if (out->used)
+    {
+      timer = stats_start ();
+
+      fwrite (out->buffer, 1, out->used, out->fp);
+
+      stats_count (STAT_BYTES_WRITTEN, out->used);
+      stats_stop (STAT_WRITE, timer);
+
+      out->used = 0;
+    }
+}
+
+
+
+void output_close (OUTPUT_BUFFER *out)
+{
+  output_flush (out);
+
+  free (out->buffer);
+  out->buffer = NULL;
+}
+
+
+
+/*  Make sure there's room for at least bytes more characters.  */
+
+static inline void output_reserve (OUTPUT_BUFFER *out, int32_t bytes)
+{
+  if (out->used + bytes > out->size) output_flush (out);
+}
+
+
+
+/*  Write an unsigned integer, zero padded to at least width digits, at p.  Returns the new end.  */
+
+static inline char *put_unsigned (char *p, uint64_t value, int32_t width)
+{
+  char               digits[24];
+  int32_t            n = 0;
+
+
+  do
+    {
+      digits[n++] = (char) ('0' + value % 10);
+      value /= 10;
+    } while (value);
+
+  while (n < width) digits[n++] = '0';
+
+  while (n) *p++ = digits[--n];
+
+  return (p);
+}
+
+
+
+/*  Same as sprintf (p, "%0*.*f", width, precision, value).  precision must be 0 to 17.  */
+
+static inline char *put_fixed (char *p, double value, int32_t precision, int32_t width)
+{
+  double             scaled, whole, frac;
+  uint64_t           digits, int_part;
+  int32_t            len;
+  char               *start = p;
+
+
+  scaled = fabs (value) * pow10_table[precision];
+
+
+  /*  NaN, infinity, huge values, and values that are too close to a rounding tie to be sure about
+      go through snprintf.  */
+
+  if (!(scaled < MAX_SCALED))
+    {
+      return (p + snprintf (p, FIXED_MAX_CHARS, "%0*.*f", width, precision, value));
+    }
+
+  whole = floor (scaled);
+  frac = scaled - whole;
+
+  if (fabs (frac - 0.5) <= scaled * 1.0e-15 + 1.0e-300)
+    {
+      return (p + snprintf (p, FIXED_MAX_CHARS, "%0*.*f", width, precision, value));
+    }
+
+  digits = (uint64_t) whole + (frac > 0.5);
+
+
+  /*  printf keeps the sign of negative values that round to zero ("-0.00").  */
+
+  if (signbit (value)) *p++ = '-';
+
+  int_part = digits / ipow10_table[precision];
+
+
+  /*  Zero padding goes after the sign.  The fraction and decimal point take precision + 1.  */
+
+  len = width - (int32_t) (p - start) - (precision ? precision + 1 : 0);
+
+  p = put_unsigned (p, int_part, len > 1 ? len : 1);
+
+  if (precision)
+    {
+      *p++ = '.';
+      p = put_unsigned (p, digits - int_part * ipow10_table[precision], precision);
+    }
+
+  return (p);
+}
+
+
+
+static inline char *put_int (char *p, int64_t value, int32_t width)
+{
+  if (value < 0)
+    {
+      *p++ = '-';
+      return (put_unsigned (p, 0 - (uint64_t) value, width - 1));
+    }
+
+  return (put_unsigned (p, (uint64_t) value, width));
+}
+
+
+
+void output_fixed (OUTPUT_BUFFER *out, double value, int32_t precision)
+{
+  output_reserve (out, FIXED_MAX_CHARS);
+
+  out->used = put_fixed (out->buffer + out->used, value, precision, 0) - out->buffer;
+}
+
+
+
+void output_char (OUTPUT_BUFFER *out, char c)
+{
+  output_reserve (out, 1);
+
+  out->buffer[out->used++] = c;
+}
+
+
+
+/*  Same as printf ("%.11f,%.11f,%.2f\n", lat, lon, z).  */
+
+void output_yxz (OUTPUT_BUFFER *out, double lat, double lon, double z)
+{
+  char               *p;
+
+
+  output_reserve (out, 3 * FIXED_MAX_CHARS);
+
+  p = out->buffer + out->used;
+
+  p = put_fixed (p, lat, 11, 0);
+  *p++ = ',';
+  p = put_fixed (p, lon, 11, 0);
+  *p++ = ',';
+  p = put_fixed (p, z, 2, 0);
+  *p++ = '\n';
+
+  out->used = p - out->buffer;
+}
+
+
+
+
+/*  Same as printf ("%.11f,%.11f,%.2f,%c\n", lat, lon, z, source) (--joint).  */
+
+void output_yxz_source (OUTPUT_BUFFER *out, double lat, double lon, double z, char source)
+{
+  char               *p;
+
+
+  output_reserve (out, 3 * FIXED_MAX_CHARS + 2);
+
+  p = out->buffer + out->used;
+
+  p = put_fixed (p, lat, 11, 0);
+  *p++ = ',';
+  p = put_fixed (p, lon, 11, 0);
+  *p++ = ',';
+  p = put_fixed (p, z, 2, 0);
+  *p++ = ',';
+  *p++ = source;
+  *p++ = '\n';
+
+  out->used = p - out->buffer;
+}
+
+
+
+static inline char *put_water_level (char *p, double lat, double lon, int32_t year, int32_t jday, int32_t hour, int32_t minute,
+                                     float second, float level, uint8_t geo_check, double dist)
+{
+  p = put_fixed (p, lat, 9, 0);
+  *p++ = ' ';
+  p = put_fixed (p, lon, 9, 0);
+  *p++ = ' ';
+  p = put_int (p, year, 0);
+  *p++ = ' ';
+  p = put_int (p, jday, 3);
+  *p++ = ' ';
+  p = put_int (p, hour, 2);
+  *p++ = ':';
+  p = put_int (p, minute, 2);
+  *p++ = ':';
+  p = put_fixed (p, second, 2, 5);
+  *p++ = ' ';
+  p = put_fixed (p, level, 3, 0);
+
+  if (geo_check)
+    {
+      *p++ = ' ';
+      p = put_fixed (p, dist, 3, 0);
+    }
+
+  return (p);
+}
+
+
+
+/*  Same as printf ("%.9f %.9f %d %03d %02d:%02d:%05.2f %.3f\n", ...).  If geo_check is set the
+    distance is added as " %.3f" before the new line.  */
+
+void output_water_level (OUTPUT_BUFFER *out, double lat, double lon, int32_t year, int32_t jday, int32_t hour, int32_t minute,
+                         float second, float level, uint8_t geo_check, double dist)
+{
+  char               *p;
+
+
+  output_reserve (out, 9 * FIXED_MAX_CHARS);
+
+  p = put_water_level (out->buffer + out->used, lat, lon, year, jday, hour, minute, second, level, geo_check, dist);
+
+  *p++ = '\n';
+
+  out->used = p - out->buffer;
+}
+
+
+
+/*  output_water_level followed by " %.2f %d %.3f %.3f %.6f" for the window width (seconds), number
+    of shots, minimum, maximum, and variance.  */
+
+void output_water_level_stats (OUTPUT_BUFFER *out, double lat, double lon, int32_t year, int32_t jday, int32_t hour, int32_t minute,
+                               float second, float level, uint8_t geo_check, double dist, int64_t width, int32_t count, float min,
+                               float max, double variance)
+{
+  char               *p;
+
+
+  output_reserve (out, 14 * FIXED_MAX_CHARS);
+
+  p = put_water_level (out->buffer + out->used, lat, lon, year, jday, hour, minute, second, level, geo_check, dist);
+
+  *p++ = ' ';
+  p = put_fixed (p, (double) width / 1000000.0, 2, 0);
+  *p++ = ' ';
+  p = put_int (p, count, 0);
+  *p++ = ' ';
+  p = put_fixed (p, min, 3, 0);
+  *p++ = ' ';
+  p = put_fixed (p, max, 3, 0);
+  *p++ = ' ';
+  p = put_fixed (p, variance, 6, 0);
+  *p++ = '\n';
+
+  out->used = p - out->buffer;
+}
+
+
+
+/*  Same as printf ("%d %f %d %hd %hd\n", ...) for each of the shot data values.  */
+
+void output_shot_data (OUTPUT_BUFFER *out, SHOT_VALUES *values)
+{
+  char               *p;
+  int32_t            i;
+
+
+  for (i = 0 ; i < SHOT_VALUE_COUNT ; i++)
+    {
+      output_reserve (out, 2 * FIXED_MAX_CHARS);
+
+      p = out->buffer + out->used;
+
+      p = put_int (p, i, 0);
+      *p++ = ' ';
+      p = put_fixed (p, values->f[i], 6, 0);
+      *p++ = ' ';
+      p = put_int (p, values->i32[i], 0);
+      *p++ = ' ';
+      p = put_int (p, values->i16[i * 2], 0);
+      *p++ = ' ';
+      p = put_int (p, values->i16[i * 2 + 1], 0);
+      *p++ = '\n';
+
+      out->used = p - out->buffer;
+    }
+}
+
+
+
+/*  Field formatters for --fields.  Each one formats the value stored at value.  */
+
+static char *put_field_int8 (char *p, const uint8_t *value, int32_t precision)
+{
+  int8_t             v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_int (p, v, 0));
+}
+
+static char *put_field_uint8 (char *p, const uint8_t *value, int32_t precision)
+{
+  (void) precision;
+  return (put_unsigned (p, *value, 0));
+}
+
+static char *put_field_int16 (char *p, const uint8_t *value, int32_t precision)
+{
+  int16_t            v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_int (p, v, 0));
+}
+
+static char *put_field_uint16 (char *p, const uint8_t *value, int32_t precision)
+{
+  uint16_t           v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_unsigned (p, v, 0));
+}
+
+static char *put_field_int32 (char *p, const uint8_t *value, int32_t precision)
+{
+  int32_t            v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_int (p, v, 0));
+}
+
+static char *put_field_uint32 (char *p, const uint8_t *value, int32_t precision)
+{
+  uint32_t           v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_unsigned (p, v, 0));
+}
+
+static char *put_field_int64 (char *p, const uint8_t *value, int32_t precision)
+{
+  int64_t            v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_int (p, v, 0));
+}
+
+static char *put_field_uint64 (char *p, const uint8_t *value, int32_t precision)
+{
+  uint64_t           v;
+
+  (void) precision;
+  memcpy (&v, value, sizeof (v));
+  return (put_unsigned (p, v, 0));
+}
+
+static char *put_field_float (char *p, const uint8_t *value, int32_t precision)
+{
+  float              v;
+
+  memcpy (&v, value, sizeof (v));
+  return (put_fixed (p, v, precision, 0));
+}
+
+static char *put_field_double (char *p, const uint8_t *value, int32_t precision)
+{
+  double             v;
+
+  memcpy (&v, value, sizeof (v));
+  return (put_fixed (p, v, precision, 0));
+}
+
+
+
+/*  Turn a resolved field list into a flat list of formatters so that output_record doesn't have to
+    look at field names or types.  Integers are printed as %d, floating point fields as %.Nf using
+    the field's precision from fields.c.  */
+
+void output_compile_fields (FIELD_SET *set, char delimiter, FIELD_FORMAT *format)
+{
+  int32_t            i;
+
+
+  format->count = set->count > 0 ? set->count : 0;
+  format->delimiter = delimiter;
+
+  for (i = 0 ; i < format->count ; i++)
+    {
+      format->item[i].offset = set->field[i]->offset;
+      format->item[i].precision = set->field[i]->precision;
+
+      switch (set->field[i]->type)
+        {
+        case FIELD_INT8:
+          format->item[i].func = put_field_int8;
+          break;
+
+        case FIELD_UINT8:
+          format->item[i].func = put_field_uint8;
+          break;
+
+        case FIELD_INT16:
+          format->item[i].func = put_field_int16;
+          break;
+
+        case FIELD_UINT16:
+          format->item[i].func = put_field_uint16;
+          break;
+
+        case FIELD_INT32:
+          format->item[i].func = put_field_int32;
+          break;
+
+        case FIELD_UINT32:
+          format->item[i].func = put_field_uint32;
+          break;
+
+        case FIELD_INT64:
+          format->item[i].func = put_field_int64;
+          break;
+
+        case FIELD_UINT64:
+          format->item[i].func = put_field_uint64;
+          break;
+
+        case FIELD_FLOAT:
+          format->item[i].func = put_field_float;
+          break;
+
+        default:
+          format->item[i].func = put_field_double;
+          break;
+        }
+    }
+}
+
+
+
+/*  Write one record using a compiled field list.  */
+
+void output_record (OUTPUT_BUFFER *out, FIELD_FORMAT *format, void *record)
+{
+  char               *p;
+  int32_t            i;
+  const uint8_t      *rec = (const uint8_t *) record;
+
+
+  if (!format->count) return;
+
+  output_reserve (out, format->count * FIXED_MAX_CHARS);
+
+  p = out->buffer + out->used;
+
+  for (i = 0 ; i < format->count ; i++)
+    {
+      p = (*format->item[i].func) (p, rec + format->item[i].offset, format->item[i].precision);
+      *p++ = format->delimiter;
+    }
+
+  p[-1] = '\n';
+
+  out->used = p - out->buffer;
+}
@@ -0,0 +1,668 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : prefetch.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Read ahead file reader for --prefetch.
+ *
+ *               The file is read in chunks of chunk_size bytes.  A window of
+ *               depth chunks starting at the chunk the caller is reading is
+ *               kept in flight: as soon as the caller moves into a new chunk
+ *               the window slides and the chunks that just came into it are
+ *               queued.  Chunk c always lives in slot c % depth, so a slot is
+ *               free once the caller has moved past its chunk.
+ *
+ *               On Linux the reads are queued on an io_uring (set up with the
+ *               raw system calls so there's no liburing dependency).  If the
+ *               ring can't be created (old kernel or headers, or io_uring
+ *               disabled) a pool of depth threads does blocking preads
+ *               instead.  A read the ring won't take is done with pread on
+ *               the spot.  Either way the caller decodes and formats one
+ *               chunk while the next ones are being read.
+ *
+ *               A read that isn't in the window and doesn't continue from the
+ *               previous read is treated as random access and done with a
+ *               plain pread.  The time the caller spends waiting for data,
+ *               either for a chunk or in a plain pread, is added up for the
+ *               --prefetch report.
+ *
+ ********************************************************************/
+
+#ifndef NVWIN3X
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+/*  IORING_OP_READ is an enum, so the header is checked for IORING_FEAT_RW_CUR_POS, which came in
+    with it (Linux 5.6).  Without either the header or the system calls the thread pool is used.  */
+
+#if defined (__linux__) && defined (__has_include)
+#if __has_include (<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined (__NR_io_uring_setup) && defined (__NR_io_uring_enter) && defined (IORING_FEAT_RW_CUR_POS)
+#define PREFETCH_URING
+#endif
+#endif
+#endif
+
+#include "charts_list.h"
+
+
+#define PREFETCH_EMPTY     0
+#define PREFETCH_QUEUED    1                 /*  waiting for a thread  */
+#define PREFETCH_PENDING   2                 /*  being read  */
+#define PREFETCH_READY     3
+
+#define PREFETCH_MAX_THREADS 16
+
+
+typedef struct
+{
+  int64_t            chunk;                  /*  chunk number held (or being read), -1 for none  */
+  int32_t            state;
+  int64_t            bytes;                  /*  bytes read  */
+  uint8_t            *data;
+} PREFETCH_SLOT;
+
+
+struct PREFETCH
+{
+  int32_t            fd;
+  int64_t            file_size;
+  int64_t            chunk_size;
+  int32_t            depth;
+  PREFETCH_SLOT      *slot;
+  int64_t            window;                 /*  first chunk of the read ahead window  */
+  int64_t            last_end;               /*  end of the caller's last read, -1 before the first  */
+  double             wait;                   /*  seconds the caller spent waiting  */
+
+  pthread_mutex_t    mutex;
+  pthread_cond_t     work;
+  pthread_cond_t     ready;
+  pthread_t          thread[PREFETCH_MAX_THREADS];
+  int32_t            num_threads;
+  uint8_t            stop;
+
+  uint8_t            uring;
+#ifdef PREFETCH_URING
+  int32_t            ring_fd;
+  int32_t            in_flight;
+  uint8_t            *sq_ring;
+  uint8_t            *cq_ring;
+  size_t             sq_ring_size;
+  size_t             cq_ring_size;
+  struct io_uring_sqe *sqes;
+  size_t             sqes_size;
+  uint32_t           *sq_head;
+  uint32_t           *sq_tail;
+  uint32_t           *sq_mask;
+  uint32_t           *sq_array;
+  uint32_t           *cq_head;
+  uint32_t           *cq_tail;
+  uint32_t           *cq_mask;
+  struct io_uring_cqe *cqes;
+#endif
+};
+
+
+
+/*  pread all of size bytes unless the file ends first.  Returns the number of bytes read.  */
+
+static int64_t full_pread (int32_t fd, uint8_t *buffer, int64_t size, int64_t offset)
+{
+  int64_t            done = 0;
+  ssize_t            n;
+
+
+  while (done < size)
+    {
+      if ((n = pread (fd, buffer + done, size - done, offset + done)) < 0)
+        {
+          if (errno == EINTR) continue;
+          break;
+        }
+
+      if (!n) break;
+
+      done += n;
+    }
+
+  return (done);
+}
+
+
+
+static inline int64_t chunk_bytes (PREFETCH *pf, int64_t chunk)
+{
+  int64_t            size = pf->file_size - chunk * pf->chunk_size;
+
+
+  return (size < pf->chunk_size ? size : pf->chunk_size);
+}
+
+
+
+#ifdef PREFETCH_URING
+
+static int32_t uring_setup (PREFETCH *pf)
+{
+  struct io_uring_params params;
+
+
+  memset (&params, 0, sizeof (params));
+
+  if ((pf->ring_fd = (int32_t) syscall (__NR_io_uring_setup, pf->depth, &params)) < 0) return (-1);
+
+  pf->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (uint32_t);
+  pf->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      if (pf->cq_ring_size > pf->sq_ring_size) pf->sq_ring_size = pf->cq_ring_size;
+      pf->cq_ring_size = pf->sq_ring_size;
+    }
+
+  pf->sq_ring = (uint8_t *) mmap (NULL, pf->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pf->ring_fd, IORING_OFF_SQ_RING);
+
+  if (pf->sq_ring == MAP_FAILED)
+    {
+      close (pf->ring_fd);
+      return (-1);
+    }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      pf->cq_ring = pf->sq_ring;
+    }
+  else
+    {
+      pf->cq_ring = (uint8_t *) mmap (NULL, pf->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pf->ring_fd,
+                                      IORING_OFF_CQ_RING);
+
+      if (pf->cq_ring == MAP_FAILED)
+        {
+          munmap (pf->sq_ring, pf->sq_ring_size);
+          close (pf->ring_fd);
+          return (-1);
+        }
+    }
+
+  pf->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+  pf->sqes = (struct io_uring_sqe *) mmap (NULL, pf->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pf->ring_fd,
+                                           IORING_OFF_SQES);
+
+  if (pf->sqes == MAP_FAILED)
+    {
+      if (pf->cq_ring != pf->sq_ring) munmap (pf->cq_ring, pf->cq_ring_size);
+      munmap (pf->sq_ring, pf->sq_ring_size);
+      close (pf->ring_fd);
+      return (-1);
+    }
+
+  pf->sq_head = (uint32_t *) (pf->sq_ring + params.sq_off.head);
+  pf->sq_tail = (uint32_t *) (pf->sq_ring + params.sq_off.tail);
+  pf->sq_mask = (uint32_t *) (pf->sq_ring + params.sq_off.ring_mask);
+  pf->sq_array = (uint32_t *) (pf->sq_ring + params.sq_off.array);
+  pf->cq_head = (uint32_t *) (pf->cq_ring + params.cq_off.head);
+  pf->cq_tail = (uint32_t *) (pf->cq_ring + params.cq_off.tail);
+  pf->cq_mask = (uint32_t *) (pf->cq_ring + params.cq_off.ring_mask);
+  pf->cqes = (struct io_uring_cqe *) (pf->cq_ring + params.cq_off.cqes);
+
+  pf->in_flight = 0;
+  pf->uring = NVTrue;
+
+  return (0);
+}
+
+
+
+/*  Queue the read for slot s.  If the ring won't take it the slot is read with pread instead.  */
+
+static void uring_submit (PREFETCH *pf, int32_t s)
+{
+  struct io_uring_sqe *sqe;
+  uint32_t           tail, index;
+  long               result;
+
+
+  tail = *pf->sq_tail;
+  index = tail & *pf->sq_mask;
+
+  sqe = &pf->sqes[index];
+  memset (sqe, 0, sizeof (struct io_uring_sqe));
+
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = pf->fd;
+  sqe->addr = (uint64_t) (uintptr_t) pf->slot[s].data;
+  sqe->len = (uint32_t) chunk_bytes (pf, pf->slot[s].chunk);
+  sqe->off = (uint64_t) (pf->slot[s].chunk * pf->chunk_size);
+  sqe->user_data = (uint64_t) s;
+
+  pf->sq_array[index] = index;
+
+  __atomic_store_n (pf->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  while ((result = syscall (__NR_io_uring_enter, pf->ring_fd, 1, 0, 0, NULL, 0)) < 0 && errno == EINTR);
+
+
+  /*  If the kernel didn't consume the entry there won't be a completion for it, so take it back
+      off the ring and read the chunk here.  */
+
+  if (result < 1 && __atomic_load_n (pf->sq_head, __ATOMIC_ACQUIRE) == tail)
+    {
+      __atomic_store_n (pf->sq_tail, tail, __ATOMIC_RELEASE);
+
+      pf->slot[s].bytes = full_pread (pf->fd, pf->slot[s].data, chunk_bytes (pf, pf->slot[s].chunk), pf->slot[s].chunk * pf->chunk_size);
+      pf->slot[s].state = PREFETCH_READY;
+      return;
+    }
+
+  pf->slot[s].state = PREFETCH_PENDING;
+  pf->in_flight++;
+}
+
+
+
+/*  Wait for at least one read to finish and mark everything that has finished ready.  */
+
+static void uring_reap (PREFETCH *pf)
+{
+  struct io_uring_cqe *cqe;
+  PREFETCH_SLOT      *slot;
+  uint32_t           head;
+
+
+  if (!pf->in_flight) return;
+
+  head = *pf->cq_head;
+
+  if (head == __atomic_load_n (pf->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      syscall (__NR_io_uring_enter, pf->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    }
+
+  while (head != __atomic_load_n (pf->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      cqe = &pf->cqes[head & *pf->cq_mask];
+      slot = &pf->slot[cqe->user_data];
+
+
+      /*  Short reads and errors (including kernels without IORING_OP_READ) are finished with
+          pread.  */
+
+      if (cqe->res == chunk_bytes (pf, slot->chunk))
+        {
+          slot->bytes = cqe->res;
+        }
+      else
+        {
+          slot->bytes = full_pread (pf->fd, slot->data, chunk_bytes (pf, slot->chunk), slot->chunk * pf->chunk_size);
+        }
+
+      slot->state = PREFETCH_READY;
+      pf->in_flight--;
+
+      head++;
+      __atomic_store_n (pf->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+
+#endif
+
+
+
+/*  Queue every chunk in the window that isn't already held or being read.  Called with the mutex
+    held.  */
+
+static void schedule (PREFETCH *pf)
+{
+  PREFETCH_SLOT      *slot;
+  int64_t            c;
+  uint8_t            queued = NVFalse;
+
+
+  for (c = pf->window ; c < pf->window + pf->depth && c * pf->chunk_size < pf->file_size ; c++)
+    {
+      slot = &pf->slot[c % pf->depth];
+
+      if (slot->chunk == c || slot->state == PREFETCH_PENDING) continue;
+
+      slot->chunk = c;
+      slot->bytes = 0;
+
+#ifdef PREFETCH_URING
+      if (pf->uring)
+        {
+          uring_submit (pf, (int32_t) (c % pf->depth));
+          continue;
+        }
+#endif
+
+      slot->state = PREFETCH_QUEUED;
+      queued = NVTrue;
+    }
+
+  if (queued) pthread_cond_broadcast (&pf->work);
+}
+
+
+
+static void *prefetch_thread (void *data)
+{
+  PREFETCH           *pf = (PREFETCH *) data;
+  PREFETCH_SLOT      *slot;
+  int64_t            chunk, bytes;
+  int32_t            i, s;
+
+
+  pthread_mutex_lock (&pf->mutex);
+
+  for (;;)
+    {
+      /*  Take the earliest queued chunk.  */
+
+      s = -1;
+
+      for (i = 0 ; i < pf->depth ; i++)
+        {
+          if (pf->slot[i].state == PREFETCH_QUEUED && (s < 0 || pf->slot[i].chunk < pf->slot[s].chunk)) s = i;
+        }
+
+      if (s < 0)
+        {
+          if (pf->stop) break;
+
+          pthread_cond_wait (&pf->work, &pf->mutex);
+          continue;
+        }
+
+
+      slot = &pf->slot[s];
+      slot->state = PREFETCH_PENDING;
+      chunk = slot->chunk;
+
+      pthread_mutex_unlock (&pf->mutex);
+
+      bytes = full_pread (pf->fd, slot->data, chunk_bytes (pf, chunk), chunk * pf->chunk_size);
+
+      pthread_mutex_lock (&pf->mutex);
+
+      slot->bytes = bytes;
+      slot->state = PREFETCH_READY;
+
+      pthread_cond_broadcast (&pf->ready);
+    }
+
+  pthread_mutex_unlock (&pf->mutex);
+
+  return (NULL);
+}
+
+
+
+/*  Open file for reading with up to depth reads of chunk_size bytes in flight.  Returns NULL if
+    that isn't possible.  */
+
+PREFETCH *prefetch_open (char *file, int32_t depth, int64_t chunk_size)
+{
+  PREFETCH           *pf;
+  struct stat        st;
+  int32_t            i;
+
+
+  if (depth < 1 || chunk_size < 1) return (NULL);
+
+  if ((pf = (PREFETCH *) calloc (1, sizeof (PREFETCH))) == NULL) return (NULL);
+
+  if ((pf->fd = open (file, O_RDONLY)) < 0)
+    {
+      free (pf);
+      return (NULL);
+    }
+
+  if (fstat (pf->fd, &st))
+    {
+      close (pf->fd);
+      free (pf);
+      return (NULL);
+    }
+
+#if defined (POSIX_FADV_SEQUENTIAL)
+  posix_fadvise (pf->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  pf->file_size = st.st_size;
+  pf->chunk_size = chunk_size;
+  pf->depth = depth;
+  pf->window = 0;
+  pf->last_end = -1;
+
+  if ((pf->slot = (PREFETCH_SLOT *) calloc (depth, sizeof (PREFETCH_SLOT))) == NULL)
+    {
+      perror ("Allocating prefetch memory");
+      exit (-1);
+    }
+
+  for (i = 0 ; i < depth ; i++)
+    {
+      pf->slot[i].chunk = -1;
+
+      if ((pf->slot[i].data = (uint8_t *) malloc (chunk_size)) == NULL)
+        {
+          perror ("Allocating prefetch memory");
+          exit (-1);
+        }
+    }
+
+
+  pthread_mutex_init (&pf->mutex, NULL);
+  pthread_cond_init (&pf->work, NULL);
+  pthread_cond_init (&pf->ready, NULL);
+
+
+#ifdef PREFETCH_URING
+  if (!uring_setup (pf)) return (pf);
+#endif
+
+
+  pf->num_threads = depth < PREFETCH_MAX_THREADS ? depth : PREFETCH_MAX_THREADS;
+
+  for (i = 0 ; i < pf->num_threads ; i++)
+    {
+      if (pthread_create (&pf->thread[i], NULL, prefetch_thread, pf))
+        {
+          pf->num_threads = i;
+          break;
+        }
+    }
+
+  if (!pf->num_threads)
+    {
+      prefetch_close (pf);
+      return (NULL);
+    }
+
+  return (pf);
+}
+
+
+
+/*  Copy size bytes at offset into buffer.  Returns the number of bytes copied, which is less than
+    size only at the end of the file or on a read error.  */
+
+int64_t prefetch_read (PREFETCH *pf, int64_t offset, int64_t size, void *buffer)
+{
+  PREFETCH_SLOT      *slot;
+  uint8_t            *dst = (uint8_t *) buffer;
+  int64_t            c, within, n, done = 0;
+  double             start;
+
+
+  while (done < size)
+    {
+      c = offset / pf->chunk_size;
+      within = offset - c * pf->chunk_size;
+      n = pf->chunk_size - within;
+      if (n > size - done) n = size - done;
+
+      slot = &pf->slot[c % pf->depth];
+
+      pthread_mutex_lock (&pf->mutex);
+
+      if (!(slot->chunk == c && slot->state == PREFETCH_READY))
+        {
+          /*  Random access, just read it.  */
+
+          if ((c < pf->window || c >= pf->window + pf->depth) && pf->last_end != -1 && offset != pf->last_end)
+            {
+              pthread_mutex_unlock (&pf->mutex);
+
+              start = wall_clock ();
+              n = full_pread (pf->fd, dst + done, size - done, offset);
+              pf->wait += wall_clock () - start;
+
+              done += n;
+              pf->last_end = offset + n;
+
+              return (done);
+            }
+
+
+          /*  Sequential, move the window here and wait for the chunk.  */
+
+          pf->window = c;
+
+          start = wall_clock ();
+
+          while (!(slot->chunk == c && slot->state == PREFETCH_READY))
+            {
+              /*  The slot may still have been busy with an older chunk.  */
+
+              schedule (pf);
+
+              if (slot->chunk == c && slot->state == PREFETCH_READY) break;
+
+#ifdef PREFETCH_URING
+              if (pf->uring)
+                {
+                  uring_reap (pf);
+                  continue;
+                }
+#endif
+              pthread_cond_wait (&pf->ready, &pf->mutex);
+            }
+
+          pf->wait += wall_clock () - start;
+        }
+
+
+      /*  Moving into a new chunk frees the slots behind it for the chunks ahead.  */
+
+      if (c > pf->window)
+        {
+          pf->window = c;
+          schedule (pf);
+        }
+
+#ifdef PREFETCH_URING
+      if (pf->uring && pf->in_flight && *pf->cq_head != __atomic_load_n (pf->cq_tail, __ATOMIC_ACQUIRE)) uring_reap (pf);
+#endif
+
+      pthread_mutex_unlock (&pf->mutex);
+
+
+      if (within >= slot->bytes) break;
+
+      if (n > slot->bytes - within) n = slot->bytes - within;
+
+      memcpy (dst + done, slot->data + within, n);
+
+      done += n;
+      offset += n;
+      pf->last_end = offset;
+    }
+
+  return (done);
+}
+
+
+
+/*  Seconds spent waiting for data so far.  */
+
+double prefetch_wait (PREFETCH *pf)
+{
+  return (pf->wait);
+}
+
+
+
+char *prefetch_backend (PREFETCH *pf)
+{
+  return (pf->uring ? "io_uring" : "threads");
+}
+
+
+
+void prefetch_close (PREFETCH *pf)
+{
+  int32_t            i;
+
+
+  pthread_mutex_lock (&pf->mutex);
+  pf->stop = NVTrue;
+  pthread_cond_broadcast (&pf->work);
+  pthread_mutex_unlock (&pf->mutex);
+
+  for (i = 0 ; i < pf->num_threads ; i++) pthread_join (pf->thread[i], NULL);
+
+
+#ifdef PREFETCH_URING
+  if (pf->uring)
+    {
+      while (pf->in_flight) uring_reap (pf);
+
+      munmap (pf->sqes, pf->sqes_size);
+      if (pf->cq_ring != pf->sq_ring) munmap (pf->cq_ring, pf->cq_ring_size);
+      munmap (pf->sq_ring, pf->sq_ring_size);
+      close (pf->ring_fd);
+    }
+#endif
+
+
+  pthread_mutex_destroy (&pf->mutex);
+  pthread_cond_destroy (&pf->work);
+  pthread_cond_destroy (&pf->ready);
+
+  for (i = 0 ; i < pf->depth ; i++) free (pf->slot[i].data);
+
+  free (pf->slot);
+  close (pf->fd);
+  free (pf);
+}
@@ -0,0 +1,550 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : process_file.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Lists a single CHARTS .hof or .tof file in ASCII format.  This
+ *               is the body of the original main () so that it can be run once
+ *               per file in batch mode, or once per record range (chunk) when
+ *               a large file is split across workers.  Returns 0 on success or
+ *               -1 on error.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+static void tide_report (char *file, int32_t total, int32_t zero_tide)
+{
+  int32_t            i;
+
+
+  i = ((float) zero_tide / (float) total) * 100.0;
+
+  if (i > 1)
+    {
+      fprintf (stderr, "\nFile : %s not tide corrected\n", file);
+      fprintf (stderr, "Total = %d, no tide correction = %d\n", total, zero_tide);
+    }
+}
+
+
+
+/*  Add records first through first + count - 1 (1 based) to the records read for the --prefetch
+    report.  */
+
+static inline void note_read (int32_t *low, int32_t *high, int64_t *total, int32_t first, int32_t count)
+{
+  if (count <= 0) return;
+
+  if (first < *low) *low = first;
+  if (first + count - 1 > *high) *high = first + count - 1;
+  *total += count;
+}
+
+
+
+static int32_t list_file (OPTIONS *options, char *file, int32_t first_rec, int32_t last_rec)
+{
+  char               wave_file[512];
+  int32_t            type = 0, status = 0, j, r, start, end, first, last, count, wave_size = 0;
+  int32_t            read_low = INT32_MAX, read_high = 0;
+  int64_t            read_total = 0;
+  double             per_ten_sec = 10000.0, start_seconds;
+  FILE               *fp = NULL, *wfp = NULL;
+  HOF_HEADER_T       hof_header;
+  HYDRO_OUTPUT_T     *hof_batch = NULL, *hof_records;
+  TOPO_OUTPUT_T      *tof_batch = NULL;
+  RECORD_READER      reader;
+  OUTPUT_BUFFER      out;
+  COLUMNAR_WRITER    col;
+  FIELD_SET          *columns;
+  FIELD_FORMAT       *format;
+  WAVE_HEADER_T      wave_header;
+  WAVE_DATA_T        wave_data;
+  SHOT_VALUES        *shot_values = NULL;
+  SHOT_READER        shots;
+  SHOT_BATCH         *shot_batch = NULL;
+  WATER_LEVEL        wl;
+  KERNEL_STATE       state;
+  RECORD_KERNEL      kernel;
+  uint8_t            pass[READ_BATCH];
+  SUMMARY            summary;
+  uint8_t            srtm_check = NVFalse, pipelined = NVFalse;
+  STAT_TIMER         open_timer = stats_start ();
+
+
+  if (options->summary || options->index) return (summary_file (options, file));
+
+  if (options->audit) return (audit_file (options, file));
+
+  if (options->gridding) return (grid_file (options, file, first_rec, last_rec));
+
+
+  /*  A whole file tide check can be answered from a current sidecar without reading the records.  */
+
+  if (options->tide_check && !options->filter.active && options->rec_num == -1 && first_rec <= 1 && last_rec < 0 &&
+      strstr (file, ".hof") && !summary_read (file, &summary, NVFalse) && !summary.header.record_type)
+    {
+      fprintf (stderr, "\n\nFile : %s\n\n", file);
+      tide_report (file, summary.header.tide_total, summary.header.zero_tide_count);
+      return (0);
+    }
+
+
+  if (strstr (file, ".hof"))
+    {
+      if ((fp = file_cache_open (file, FILE_CACHE_HOF)) == NULL)
+        {
+          perror (file);
+          return (-1);
+        }
+      type = 0;
+
+
+      if (options->water_level)
+        {
+          srtm_check = NVFalse;
+          if (!check_srtm_mask (3)) srtm_check = NVTrue;
+
+          if (first_rec <= 1 && options->wl_func == NULL) printf ("#%s\n", file);
+        }
+
+
+      file_cache_hof_header (fp, &hof_header);
+
+      per_ten_sec = (double) hof_header.text.system_rep_rate * 10.0L;
+
+
+      if (options->shot_data)
+        {
+          strcpy (wave_file, file);
+          sprintf (&wave_file[strlen (wave_file) - 4], ".inh");
+
+          wfp = file_cache_open (wave_file, FILE_CACHE_WAVE);
+
+          if (wfp == NULL)
+            {
+              perror (wave_file);
+              file_cache_close (fp);
+              return (-1);
+            }
+
+          file_cache_wave_header (wfp, &wave_header);
+        }
+    }
+  else if (strstr (file, ".tof"))
+    {
+      if (options->water_level)
+        {
+          fprintf (stderr, "\nCannot get water level from TOF files - Doh!\n\n");
+          return (-1);
+        }
+
+
+      if (options->tide_check)
+        {
+          fprintf (stderr, "\nCannot tide check TOF files - Doh!\n\n");
+          return (-1);
+        }
+
+      if ((fp = file_cache_open (file, FILE_CACHE_TOF)) == NULL)
+        {
+          perror (file);
+          return (-1);
+        }
+      type = 1;
+    }
+  else
+    {
+      fprintf (stderr,"\nUnknown file extension %s\n", file);
+      return (-1);
+    }
+
+
+  /*  Shot data is only available for HOF files.  The caller checks this for the command line
+      file but directories and list files may contain TOF files as well.  */
+
+  if (type && options->shot_data)
+    {
+      fprintf (stderr, "\nCannot dump shot data from TOF files - Doh!\n\n");
+      file_cache_close (fp);
+      return (-1);
+    }
+
+
+  if (options->columnar)
+    {
+      columns = type ? &options->tof_columns : &options->hof_columns;
+
+      if (columns->count < 0)
+        {
+          fprintf (stderr, "\nUnknown %s field %s\n\n", type ? "TOF" : "HOF", columns->bad);
+          file_cache_close (fp);
+          if (wfp) file_cache_close (wfp);
+          return (-1);
+        }
+
+      if (columnar_open (&col, file, options->columnar_dir, type, columns))
+        {
+          file_cache_close (fp);
+          if (wfp) file_cache_close (wfp);
+          return (-1);
+        }
+    }
+
+
+  format = type ? &options->tof_format : &options->hof_format;
+
+  if (options->fields)
+    {
+      columns = type ? &options->tof_fields : &options->hof_fields;
+
+      if (columns->count < 0)
+        {
+          fprintf (stderr, "\nUnknown %s field %s\n\n", type ? "TOF" : "HOF", columns->bad);
+          file_cache_close (fp);
+          if (wfp) file_cache_close (wfp);
+          return (-1);
+        }
+    }
+
+
+  start_seconds = wall_clock ();
+
+  if (type)
+    {
+      tof_batch = (TOPO_OUTPUT_T *) malloc (READ_BATCH * sizeof (TOPO_OUTPUT_T));
+      file_cache_reader_open (&reader, fp, file, type, -1, options->use_library);
+    }
+  else
+    {
+      hof_batch = (HYDRO_OUTPUT_T *) malloc (READ_BATCH * sizeof (HYDRO_OUTPUT_T));
+      file_cache_reader_open (&reader, fp, file, type, hof_header.text.number_shots, options->use_library);
+    }
+
+  stats_stop (STAT_OPEN, open_timer);
+
+  if (hof_batch == NULL && tof_batch == NULL)
+    {
+      perror ("Allocating record memory");
+      exit (-1);
+    }
+
+  summary.block = NULL;
+  output_init (&out, stdout);
+  wl_init (&wl, options, &out);
+
+
+  /*  Everything that depends on the options is decided here, once for the file.  */
+
+  state.out = &out;
+  state.col = &col;
+  state.format = format;
+  state.wl = &wl;
+  state.per_ten_sec = per_ten_sec;
+  state.number_shots = type ? 0 : hof_header.text.number_shots;
+  state.total = 0;
+  state.zero_tide = 0;
+
+  kernel = kernel_select (options, type, srtm_check);
+
+
+  if (first_rec <= 1 && !options->quiet) fprintf (stderr, "\n\nFile : %s\n\n", file);
+
+
+  if (options->rec_num != -1)
+    {
+      fprintf (stderr, "\n\n");
+
+      if (options->shot_data)
+        {
+          if ((shot_values = (SHOT_VALUES *) malloc (READ_BATCH * sizeof (SHOT_VALUES))) == NULL)
+            {
+              perror ("Allocating shot memory");
+              exit (-1);
+            }
+
+          wave_size = wave_record_size (wfp);
+        }
+
+
+      /*  Read each run of the -n record list in batches.  */
+
+      for (r = 0 ; r < options->records.count ; r++)
+        {
+          for (start = options->records.range[r].first ; start <= options->records.range[r].last ; start += count)
+            {
+              count = READ_BATCH;
+              if (options->records.range[r].last - start < count) count = options->records.range[r].last - start + 1;
+
+              if ((count = reader_read (&reader, start, count, type ? (void *) tof_batch : (void *) hof_batch)) <= 0) break;
+
+              note_read (&read_low, &read_high, &read_total, start, count);
+
+              if (options->filter.active) filter_batch (&options->filter, type, type ? (void *) tof_batch : (void *) hof_batch, count, pass);
+
+
+              /*  Only the waveform records for the shots that will be listed are read.  */
+
+              if (shot_values != NULL)
+                {
+                  for (j = 0 ; j < count ; j++)
+                    {
+                      if ((options->list_null || hof_batch[j].correct_depth != -998.0) && (!options->filter.active || pass[j]))
+                        {
+                          wave_read (wfp, start + j, &wave_data, wave_size);
+                          decode_shot_data (&wave_data, &shot_values[j], 1);
+                        }
+                    }
+                }
+
+              (*kernel) (&state, type ? (void *) tof_batch : (void *) hof_batch, start - 1, count, pass, shot_values);
+            }
+        }
+    }
+  else
+    {
+      /*
+       * Read all of the data from this file.
+       */
+
+      first = first_rec;
+      last = last_rec;
+
+
+      /*  Narrow the range to the --time window and load the sidecar block bounds so that blocks
+          outside the filter can be skipped.  */
+
+      if (options->filter.time && reader.num_records > 0)
+        {
+          if (last < 0 || last > reader.num_records) last = reader.num_records;
+
+          filter_time_range (&options->filter, &reader, &first, &last);
+        }
+
+      if (options->filter.active && !options->shot_data && (summary_read (file, &summary, NVTrue) || summary.header.record_type != (uint32_t) type))
+        summary_free (&summary);
+
+
+      if (type)
+        {
+          for (start = first ; last < 0 || start <= last ; start += count)
+            {
+              count = READ_BATCH;
+              if (last >= 0 && start + count - 1 > last) count = last - start + 1;
+
+              if (summary.block != NULL && (count = filter_span (&options->filter, &summary, start - 1, count)) < 0)
+                {
+                  count = -count;
+                  continue;
+                }
+
+              if ((count = reader_read (&reader, start, count, tof_batch)) <= 0) break;
+
+              note_read (&read_low, &read_high, &read_total, start, count);
+
+              if (options->filter.active) filter_batch (&options->filter, type, tof_batch, count, pass);
+
+              (*kernel) (&state, tof_batch, start - 1, count, pass, NULL);
+            }
+        }
+      else
+        {
+          end = hof_header.text.number_shots;
+          if (last >= 0 && last < end) end = last;
+
+
+          /*  Shot data dumps read the HOF and waveform records on a separate thread (the -t and -w
+              loops don't use the shot data).  */
+
+          pipelined = (options->shot_data && !options->tide_check && !options->water_level);
+
+          if (pipelined && shot_reader_open (&shots, &reader, wfp, first, end))
+            {
+              output_close (&out);
+              file_cache_reader_close (&reader);
+              summary_free (&summary);
+              free (hof_batch);
+              file_cache_close (fp);
+              file_cache_close (wfp);
+              return (-1);
+            }
+
+          hof_records = hof_batch;
+
+
+          for (start = first - 1 ; start < end ; start += count)
+            {
+              count = READ_BATCH;
+              if (start + count > end) count = end - start;
+
+              if (summary.block != NULL && (count = filter_span (&options->filter, &summary, start, count)) < 0)
+                {
+                  count = -count;
+                  continue;
+                }
+
+              if (pipelined)
+                {
+                  if ((shot_batch = shot_reader_next (&shots)) == NULL) break;
+
+                  count = shot_batch->count;
+                  hof_records = shot_batch->hof;
+                }
+              else if ((count = reader_read (&reader, start + 1, count, hof_batch)) <= 0)
+                {
+                  break;
+                }
+
+              note_read (&read_low, &read_high, &read_total, pipelined ? shot_batch->first : start + 1, count);
+
+              if (options->filter.active) filter_batch (&options->filter, type, hof_records, count, pass);
+
+              if ((*kernel) (&state, hof_records, start, count, pass, pipelined ? shot_batch->values : NULL))
+                {
+                  output_close (&out);
+                  file_cache_reader_close (&reader);
+                  summary_free (&summary);
+                  free (hof_batch);
+                  file_cache_close (fp);
+                  return (-1);
+                }
+            }
+        }
+    }
+
+
+  if (pipelined) shot_reader_close (&shots);
+
+  output_close (&out);
+
+
+  /*  How much of the time went to waiting for the reads, and for which records (-n, --time, and
+      the sidecar blocks that were skipped can leave a lot less than the whole range).  */
+
+  if (reader.prefetch != NULL)
+    {
+      if (read_total)
+        {
+          fprintf (stderr, "%s records %d-%d (%lld read) : %.3f s, %.3f s waiting for I/O (%s)\n", file, read_low, read_high,
+                   (long long) read_total, wall_clock () - start_seconds, reader_wait (&reader), prefetch_backend (reader.prefetch));
+        }
+      else
+        {
+          fprintf (stderr, "%s no records read : %.3f s, %.3f s waiting for I/O (%s)\n", file, wall_clock () - start_seconds,
+                   reader_wait (&reader), prefetch_backend (reader.prefetch));
+        }
+    }
+
+  file_cache_reader_close (&reader);
+  summary_free (&summary);
+  free (hof_batch);
+  free (tof_batch);
+  free (shot_values);
+
+  if (options->columnar) status = columnar_close (&col);
+
+  file_cache_close (fp);
+  if (wfp) file_cache_close (wfp);
+
+
+  if (options->tide_check && first_rec <= 1 && last_rec < 0) tide_report (file, state.total, state.zero_tide);
+
+
+  return (status);
+}
+
+
+
+/*  Process records first_rec through last_rec (1 based, -1 for the end of the file) of file.  The
+    per file messages are only printed for the chunk that starts at the first record.  Whatever
+    time list_file doesn't spend in the other --stats phases is formatting.  With --incremental a
+    whole file whose output was saved by an earlier run is replayed instead (see state.c).  */
+
+int32_t process_file (OPTIONS *options, char *file, int32_t first_rec, int32_t last_rec)
+{
+  STAT_TIMER         timer = stats_start ();
+  int32_t            status;
+
+
+  if (first_rec <= 1) stats_count (STAT_FILES, 1);
+
+  if (options->state_dir != NULL && first_rec <= 1 && last_rec < 0)
+    {
+      status = state_file (options, file, list_file);
+    }
+  else
+    {
+      status = list_file (options, file, first_rec, last_rec);
+    }
+
+  stats_stop (STAT_FORMAT, timer);
+
+  return (status);
+}
+
+
+
+/*  Return the number of records in file or -1 if it can't be determined without reading the
+    whole file (TOF files read through the library).  */
+
+int32_t count_file_records (OPTIONS *options, char *file)
+{
+  FILE               *fp;
+  HOF_HEADER_T       hof_header;
+  RECORD_READER      reader;
+  SUMMARY            summary;
+  int32_t            count = -1;
+
+
+  if (strstr (file, ".hof"))
+    {
+      if ((fp = open_hof_file (file)) == NULL) return (-1);
+
+      hof_read_header (fp, &hof_header);
+
+      count = hof_header.text.number_shots;
+
+      fclose (fp);
+    }
+  else if (strstr (file, ".tof"))
+    {
+      if ((fp = open_tof_file (file)) == NULL) return (-1);
+
+      reader_open (&reader, fp, file, 1, -1, options->use_library);
+
+      count = reader.num_records;
+
+      reader_close (&reader);
+      fclose (fp);
+
+      if (count < 0 && !summary_read (file, &summary, NVFalse)) count = summary.header.num_records;
+    }
+
+  return (count);
+}
@@ -0,0 +1,206 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : record_list.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Parses the -n record list.  The list is a comma separated
+ *               set of record numbers (N) and ranges (START:END, or START:
+ *               for the rest of the file).  @FILE reads the list from FILE,
+ *               where commas, spaces, and new lines all separate entries.
+ *
+ *               Records are listed in the order given.  Consecutive entries
+ *               that continue each other (5,6,7 or 1:10,11:20) are merged so
+ *               that they're read as one contiguous run.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+
+void record_list_init (RECORD_LIST *list)
+{
+  list->range = NULL;
+  list->count = 0;
+  list->size = 0;
+}
+
+
+
+static void record_list_append (RECORD_LIST *list, int32_t first, int32_t last)
+{
+  /*  Merge with the previous range if this one continues it.  */
+
+  if (list->count && list->range[list->count - 1].last != INT32_MAX && list->range[list->count - 1].last + 1 == first)
+    {
+      list->range[list->count - 1].last = last;
+      return;
+    }
+
+
+  if (list->count == list->size)
+    {
+      list->size = list->size ? list->size * 2 : 64;
+
+      if ((list->range = (RECORD_RANGE *) realloc (list->range, list->size * sizeof (RECORD_RANGE))) == NULL)
+        {
+          perror ("Allocating record list memory");
+          exit (-1);
+        }
+    }
+
+  list->range[list->count].first = first;
+  list->range[list->count].last = last;
+  list->count++;
+}
+
+
+
+/*  Parse one entry (N, START:END, or START:).  Returns 0 on success or -1 on error.  */
+
+static int32_t record_list_entry (RECORD_LIST *list, char *entry)
+{
+  int32_t            first, last, n;
+  char               *colon;
+
+
+  if ((colon = strchr (entry, ':')) == NULL)
+    {
+      if (sscanf (entry, "%d%n", &first, &n) != 1 || entry[n] || first < 1) return (-1);
+
+      record_list_append (list, first, first);
+
+      return (0);
+    }
+
+
+  *colon = 0;
+
+  if (sscanf (entry, "%d%n", &first, &n) != 1 || entry[n] || first < 1) return (-1);
+
+  if (!colon[1])
+    {
+      last = INT32_MAX;
+    }
+  else if (sscanf (&colon[1], "%d%n", &last, &n) != 1 || colon[1 + n] || last < first)
+    {
+      return (-1);
+    }
+
+  record_list_append (list, first, last);
+
+  return (0);
+}
+
+
+
+static int32_t record_list_string (RECORD_LIST *list, char *string, char *separators)
+{
+  char               *entry, *save = NULL, bad[128];
+
+
+  for (entry = strtok_r (string, separators, &save) ; entry != NULL ; entry = strtok_r (NULL, separators, &save))
+    {
+      strncpy (bad, entry, sizeof (bad) - 1);
+      bad[sizeof (bad) - 1] = 0;
+
+      if (record_list_entry (list, entry))
+        {
+          fprintf (stderr, "\nBad record number or range %s\n\n", bad);
+          return (-1);
+        }
+    }
+
+  return (0);
+}
+
+
+
+/*  Add the -n argument to list.  Returns 0 on success or -1 on error.  */
+
+int32_t record_list_parse (RECORD_LIST *list, char *arg)
+{
+  FILE               *fp;
+  char               *string = NULL;
+  size_t             size = 0;
+  int32_t            status = 0;
+
+
+  if (arg[0] != '@')
+    {
+      if ((string = strdup (arg)) == NULL)
+        {
+          perror ("Allocating record list memory");
+          exit (-1);
+        }
+
+      status = record_list_string (list, string, ",");
+
+      free (string);
+
+      if (status) return (-1);
+    }
+  else
+    {
+      if ((fp = fopen (&arg[1], "r")) == NULL)
+        {
+          perror (&arg[1]);
+          return (-1);
+        }
+
+      /*  getline so that a line of any length is parsed whole.  */
+
+      while (!status && getline (&string, &size, fp) != -1)
+        {
+          if (string[0] == '#') continue;
+
+          status = record_list_string (list, string, ", \t\r\n");
+        }
+
+      free (string);
+      fclose (fp);
+
+      if (status) return (-1);
+    }
+
+
+  if (!list->count)
+    {
+      fprintf (stderr, "\nNo record numbers in %s\n\n", arg);
+      return (-1);
+    }
+
+  return (0);
+}
+
+
+
+void record_list_free (RECORD_LIST *list)
+{
+  free (list->range);
+  record_list_init (list);
+}
@@ -0,0 +1,470 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : record_reader.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Bulk HOF/TOF record reader.  The data file is memory mapped
+ *               with a sequential access hint and records are copied out in
+ *               batches, so a full file scan costs one copy per record instead
+ *               of a seek and read per record.
+ *
+ *               The mapped reader assumes the records are stored as native
+ *               HYDRO_OUTPUT_T/TOPO_OUTPUT_T structures following a fixed
+ *               size header.  That is checked when the file is opened by
+ *               comparing the first and last mapped records with what
+ *               hof_read_record/tof_read_record return.  If the check fails,
+ *               mmap isn't available, or the caller asks for it (-L), all
+ *               reads go through the CHARTS library instead.
+ *
+ *               With --prefetch (reader_set_prefetch) the file is read through
+ *               prefetch.c instead of being mapped, with the same check, so
+ *               that several large reads are in flight ahead of the records
+ *               being decoded.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+#ifndef NVWIN3X
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
+
+/*  Bytes of the mapping we ask the kernel to start reading ahead of the current position.  */
+
+#define READ_AHEAD_BYTES (16 * 1024 * 1024)
+
+
+/*  --prefetch settings, shared by every reader.  */
+
+static int32_t       prefetch_depth = 0;
+static int64_t       prefetch_bytes = 0;
+
+
+
+static uint8_t library_read (RECORD_READER *reader, int32_t num, void *record)
+{
+  uint8_t            status;
+
+
+  /*  Use the library's sequential read for TOF files when we can.  That's what the original
+      full file loop did and it avoids a seek per record.  */
+
+  if (reader->type)
+    {
+      if (num == reader->lib_next)
+        {
+          status = tof_read_record (reader->fp, TOF_NEXT_RECORD, (TOPO_OUTPUT_T *) record);
+        }
+      else
+        {
+          status = tof_read_record (reader->fp, num, (TOPO_OUTPUT_T *) record);
+        }
+    }
+  else
+    {
+      status = hof_read_record (reader->fp, num, (HYDRO_OUTPUT_T *) record);
+    }
+
+  reader->lib_next = num + 1;
+
+  return (status);
+}
+
+
+
+#ifndef NVWIN3X
+
+static void reader_unmap (RECORD_READER *reader)
+{
+  if (reader->map != NULL) munmap (reader->map, reader->map_size);
+
+  reader->map = NULL;
+  reader->map_size = 0;
+  reader->mapped = NVFalse;
+}
+
+
+
+/*  Map the file and make sure the mapped records match the library's records.  */
+
+static uint8_t reader_map (RECORD_READER *reader, char *file)
+{
+  struct stat        st;
+  int32_t            fd, check[2], i, num_records = reader->num_records;
+  int64_t            count;
+  uint8_t            record[sizeof (HYDRO_OUTPUT_T) > sizeof (TOPO_OUTPUT_T) ? sizeof (HYDRO_OUTPUT_T) : sizeof (TOPO_OUTPUT_T)];
+  void               *map;
+
+
+  if ((fd = open (file, O_RDONLY)) < 0) return (NVFalse);
+
+  if (fstat (fd, &st) || st.st_size <= reader->head_size)
+    {
+      close (fd);
+      return (NVFalse);
+    }
+
+
+  count = (st.st_size - reader->head_size) / reader->record_size;
+
+  if (reader->num_records < 0 || reader->num_records > count) reader->num_records = (int32_t) count;
+
+  if (!reader->num_records)
+    {
+      close (fd);
+      return (NVFalse);
+    }
+
+
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+
+  if (map == MAP_FAILED) return (NVFalse);
+
+  reader->map = (uint8_t *) map;
+  reader->map_size = st.st_size;
+  reader->mapped = NVTrue;
+
+
+  check[0] = 1;
+  check[1] = reader->num_records;
+
+  for (i = 0 ; i < 2 ; i++)
+    {
+      memset (record, 0, sizeof (record));
+
+      if (!library_read (reader, check[i], record) ||
+          memcmp (record, reader->map + reader->head_size + (int64_t) (check[i] - 1) * reader->record_size, reader->record_size))
+        {
+          reader_unmap (reader);
+          reader->num_records = num_records;
+          return (NVFalse);
+        }
+    }
+
+
+  madvise (reader->map, reader->map_size, MADV_SEQUENTIAL);
+
+  return (NVTrue);
+}
+
+
+
+/*  Open the file through prefetch.c and make sure its records match the library's records.  */
+
+static uint8_t reader_prefetch (RECORD_READER *reader, char *file)
+{
+  struct stat        st;
+  int32_t            check[2], i, num_records = reader->num_records;
+  int64_t            count;
+  uint8_t            record[sizeof (HYDRO_OUTPUT_T) > sizeof (TOPO_OUTPUT_T) ? sizeof (HYDRO_OUTPUT_T) : sizeof (TOPO_OUTPUT_T)];
+  uint8_t            mine[sizeof (record)];
+
+
+  if (stat (file, &st) || st.st_size <= reader->head_size) return (NVFalse);
+
+  count = (st.st_size - reader->head_size) / reader->record_size;
+
+  if (reader->num_records < 0 || reader->num_records > count) reader->num_records = (int32_t) count;
+
+  if (!reader->num_records || (reader->prefetch = prefetch_open (file, prefetch_depth, prefetch_bytes)) == NULL)
+    {
+      reader->num_records = num_records;
+      return (NVFalse);
+    }
+
+
+  check[0] = 1;
+  check[1] = reader->num_records;
+
+  for (i = 0 ; i < 2 ; i++)
+    {
+      memset (record, 0, sizeof (record));
+
+      if (!library_read (reader, check[i], record) ||
+          prefetch_read (reader->prefetch, reader->head_size + (int64_t) (check[i] - 1) * reader->record_size, reader->record_size,
+                         mine) != reader->record_size || memcmp (record, mine, reader->record_size))
+        {
+          prefetch_close (reader->prefetch);
+          reader->prefetch = NULL;
+          reader->num_records = num_records;
+          return (NVFalse);
+        }
+    }
+
+  return (NVTrue);
+}
+
+#endif
+
+
+
+/*  Read the files with depth reads of megabytes MB in flight (see prefetch.c).  0 turns it off.
+    Must be called before any reader is opened.  */
+
+void reader_set_prefetch (int32_t depth, int32_t megabytes)
+{
+  prefetch_depth = depth;
+  prefetch_bytes = (int64_t) megabytes * 1048576;
+}
+
+
+
+/*  Set up a reader for an open HOF (type 0) or TOF (type 1) file.  fp stays owned by the caller
+    and is used for library reads.  num_records is the record count from the header or -1 if it
+    isn't known.  */
+
+void reader_open (RECORD_READER *reader, FILE *fp, char *file, int32_t type, int32_t num_records, uint8_t use_library)
+{
+  reader->type = type;
+  reader->fp = fp;
+  reader->num_records = num_records;
+  reader->map = NULL;
+  reader->map_size = 0;
+  reader->mapped = NVFalse;
+  reader->lib_next = 1;
+  reader->advised = 0;
+  reader->prefetch = NULL;
+
+  if (type)
+    {
+      reader->head_size = TOF_HEAD_SIZE;
+      reader->record_size = sizeof (TOPO_OUTPUT_T);
+    }
+  else
+    {
+      reader->head_size = HOF_HEAD_SIZE;
+      reader->record_size = sizeof (HYDRO_OUTPUT_T);
+    }
+
+
+#ifndef NVWIN3X
+  if (!use_library && (!prefetch_depth || !reader_prefetch (reader, file))) reader_map (reader, file);
+#endif
+}
+
+
+
+static int32_t read_records (RECORD_READER *reader, int32_t first, int32_t count, void *records)
+{
+  int32_t            i;
+  int64_t            offset, end;
+
+
+  if (first < 1 || count < 1) return (0);
+
+
+  if (reader->prefetch != NULL)
+    {
+      if (first > reader->num_records) return (0);
+
+      if (first - 1 + count > reader->num_records) count = reader->num_records - first + 1;
+
+      offset = reader->head_size + (int64_t) (first - 1) * reader->record_size;
+
+      return ((int32_t) (prefetch_read (reader->prefetch, offset, (int64_t) count * reader->record_size, records) / reader->record_size));
+    }
+
+
+  if (reader->mapped)
+    {
+      if (first > reader->num_records) return (0);
+
+      if (first - 1 + count > reader->num_records) count = reader->num_records - first + 1;
+
+      offset = reader->head_size + (int64_t) (first - 1) * reader->record_size;
+      end = offset + (int64_t) count * reader->record_size;
+
+
+#ifndef NVWIN3X
+      /*  Keep the kernel reading ahead of us.  */
+
+      if (end > reader->advised && reader->advised < reader->map_size)
+        {
+          int64_t start = end & ~((int64_t) getpagesize () - 1), size = READ_AHEAD_BYTES;
+
+          if (start + size > reader->map_size) size = reader->map_size - start;
+
+          if (size > 0) madvise (reader->map + start, size, MADV_WILLNEED);
+
+          reader->advised = start + size;
+        }
+#endif
+
+
+      memcpy (records, reader->map + offset, end - offset);
+
+      return (count);
+    }
+
+
+  for (i = 0 ; i < count ; i++)
+    {
+      if (reader->num_records >= 0 && first + i > reader->num_records) break;
+
+      if (!library_read (reader, first + i, (uint8_t *) records + (int64_t) i * reader->record_size)) break;
+    }
+
+  return (i);
+}
+
+
+
+static int32_t gather_records (RECORD_READER *reader, int32_t first, int32_t count, int32_t offset, int32_t size, void *values)
+{
+  uint8_t            record[sizeof (HYDRO_OUTPUT_T) > sizeof (TOPO_OUTPUT_T) ? sizeof (HYDRO_OUTPUT_T) : sizeof (TOPO_OUTPUT_T)];
+  uint8_t            *src, *dst = (uint8_t *) values;
+  int32_t            i;
+
+
+  if (first < 1 || count < 1) return (0);
+
+
+  if (reader->prefetch != NULL)
+    {
+      if (first > reader->num_records) return (0);
+
+      if (first - 1 + count > reader->num_records) count = reader->num_records - first + 1;
+
+      for (i = 0 ; i < count ; i++, dst += size)
+        {
+          if (prefetch_read (reader->prefetch, reader->head_size + (int64_t) (first - 1 + i) * reader->record_size + offset, size, dst) != size)
+            break;
+        }
+
+      return (i);
+    }
+
+
+  if (reader->mapped)
+    {
+      if (first > reader->num_records) return (0);
+
+      if (first - 1 + count > reader->num_records) count = reader->num_records - first + 1;
+
+      src = reader->map + reader->head_size + (int64_t) (first - 1) * reader->record_size + offset;
+
+      for (i = 0 ; i < count ; i++, src += reader->record_size, dst += size) memcpy (dst, src, size);
+
+      return (count);
+    }
+
+
+  for (i = 0 ; i < count ; i++, dst += size)
+    {
+      if (reader->num_records >= 0 && first + i > reader->num_records) break;
+
+      if (!library_read (reader, first + i, record)) break;
+
+      memcpy (dst, record + offset, size);
+    }
+
+  return (i);
+}
+
+
+
+/*  Read up to count records starting at record number first (1 based) into records.  Returns the
+    number of records read.  */
+
+int32_t reader_read (RECORD_READER *reader, int32_t first, int32_t count, void *records)
+{
+  STAT_TIMER         timer = stats_start ();
+
+
+  count = read_records (reader, first, count, records);
+
+  if (count > 0)
+    {
+      stats_count (STAT_RECORDS_READ, count);
+      stats_count (STAT_BYTES_READ, (int64_t) count * reader->record_size);
+    }
+
+  stats_stop (STAT_READ, timer);
+
+  return (count);
+}
+
+
+
+/*  Copy size bytes at byte offset offset of each of count records starting at record number first
+    (1 based) into values, packed one after another.  With a mapped file nothing else in the
+    records is copied.  Returns the number of records read.  Only the bytes are counted for
+    --stats since one record is usually gathered more than once.  */
+
+int32_t reader_gather (RECORD_READER *reader, int32_t first, int32_t count, int32_t offset, int32_t size, void *values)
+{
+  STAT_TIMER         timer = stats_start ();
+
+
+  count = gather_records (reader, first, count, offset, size, values);
+
+  if (count > 0) stats_count (STAT_BYTES_READ, (int64_t) count * size);
+
+  stats_stop (STAT_READ, timer);
+
+  return (count);
+}
+
+
+
+/*  Tell the kernel how the mapped records will be read.  random is set for scattered reads.  */
+
+void reader_advise (RECORD_READER *reader, uint8_t random)
+{
+#ifndef NVWIN3X
+  if (reader->mapped) madvise (reader->map, reader->map_size, random ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+}
+
+
+
+/*  Seconds this reader has spent waiting for --prefetch reads.  */
+
+double reader_wait (RECORD_READER *reader)
+{
+  if (reader->prefetch == NULL) return (0.0);
+
+  return (prefetch_wait (reader->prefetch));
+}
+
+
+
+void reader_close (RECORD_READER *reader)
+{
+  if (reader->prefetch != NULL) prefetch_close (reader->prefetch);
+
+  reader->prefetch = NULL;
+
+#ifndef NVWIN3X
+  reader_unmap (reader);
+#endif
+}
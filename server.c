@@ -0,0 +1,338 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : server.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --server, answers charts_list queries on a local (Unix domain)
+ *               socket so that a program that looks up one shot at a time
+ *               doesn't pay for starting charts_list and opening the files
+ *               on every lookup.
+ *
+ *               Each connection sends one request, a line of charts_list
+ *               options followed by the file name, separated by spaces or
+ *               tabs:
+ *
+ *                 [-n RECORDS] [-y] [-d] [-s] [-w | -W] [-g LAT,LON] FILE
+ *
+ *               The reply is exactly what charts_list would have written to
+ *               stdout for the same options, after which the server closes
+ *               the connection.  If the request fails the reply ends with a
+ *               line starting with "#error".  The request "quit" shuts the
+ *               server down.  Messages that charts_list would print on stderr
+ *               go to the server's stderr.
+ *
+ *               Requests are answered one at a time in this process.  The
+ *               files stay open between requests (see file_cache.c).  Options
+ *               given with --server on the command line (for example -L or
+ *               --srtm-cache) apply to every request.
+ *
+ *               File names can't contain spaces.  Not available on Windows.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+#ifndef NVWIN3X
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#endif
+
+
+#define SERVER_MAX_REQUEST   65536
+#define SERVER_MAX_ARGS      64
+#define SERVER_TIMEOUT       5                   /*  seconds to wait for a request line  */
+
+
+#ifndef NVWIN3X
+
+/*  Read one request line.  Returns the length or -1 if there isn't a complete line.  */
+
+static int32_t read_request (int32_t fd, char *line)
+{
+  int32_t            size = 0;
+  ssize_t            n;
+
+
+  while (size < SERVER_MAX_REQUEST - 1)
+    {
+      if ((n = read (fd, line + size, SERVER_MAX_REQUEST - 1 - size)) < 0)
+        {
+          if (errno == EINTR) continue;
+          return (-1);
+        }
+
+      if (!n) break;
+
+      size += n;
+      line[size] = 0;
+
+      if (strchr (line, '\n') != NULL) break;
+    }
+
+  line[size] = 0;
+
+  if (!size) return (-1);
+
+  line[strcspn (line, "\r\n")] = 0;
+
+  return ((int32_t) strlen (line));
+}
+
+
+
+/*  Set up options for one request from the server's options.  Returns the file name or NULL (with
+    the reason in error) if the request isn't valid.  */
+
+static char *parse_request (char *line, OPTIONS *base, OPTIONS *options, char *error)
+{
+  char               *arg[SERVER_MAX_ARGS], *file = NULL, *lat, *lon;
+  int32_t            i, count = 0;
+
+
+  *options = *base;
+  record_list_init (&options->records);
+  options->rec_num = -1;
+  options->list_null = NVTrue;
+  options->yxz = NVFalse;
+  options->shot_data = NVFalse;
+  options->water_level = NVFalse;
+  options->average = NVTrue;
+  options->geo_check = NVFalse;
+
+  for (arg[count] = strtok (line, " \t") ; arg[count] != NULL && count < SERVER_MAX_ARGS - 1 ; arg[count] = strtok (NULL, " \t")) count++;
+
+
+  for (i = 0 ; i < count ; i++)
+    {
+      if (!strcmp (arg[i], "-n") && i + 1 < count)
+        {
+          if (record_list_parse (&options->records, arg[++i]))
+            {
+              sprintf (error, "bad record list %.256s", arg[i]);
+              return (NULL);
+            }
+
+          options->rec_num = options->records.range[0].first;
+        }
+      else if (!strcmp (arg[i], "-y"))
+        {
+          options->yxz = NVTrue;
+        }
+      else if (!strcmp (arg[i], "-d"))
+        {
+          options->list_null = NVFalse;
+        }
+      else if (!strcmp (arg[i], "-s"))
+        {
+          options->shot_data = NVTrue;
+        }
+      else if (!strcmp (arg[i], "-w") || !strcmp (arg[i], "-W"))
+        {
+          options->water_level = NVTrue;
+          options->average = (arg[i][1] == 'w');
+        }
+      else if (!strcmp (arg[i], "-g") && i + 1 < count)
+        {
+          if ((lat = strtok (arg[++i], ",")) == NULL || (lon = strtok (NULL, ",")) == NULL)
+            {
+              sprintf (error, "bad position %.256s", arg[i]);
+              return (NULL);
+            }
+
+          posfix (lat, &options->geo.y, POS_LAT);
+          posfix (lon, &options->geo.x, POS_LON);
+
+          options->geo_check = NVTrue;
+        }
+      else if (arg[i][0] != '-' && file == NULL)
+        {
+          file = arg[i];
+        }
+      else
+        {
+          sprintf (error, "unknown or misplaced argument %.256s", arg[i]);
+          return (NULL);
+        }
+    }
+
+
+  if (file == NULL)
+    {
+      strcpy (error, "no file");
+      return (NULL);
+    }
+
+  if (options->geo_check && !options->water_level)
+    {
+      strcpy (error, "-g needs -w or -W");
+      return (NULL);
+    }
+
+  if (options->geo_check) geo_distance_init (&options->geo_ref, options->geo.y, options->geo.x);
+
+  if (options->water_level) options->rec_num = -1;
+
+  return (file);
+}
+
+
+
+/*  Answer one request with stdout pointed at the connection.  */
+
+static void answer (int32_t fd, char *line, OPTIONS *base)
+{
+  OPTIONS            options;
+  char               error[512], *file;
+  int32_t            saved, status = -1;
+
+
+  fflush (stdout);
+
+  saved = dup (1);
+  dup2 (fd, 1);
+
+  if ((file = parse_request (line, base, &options, error)) != NULL)
+    {
+      if ((status = process_file (&options, file, 1, -1))) sprintf (error, "%.480s failed", file);
+    }
+
+  if (status) printf ("#error %s\n", error);
+
+  fflush (stdout);
+
+  dup2 (saved, 1);
+  close (saved);
+
+  record_list_free (&options.records);
+}
+
+#endif
+
+
+
+/*  Serve requests on the socket at path until a quit request.  The cache keeps up to max_files
+    files open.  Returns 0 after a quit or -1 on error.  */
+
+int32_t server_run (OPTIONS *options, char *path, int32_t max_files)
+{
+#ifdef NVWIN3X
+  fprintf (stderr, "\n--server is not available on Windows\n\n");
+  return (-1);
+#else
+  struct sockaddr_un addr;
+  struct stat        st;
+  struct timeval     timeout;
+  char               *line;
+  int32_t            fd, client, status = 0;
+
+
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      fprintf (stderr, "\nSocket path %s is too long\n\n", path);
+      return (-1);
+    }
+
+
+  /*  A socket left behind by a server that didn't shut down cleanly is replaced.  Anything else
+      at that path is left alone.  */
+
+  if (!lstat (path, &st) && S_ISSOCK (st.st_mode)) unlink (path);
+
+  if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    {
+      perror ("Creating server socket");
+      return (-1);
+    }
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+
+  if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 || listen (fd, 16) < 0)
+    {
+      perror (path);
+      close (fd);
+      return (-1);
+    }
+
+  if ((line = (char *) malloc (SERVER_MAX_REQUEST)) == NULL)
+    {
+      perror ("Allocating request memory");
+      exit (-1);
+    }
+
+
+  /*  A client that hangs up early would otherwise kill the server on the next write.  */
+
+  signal (SIGPIPE, SIG_IGN);
+
+  file_cache_init (max_files);
+
+  fprintf (stderr, "Serving requests on %s\n", path);
+
+
+  while (1)
+    {
+      if ((client = accept (fd, NULL, NULL)) < 0)
+        {
+          if (errno == EINTR) continue;
+
+          perror ("Accepting connection");
+          status = -1;
+          break;
+        }
+
+      timeout.tv_sec = SERVER_TIMEOUT;
+      timeout.tv_usec = 0;
+      setsockopt (client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+      if (read_request (client, line) >= 0)
+        {
+          if (!strcmp (line, "quit"))
+            {
+              close (client);
+              break;
+            }
+
+          answer (client, line, options);
+        }
+
+      close (client);
+    }
+
+
+  file_cache_free ();
+  free (line);
+  close (fd);
+  unlink (path);
+
+  return (status);
+#endif
+}
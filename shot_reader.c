@@ -0,0 +1,284 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : shot_reader.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Pipelined HOF and waveform (.inh) reader for -s.
+ *
+ *               A background thread reads batches of HOF records through the
+ *               record reader and the matching waveform records, decodes the
+ *               shot data, and queues the batches in a small ring.  The main
+ *               thread takes batches off the ring in record order, so the two
+ *               files are each read sequentially and ahead of the output
+ *               instead of alternating one record at a time.
+ *
+ *               While a shot reader is open the record reader and the
+ *               waveform file belong to its thread.
+ *
+ ********************************************************************/
+
+#ifndef NVWIN3X
+#include <fcntl.h>
+#endif
+
+#include "charts_list.h"
+
+
+
+/*  Reinterpret the first SHOT_VALUE_COUNT 4 byte words of count waveform records as float,
+    int32_t, and two int16_t values (the order dump_shot_data used to print them in).  */
+
+void decode_shot_data (WAVE_DATA_T *wave, SHOT_VALUES *values, int32_t count)
+{
+  int32_t            k;
+
+
+  for (k = 0 ; k < count ; k++)
+    {
+      memcpy (values[k].f, wave[k].shot_data, sizeof (values[k].f));
+      memcpy (values[k].i32, wave[k].shot_data, sizeof (values[k].i32));
+      memcpy (values[k].i16, wave[k].shot_data, sizeof (values[k].i16));
+    }
+}
+
+
+
+/*  Bytes per waveform record in the file, for the --stats bytes read.  The library's WAVE_DATA_T
+    isn't laid out like the file, so this is how far reading record 2 moves the file past reading
+    record 1.  */
+
+int32_t wave_record_size (FILE *wfp)
+{
+  WAVE_DATA_T        wave_data;
+  long               end;
+
+
+  if (!wave_read_record (wfp, 1, &wave_data) || (end = ftell (wfp)) < 0 || !wave_read_record (wfp, 2, &wave_data) ||
+      ftell (wfp) <= end) return ((int32_t) sizeof (WAVE_DATA_T));
+
+  return ((int32_t) (ftell (wfp) - end));
+}
+
+
+
+/*  wave_read_record, timed and counted for --stats.  size is from wave_record_size.  */
+
+void wave_read (FILE *wfp, int32_t num, WAVE_DATA_T *wave_data, int32_t size)
+{
+  STAT_TIMER         timer = stats_start ();
+
+
+  if (wave_read_record (wfp, num, wave_data)) stats_count (STAT_BYTES_READ, size);
+
+  stats_stop (STAT_READ, timer);
+}
+
+
+
+static void *shot_thread (void *data)
+{
+  SHOT_READER        *shots = (SHOT_READER *) data;
+  SHOT_BATCH         *batch;
+  WAVE_DATA_T        wave_data;
+  int32_t            k, count;
+
+
+  memset (&wave_data, 0, sizeof (WAVE_DATA_T));
+
+
+  for (;;)
+    {
+      pthread_mutex_lock (&shots->mutex);
+
+      while (shots->filled == SHOT_DEPTH && !shots->stop) pthread_cond_wait (&shots->space, &shots->mutex);
+
+      if (shots->stop)
+        {
+          pthread_mutex_unlock (&shots->mutex);
+          break;
+        }
+
+      batch = &shots->batch[shots->tail];
+
+      pthread_mutex_unlock (&shots->mutex);
+
+
+      count = 0;
+
+      if (shots->next <= shots->last)
+        {
+          count = SHOT_BATCH_RECORDS;
+          if (shots->last - shots->next < count) count = shots->last - shots->next + 1;
+
+          count = reader_read (shots->reader, shots->next, count, batch->hof);
+
+
+          /*  A failed waveform read leaves the previous record's data, the same as wave_read_record
+              into a reused WAVE_DATA_T always did.  */
+
+          for (k = 0 ; k < count ; k++)
+            {
+              wave_read (shots->wfp, shots->next + k, &wave_data, shots->wave_size);
+              decode_shot_data (&wave_data, &batch->values[k], 1);
+            }
+        }
+
+      batch->first = shots->next;
+      batch->count = count;
+
+      if (count > 0) shots->next += count;
+
+
+      pthread_mutex_lock (&shots->mutex);
+
+      shots->tail = (shots->tail + 1) % SHOT_DEPTH;
+      shots->filled++;
+
+      pthread_cond_signal (&shots->ready);
+      pthread_mutex_unlock (&shots->mutex);
+
+      if (count <= 0) break;
+    }
+
+  return (NULL);
+}
+
+
+
+/*  Start reading records first through last (1 based).  Returns 0 on success or -1 on error.  */
+
+int32_t shot_reader_open (SHOT_READER *shots, RECORD_READER *reader, FILE *wfp, int32_t first, int32_t last)
+{
+  int32_t            i;
+
+
+  memset (shots, 0, sizeof (SHOT_READER));
+
+  shots->reader = reader;
+  shots->wfp = wfp;
+  shots->wave_size = wave_record_size (wfp);
+  shots->next = first;
+  shots->last = last;
+
+  for (i = 0 ; i < SHOT_DEPTH ; i++)
+    {
+      if ((shots->batch[i].hof = (HYDRO_OUTPUT_T *) malloc (SHOT_BATCH_RECORDS * sizeof (HYDRO_OUTPUT_T))) == NULL ||
+          (shots->batch[i].values = (SHOT_VALUES *) malloc (SHOT_BATCH_RECORDS * sizeof (SHOT_VALUES))) == NULL)
+        {
+          perror ("Allocating shot reader memory");
+          exit (-1);
+        }
+    }
+
+
+#if !defined (NVWIN3X) && defined (POSIX_FADV_SEQUENTIAL)
+  posix_fadvise (fileno (wfp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+
+  pthread_mutex_init (&shots->mutex, NULL);
+  pthread_cond_init (&shots->ready, NULL);
+  pthread_cond_init (&shots->space, NULL);
+
+  if (pthread_create (&shots->thread, NULL, shot_thread, shots))
+    {
+      perror ("Starting shot reader");
+      shot_reader_close (shots);
+      return (-1);
+    }
+
+  shots->running = NVTrue;
+
+  return (0);
+}
+
+
+
+/*  Return the next batch in record order or NULL at the end.  The batch stays valid until the next
+    call.  */
+
+SHOT_BATCH *shot_reader_next (SHOT_READER *shots)
+{
+  SHOT_BATCH         *batch;
+
+
+  pthread_mutex_lock (&shots->mutex);
+
+  if (shots->holding)
+    {
+      shots->head = (shots->head + 1) % SHOT_DEPTH;
+      shots->filled--;
+      shots->holding = NVFalse;
+
+      pthread_cond_signal (&shots->space);
+    }
+
+  while (!shots->filled) pthread_cond_wait (&shots->ready, &shots->mutex);
+
+  batch = &shots->batch[shots->head];
+  shots->holding = NVTrue;
+
+  pthread_mutex_unlock (&shots->mutex);
+
+
+  if (batch->count <= 0) return (NULL);
+
+  return (batch);
+}
+
+
+
+void shot_reader_close (SHOT_READER *shots)
+{
+  int32_t            i;
+
+
+  if (shots->running)
+    {
+      pthread_mutex_lock (&shots->mutex);
+      shots->stop = NVTrue;
+      pthread_cond_signal (&shots->space);
+      pthread_mutex_unlock (&shots->mutex);
+
+      pthread_join (shots->thread, NULL);
+
+      shots->running = NVFalse;
+    }
+
+  pthread_mutex_destroy (&shots->mutex);
+  pthread_cond_destroy (&shots->ready);
+  pthread_cond_destroy (&shots->space);
+
+  for (i = 0 ; i < SHOT_DEPTH ; i++)
+    {
+      free (shots->batch[i].hof);
+      free (shots->batch[i].values);
+
+      shots->batch[i].hof = NULL;
+      shots->batch[i].values = NULL;
+    }
+}
@@ -0,0 +1,271 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : srtm_cache.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Cache of read_srtm_mask results for -w and -W.
+ *
+ *               The cache is a set of one degree tiles, each holding a 2 bit
+ *               code per cell (0 = not read yet, otherwise the mask value
+ *               plus one).  Cells are 1.5 arc seconds, half of the 3 second
+ *               mask posting, so every cell lies inside one mask cell whether
+ *               the library picks the posting by truncating or by rounding.
+ *               A cell is filled from read_srtm_mask the first time a shot
+ *               lands in it.
+ *
+ *               Tiles are evicted least recently used once the memory cap is
+ *               reached.  The tiles live in one shared anonymous mapping
+ *               created before the workers are forked, so every worker (and
+ *               every file) uses the same cache.  Tile replacement and cell
+ *               updates are done under a process shared mutex.  Lookups don't
+ *               lock; each tile slot has a sequence number that is odd while
+ *               the slot is being replaced, and a lookup that sees it change
+ *               starts over.  Consecutive shots in the same tile skip the tile
+ *               search entirely.
+ *
+ ********************************************************************/
+
+#ifndef NVWIN3X
+#include <sys/mman.h>
+#endif
+
+#include "charts_list.h"
+
+
+#define SRTM_CELLS         2400                                /*  cells per degree  */
+#define SRTM_TILE_BYTES    (SRTM_CELLS * SRTM_CELLS / 4)
+
+
+typedef struct
+{
+  int32_t            key;                        /*  tile number, -1 if unused  */
+  uint32_t           seq;                        /*  odd while the slot is being replaced  */
+  uint64_t           last_used;
+} SRTM_SLOT;
+
+typedef struct
+{
+  pthread_mutex_t    mutex;
+  uint64_t           clock;
+  int32_t            num_slots;
+  uint8_t            *tiles;
+  SRTM_SLOT          slot[1];
+} SRTM_CACHE;
+
+
+static SRTM_CACHE    *cache = NULL;
+static size_t        cache_size = 0;
+
+
+/*  The tile the last shot was in (per process).  */
+
+static int32_t       last_key = -1, last_slot = -1;
+static uint32_t      last_seq = 0;
+
+
+
+/*  Set up a cache of at most megabytes MB.  0 leaves the cache off and srtm_cache_read calls
+    read_srtm_mask directly.  Must be called before the workers are started.  */
+
+void srtm_cache_init (int32_t megabytes)
+{
+  pthread_mutexattr_t attr;
+  int32_t            i, num_slots;
+  size_t             head_size;
+
+
+  num_slots = (int32_t) (((int64_t) megabytes * 1048576) / SRTM_TILE_BYTES);
+
+  if (num_slots < 1) return;
+
+
+  head_size = (sizeof (SRTM_CACHE) + num_slots * sizeof (SRTM_SLOT) + 4095) & ~((size_t) 4095);
+  cache_size = head_size + (size_t) num_slots * SRTM_TILE_BYTES;
+
+
+#ifdef NVWIN3X
+  cache = (SRTM_CACHE *) calloc (1, cache_size);
+#else
+  if ((cache = (SRTM_CACHE *) mmap (NULL, cache_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+    cache = NULL;
+#endif
+
+  if (cache == NULL)
+    {
+      perror ("Allocating SRTM mask cache, continuing without it");
+      return;
+    }
+
+
+  pthread_mutexattr_init (&attr);
+#ifndef NVWIN3X
+  pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+#endif
+  pthread_mutex_init (&cache->mutex, &attr);
+  pthread_mutexattr_destroy (&attr);
+
+  cache->num_slots = num_slots;
+  cache->tiles = (uint8_t *) cache + head_size;
+
+  for (i = 0 ; i < num_slots ; i++) cache->slot[i].key = -1;
+}
+
+
+
+void srtm_cache_free ()
+{
+  if (cache == NULL) return;
+
+  pthread_mutex_destroy (&cache->mutex);
+
+#ifdef NVWIN3X
+  free (cache);
+#else
+  munmap (cache, cache_size);
+#endif
+
+  cache = NULL;
+}
+
+
+
+/*  Find or load the slot for tile key and make it the current tile.  */
+
+static void srtm_cache_tile (int32_t key)
+{
+  SRTM_SLOT          *slot;
+  int32_t            i, lru = 0;
+
+
+  pthread_mutex_lock (&cache->mutex);
+
+  for (i = 0 ; i < cache->num_slots ; i++)
+    {
+      if (cache->slot[i].key == key) break;
+
+      if (cache->slot[i].last_used < cache->slot[lru].last_used) lru = i;
+    }
+
+
+  /*  Not cached, replace the least recently used tile.  */
+
+  if (i == cache->num_slots)
+    {
+      i = lru;
+      slot = &cache->slot[i];
+
+      __atomic_store_n (&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+
+      memset (cache->tiles + (size_t) i * SRTM_TILE_BYTES, 0, SRTM_TILE_BYTES);
+      slot->key = key;
+
+      __atomic_store_n (&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+    }
+
+  cache->slot[i].last_used = ++cache->clock;
+
+  last_key = key;
+  last_slot = i;
+  last_seq = cache->slot[i].seq;
+
+  pthread_mutex_unlock (&cache->mutex);
+}
+
+
+
+static int32_t srtm_lookup (double lat, double lon)
+{
+  SRTM_SLOT          *slot;
+  uint8_t            *byte;
+  int32_t            key, row, col, cell, shift, code, value;
+  double             lat_floor, lon_floor;
+
+
+  if (cache == NULL || !(lat >= -90.0 && lat < 90.0 && lon >= -180.0 && lon < 180.0)) return (read_srtm_mask (lat, lon));
+
+
+  lat_floor = floor (lat);
+  lon_floor = floor (lon);
+
+  key = ((int32_t) lat_floor + 90) * 360 + ((int32_t) lon_floor + 180);
+
+  if ((row = (int32_t) ((lat - lat_floor) * SRTM_CELLS)) >= SRTM_CELLS) row = SRTM_CELLS - 1;
+  if ((col = (int32_t) ((lon - lon_floor) * SRTM_CELLS)) >= SRTM_CELLS) col = SRTM_CELLS - 1;
+
+  cell = row * SRTM_CELLS + col;
+  shift = (cell & 3) * 2;
+
+
+  for (;;)
+    {
+      if (key != last_key || __atomic_load_n (&cache->slot[last_slot].seq, __ATOMIC_ACQUIRE) != last_seq) srtm_cache_tile (key);
+
+      slot = &cache->slot[last_slot];
+      byte = cache->tiles + (size_t) last_slot * SRTM_TILE_BYTES + (cell >> 2);
+
+      code = (__atomic_load_n (byte, __ATOMIC_RELAXED) >> shift) & 3;
+
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+
+      if (__atomic_load_n (&slot->seq, __ATOMIC_RELAXED) == last_seq) break;
+    }
+
+  if (code) return (code - 1);
+
+
+  /*  First shot in this cell.  Only 0, 1, and 2 fit in the code, anything else isn't cached.  */
+
+  value = read_srtm_mask (lat, lon);
+
+  if (value >= 0 && value <= 2)
+    {
+      pthread_mutex_lock (&cache->mutex);
+
+      if (slot->seq == last_seq && slot->key == key) *byte |= (uint8_t) ((value + 1) << shift);
+
+      pthread_mutex_unlock (&cache->mutex);
+    }
+
+  return (value);
+}
+
+
+
+/*  Same as read_srtm_mask (lat, lon) but cached.  */
+
+int32_t srtm_cache_read (double lat, double lon)
+{
+  STAT_TIMER         timer = stats_start ();
+  int32_t            value;
+
+
+  value = srtm_lookup (lat, lon);
+
+  stats_stop (STAT_SRTM, timer);
+
+  return (value);
+}
@@ -0,0 +1,413 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : state.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --incremental, keeps the output of each file in a state
+ *               directory so that later runs with the same options only
+ *               process the files that are new or have changed.
+ *
+ *               There is one state file per data file and set of options,
+ *               named for a hash of the data file's full path and the option
+ *               signature (the output affecting command line options and the
+ *               charts_list version, built by main).  It holds:
+ *
+ *                 STATE_HEADER
+ *                 path              path_size bytes
+ *                 signature         signature_size bytes
+ *                 stdout text       out_size bytes
+ *                 stderr text       err_size bytes
+ *
+ *               The signature also has hashes of the --polygon vertices and
+ *               the -n record list (see state_sign_options), since those can
+ *               come from files that change between runs under the same
+ *               command line.
+ *
+ *               The saved output is replayed instead of processing the file
+ *               when the data file still has the same size, modification
+ *               time (to the nanosecond where there is one), and fingerprint.  The fingerprint is a 64 bit FNV-1a
+ *               hash of the first and last STATE_SAMPLE bytes of the file,
+ *               so a file that was rewritten in the same second with the
+ *               same size is still caught if its header or ends changed.
+ *
+ *               State files are written to a temporary name and renamed, so
+ *               workers can update the directory at the same time and an
+ *               interrupted run never leaves a partial entry.  Runs that
+ *               fail aren't saved.  Entries for files that no longer exist
+ *               are left alone (delete the directory to start over).
+ *
+ ********************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <limits.h>
+
+#include "charts_list.h"
+
+
+#define STATE_SAMPLE         65536
+
+#define FNV_OFFSET           0xcbf29ce484222325ULL
+#define FNV_PRIME            0x100000001b3ULL
+
+
+
+static uint64_t fnv_add (uint64_t hash, const uint8_t *data, int64_t size)
+{
+  int64_t            i;
+
+
+  for (i = 0 ; i < size ; i++)
+    {
+      hash ^= data[i];
+      hash *= FNV_PRIME;
+    }
+
+  return (hash);
+}
+
+
+
+/*  Size, modification time, and fingerprint of file.  Returns 0 on success.  */
+
+static int32_t source_state (char *file, STATE_HEADER *header)
+{
+  struct stat        st;
+  uint8_t            *buffer;
+  int32_t            fd;
+  int64_t            size, offset;
+  ssize_t            n;
+  uint64_t           hash = FNV_OFFSET;
+
+
+  if (stat (file, &st)) return (-1);
+
+  header->source_size = (int64_t) st.st_size;
+  header->source_mtime = (int64_t) st.st_mtime;
+
+#if defined (NVWIN3X)
+  header->source_mtime_ns = 0;
+#elif defined (__APPLE__)
+  header->source_mtime_ns = (int64_t) st.st_mtimespec.tv_nsec;
+#else
+  header->source_mtime_ns = (int64_t) st.st_mtim.tv_nsec;
+#endif
+
+  if ((fd = open (file, O_RDONLY)) < 0) return (-1);
+
+  if ((buffer = (uint8_t *) malloc (STATE_SAMPLE)) == NULL)
+    {
+      perror ("Allocating state memory");
+      exit (-1);
+    }
+
+
+  /*  The two samples overlap (or are the same) for small files, which is fine.  */
+
+  for (offset = 0 ; ; offset = header->source_size - STATE_SAMPLE)
+    {
+      if (offset < 0) offset = 0;
+
+      size = header->source_size - offset < STATE_SAMPLE ? header->source_size - offset : STATE_SAMPLE;
+
+      if ((n = pread (fd, buffer, size, offset)) != size)
+        {
+          free (buffer);
+          close (fd);
+          return (-1);
+        }
+
+      hash = fnv_add (hash, buffer, size);
+
+      if (offset + size >= header->source_size) break;
+    }
+
+  free (buffer);
+  close (fd);
+
+  header->fingerprint = hash;
+
+  return (0);
+}
+
+
+
+/*  Add hashes of what --polygon and -n read to the option signature, which only has the command
+    line text (a file name for --polygon and -n @FILE).  */
+
+void state_sign_options (OPTIONS *options)
+{
+  uint64_t           poly = FNV_OFFSET, records = FNV_OFFSET;
+  char               *signature;
+  size_t             size;
+
+
+  if (options->filter.poly_count)
+    {
+      poly = fnv_add (poly, (uint8_t *) options->filter.poly_lat, options->filter.poly_count * sizeof (double));
+      poly = fnv_add (poly, (uint8_t *) options->filter.poly_lon, options->filter.poly_count * sizeof (double));
+    }
+
+  if (options->records.count) records = fnv_add (records, (uint8_t *) options->records.range, options->records.count * sizeof (RECORD_RANGE));
+
+  size = strlen (options->state_signature) + 80;
+
+  if ((signature = (char *) malloc (size)) == NULL)
+    {
+      perror ("Allocating signature memory");
+      exit (-1);
+    }
+
+  snprintf (signature, size, "%s\npolygon %016llx\nrecords %016llx", options->state_signature, (unsigned long long) poly,
+            (unsigned long long) records);
+
+  free (options->state_signature);
+  options->state_signature = signature;
+}
+
+
+
+/*  State file name for file.  Returns 0 on success.  */
+
+static int32_t state_path (OPTIONS *options, char *file, char *full, char *path, int32_t size)
+{
+  uint64_t           hash = FNV_OFFSET;
+
+
+  if (realpath (file, full) == NULL) return (-1);
+
+  hash = fnv_add (hash, (uint8_t *) full, strlen (full) + 1);
+  hash = fnv_add (hash, (uint8_t *) options->state_signature, strlen (options->state_signature));
+
+  snprintf (path, size, "%s/%016llx%s", options->state_dir, (unsigned long long) hash, STATE_SUFFIX);
+
+  return (0);
+}
+
+
+
+static void copy_bytes (FILE *src, FILE *dst, int64_t size)
+{
+  char               buffer[65536];
+  size_t             n;
+
+
+  while (size > 0 && (n = fread (buffer, 1, size < (int64_t) sizeof (buffer) ? (size_t) size : sizeof (buffer), src)) > 0)
+    {
+      fwrite (buffer, 1, n, dst);
+      size -= n;
+    }
+}
+
+
+
+/*  Replay the saved output for file if it's current.  Returns 0 if it was replayed.  */
+
+static int32_t replay (OPTIONS *options, char *full, char *path, STATE_HEADER *current)
+{
+  FILE               *fp;
+  STATE_HEADER       header;
+  char               *saved;
+  int32_t            match;
+
+
+  if ((fp = fopen (path, "rb")) == NULL) return (-1);
+
+  if (fread (&header, sizeof (STATE_HEADER), 1, fp) != 1 ||
+      memcmp (header.magic, STATE_MAGIC, sizeof (header.magic)) ||
+      header.byte_order != 0x01020304 ||
+      header.version != STATE_VERSION ||
+      header.header_size != sizeof (STATE_HEADER) ||
+      header.source_size != current->source_size ||
+      header.source_mtime != current->source_mtime ||
+      header.source_mtime_ns != current->source_mtime_ns ||
+      header.fingerprint != current->fingerprint ||
+      header.path_size != strlen (full) ||
+      header.signature_size != strlen (options->state_signature))
+    {
+      fclose (fp);
+      return (-1);
+    }
+
+
+  /*  Make sure it's really this file and these options and not a hash collision.  */
+
+  if ((saved = (char *) malloc (header.path_size + header.signature_size + 1)) == NULL)
+    {
+      perror ("Allocating state memory");
+      exit (-1);
+    }
+
+  match = (fread (saved, 1, header.path_size + header.signature_size, fp) == header.path_size + header.signature_size &&
+           !memcmp (saved, full, header.path_size) && !memcmp (saved + header.path_size, options->state_signature, header.signature_size));
+
+  free (saved);
+
+  if (!match)
+    {
+      fclose (fp);
+      return (-1);
+    }
+
+
+  copy_bytes (fp, stdout, header.out_size);
+  copy_bytes (fp, stderr, header.err_size);
+
+  fclose (fp);
+
+  return (0);
+}
+
+
+
+/*  Save the captured output.  */
+
+static void save (OPTIONS *options, char *full, char *path, STATE_HEADER *header, FILE *out, FILE *err)
+{
+  char               temp[PATH_MAX + 96];
+  FILE               *fp;
+
+
+  memset (header->magic, 0, sizeof (header->magic));
+  memcpy (header->magic, STATE_MAGIC, sizeof (header->magic));
+  header->byte_order = 0x01020304;
+  header->version = STATE_VERSION;
+  header->header_size = sizeof (STATE_HEADER);
+  header->path_size = strlen (full);
+  header->signature_size = strlen (options->state_signature);
+  header->out_size = ftell (out);
+  header->err_size = ftell (err);
+
+  snprintf (temp, sizeof (temp), "%s.%d", path, (int32_t) getpid ());
+
+  if ((fp = fopen (temp, "wb")) == NULL)
+    {
+      perror (temp);
+      return;
+    }
+
+  fwrite (header, sizeof (STATE_HEADER), 1, fp);
+  fwrite (full, 1, header->path_size, fp);
+  fwrite (options->state_signature, 1, header->signature_size, fp);
+
+  rewind (out);
+  copy_bytes (out, fp, header->out_size);
+  rewind (err);
+  copy_bytes (err, fp, header->err_size);
+
+  if (fclose (fp) || rename (temp, path))
+    {
+      perror (path);
+      unlink (temp);
+    }
+}
+
+
+
+/*  Process file with func (process_file's worker) unless its saved output is current, in which
+    case the saved output is written instead.  Returns func's status, 0 for a replay.  */
+
+int32_t state_file (OPTIONS *options, char *file, STATE_FUNC func)
+{
+  char               full[PATH_MAX], path[PATH_MAX + 64];
+  STATE_HEADER       header;
+  FILE               *out, *err;
+  int32_t            status, saved_out, saved_err;
+
+
+  memset (&header, 0, sizeof (STATE_HEADER));
+
+  if (source_state (file, &header) || state_path (options, file, full, path, sizeof (path))) return ((*func) (options, file, 1, -1));
+
+  if (!replay (options, full, path, &header)) return (0);
+
+
+  /*  Capture everything the file writes on stdout and stderr (the library dump functions write
+      straight to stdout) so it can be saved, then pass it on.  */
+
+  if ((out = tmpfile ()) == NULL || (err = tmpfile ()) == NULL)
+    {
+      perror ("Creating state output file");
+      if (out != NULL) fclose (out);
+      return ((*func) (options, file, 1, -1));
+    }
+
+  fflush (stdout);
+  fflush (stderr);
+
+
+  /*  If stdout or stderr can't be saved it couldn't be put back, so run the file uncaptured.  */
+
+  saved_out = dup (1);
+  saved_err = dup (2);
+
+  if (saved_out < 0 || saved_err < 0 || dup2 (fileno (out), 1) < 0 || dup2 (fileno (err), 2) < 0)
+    {
+      if (saved_out >= 0)
+        {
+          dup2 (saved_out, 1);
+          close (saved_out);
+        }
+
+      if (saved_err >= 0)
+        {
+          dup2 (saved_err, 2);
+          close (saved_err);
+        }
+
+      perror ("Capturing state output");
+      fclose (out);
+      fclose (err);
+      return ((*func) (options, file, 1, -1));
+    }
+
+  status = (*func) (options, file, 1, -1);
+
+  fflush (stdout);
+  fflush (stderr);
+
+  dup2 (saved_out, 1);
+  dup2 (saved_err, 2);
+  close (saved_out);
+  close (saved_err);
+
+  fseek (out, 0, SEEK_END);
+  fseek (err, 0, SEEK_END);
+
+  if (!status) save (options, full, path, &header, out, err);
+
+  rewind (out);
+  copy_bytes (out, stdout, INT64_MAX);
+  rewind (err);
+  copy_bytes (err, stderr, INT64_MAX);
+
+  fclose (out);
+  fclose (err);
+
+  return (status);
+}
@@ -0,0 +1,259 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : stats.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : --stats, phase timing and counters for a run.
+ *
+ *               Phases are timed with stats_start/stats_stop pairs.  Phases
+ *               can be nested and each phase only gets the time that wasn't
+ *               spent in the phases inside it, so the phase times add up to
+ *               the time spent in process_file.  A stats_stop that is skipped
+ *               (an error return) just loses that phase's time.  The nesting
+ *               is tracked per thread, so the -s reader thread's read time is
+ *               never taken out of the main thread's phases, and the counters
+ *               are added to atomically, so the threads of a process can all
+ *               count at once.  A phase that runs on a helper thread while
+ *               the main thread is busy is counted in full, the same as time
+ *               on another worker.
+ *
+ *               Each process adds to its own counters and stats_flush adds
+ *               them to a shared mapping after every job, so the report
+ *               covers every worker.  With --stats off every call returns
+ *               right away.
+ *
+ *               Phase times are summed over all workers, so with more than
+ *               one worker they can add up to more than the wall time.  Text
+ *               that the CHARTS library prints itself (hof_dump_record and
+ *               tof_dump_record) isn't counted in bytes written.
+ *
+ ********************************************************************/
+
+#ifndef NVWIN3X
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+#include "charts_list.h"
+
+
+static char *phase_name[STAT_PHASES] = {"open", "read", "filter", "srtm", "geodesic", "format", "write"};
+
+static char *count_name[STAT_COUNTS] = {"files", "records_read", "bytes_read", "bytes_written", "rejected_filter", "rejected_null",
+                                        "rejected_abdc", "rejected_data_type", "rejected_land", "rejected_edge"};
+
+
+typedef struct
+{
+  int64_t            ns[STAT_PHASES];
+  int64_t            count[STAT_COUNTS];
+} STATS;
+
+
+static uint8_t       stats_mode = STATS_OFF;
+static STATS         local, *shared = NULL;      /*  local is shared by this process's threads  */
+static __thread double inner = 0.0;              /*  time already given to phases on this thread  */
+static double        run_start;
+
+
+
+/*  Turn the statistics on (STATS_TEXT or STATS_JSON).  Must be called before the workers are
+    started.  */
+
+void stats_init (int32_t mode)
+{
+  stats_mode = mode;
+
+  run_start = wall_clock ();
+
+  memset (&local, 0, sizeof (STATS));
+
+  if (stats_mode == STATS_OFF) return;
+
+
+#ifdef NVWIN3X
+  shared = (STATS *) calloc (1, sizeof (STATS));
+#else
+  if ((shared = (STATS *) mmap (NULL, sizeof (STATS), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+    shared = NULL;
+#endif
+
+  if (shared == NULL)
+    {
+      perror ("Allocating statistics memory");
+      exit (-1);
+    }
+
+  memset (shared, 0, sizeof (STATS));
+}
+
+
+
+STAT_TIMER stats_start ()
+{
+  STAT_TIMER         timer;
+
+
+  if (stats_mode == STATS_OFF)
+    {
+      timer.start = timer.inner = 0.0;
+      return (timer);
+    }
+
+  timer.start = wall_clock ();
+  timer.inner = inner;
+
+  return (timer);
+}
+
+
+
+void stats_stop (int32_t phase, STAT_TIMER timer)
+{
+  double             elapsed;
+
+
+  if (stats_mode == STATS_OFF) return;
+
+  elapsed = (wall_clock () - timer.start) - (inner - timer.inner);
+
+  if (elapsed < 0.0) elapsed = 0.0;
+
+  inner += elapsed;
+  __atomic_fetch_add (&local.ns[phase], (int64_t) (elapsed * 1.0e9), __ATOMIC_RELAXED);
+}
+
+
+
+void stats_count (int32_t counter, int64_t n)
+{
+  if (stats_mode == STATS_OFF) return;
+
+  __atomic_fetch_add (&local.count[counter], n, __ATOMIC_RELAXED);
+}
+
+
+
+/*  Add this process's numbers to the shared totals.  */
+
+void stats_flush ()
+{
+  int32_t            i;
+
+
+  if (stats_mode == STATS_OFF) return;
+
+  for (i = 0 ; i < STAT_PHASES ; i++)
+    __atomic_fetch_add (&shared->ns[i], __atomic_exchange_n (&local.ns[i], 0, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+  for (i = 0 ; i < STAT_COUNTS ; i++)
+    __atomic_fetch_add (&shared->count[i], __atomic_exchange_n (&local.count[i], 0, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+
+
+/*  Print the report to stderr and release the shared totals.  */
+
+void stats_report ()
+{
+  double             wall, user = 0.0, sys = 0.0, records;
+  int32_t            i;
+  int64_t            max_rss = 0;
+
+
+  if (stats_mode == STATS_OFF) return;
+
+  stats_flush ();
+
+  wall = wall_clock () - run_start;
+
+
+#ifndef NVWIN3X
+  {
+    struct rusage    self, children;
+
+    getrusage (RUSAGE_SELF, &self);
+    getrusage (RUSAGE_CHILDREN, &children);
+
+    user = self.ru_utime.tv_sec + self.ru_utime.tv_usec * 1.0e-6 + children.ru_utime.tv_sec + children.ru_utime.tv_usec * 1.0e-6;
+    sys = self.ru_stime.tv_sec + self.ru_stime.tv_usec * 1.0e-6 + children.ru_stime.tv_sec + children.ru_stime.tv_usec * 1.0e-6;
+
+
+    /*  Kilobytes on Linux.  The children figure is the largest single worker.  */
+
+    max_rss = self.ru_maxrss > children.ru_maxrss ? self.ru_maxrss : children.ru_maxrss;
+  }
+#endif
+
+
+  records = (double) shared->count[STAT_RECORDS_READ];
+
+  if (stats_mode == STATS_JSON)
+    {
+      fprintf (stderr, "{\"wall_seconds\": %.6f, \"cpu_user_seconds\": %.6f, \"cpu_system_seconds\": %.6f, \"records_per_second\": %.1f, \"max_rss_kb\": %lld",
+               wall, user, sys, wall > 0.0 ? records / wall : 0.0, (long long) max_rss);
+
+      fprintf (stderr, ", \"phase_seconds\": {");
+      for (i = 0 ; i < STAT_PHASES ; i++) fprintf (stderr, "%s\"%s\": %.6f", i ? ", " : "", phase_name[i], shared->ns[i] * 1.0e-9);
+      fprintf (stderr, "}");
+
+      for (i = 0 ; i < STAT_COUNTS ; i++) fprintf (stderr, ", \"%s\": %lld", count_name[i], (long long) shared->count[i]);
+
+      fprintf (stderr, "}\n");
+    }
+  else
+    {
+      fprintf (stderr, "\nStatistics:\n\n");
+      fprintf (stderr, "  wall time            %12.3f s\n", wall);
+      fprintf (stderr, "  CPU time             %12.3f s user, %.3f s system\n", user, sys);
+      fprintf (stderr, "  records read         %12lld  (%.0f records/s)\n", (long long) shared->count[STAT_RECORDS_READ],
+               wall > 0.0 ? records / wall : 0.0);
+      fprintf (stderr, "  bytes read           %12lld  (%.1f MB/s)\n", (long long) shared->count[STAT_BYTES_READ],
+               wall > 0.0 ? shared->count[STAT_BYTES_READ] / wall / 1048576.0 : 0.0);
+      fprintf (stderr, "  bytes written        %12lld\n", (long long) shared->count[STAT_BYTES_WRITTEN]);
+      fprintf (stderr, "  files                %12lld\n", (long long) shared->count[STAT_FILES]);
+      fprintf (stderr, "  peak memory          %12lld KB\n\n", (long long) max_rss);
+
+      fprintf (stderr, "  phase times (all workers):\n");
+      for (i = 0 ; i < STAT_PHASES ; i++) fprintf (stderr, "    %-18s %12.3f s\n", phase_name[i], shared->ns[i] * 1.0e-9);
+
+      fprintf (stderr, "\n  records rejected:\n");
+      for (i = STAT_REJECTED_FILTER ; i < STAT_COUNTS ; i++) fprintf (stderr, "    %-18s %12lld\n", &count_name[i][9], (long long) shared->count[i]);
+
+      fprintf (stderr, "\n");
+    }
+
+
+#ifdef NVWIN3X
+  free (shared);
+#else
+  munmap (shared, sizeof (STATS));
+#endif
+
+  shared = NULL;
+  stats_mode = STATS_OFF;
+}
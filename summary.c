@@ -0,0 +1,506 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : summary.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Per file summary and the sidecar index that stores it.
+ *
+ *               The sidecar (INPUT_FILE.clx) holds a SUMMARY_HEADER followed
+ *               by one SUMMARY_BLOCK for every SUMMARY_BLOCK_SIZE records.
+ *               The header has the record count, time range, position
+ *               bounds, null and zero tide counts, and data_type/abdc
+ *               histograms.  Each block has the time and position bounds of
+ *               its records so that filters can skip whole blocks.
+ *
+ *               A sidecar is only used if the size and modification time
+ *               of the data file match the values stored in it, so a
+ *               rewritten data file is never paired with a stale summary.
+ *               The modification time is compared to the nanosecond, since
+ *               re-tiding rewrites tide_cor_depth in place without changing
+ *               the size and can easily finish in the second the sidecar was
+ *               built in.
+ *
+ ********************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "charts_list.h"
+
+
+
+static void summary_path (char *file, char *path, int32_t size)
+{
+  snprintf (path, size, "%s%s", file, SUMMARY_SUFFIX);
+}
+
+
+
+static int32_t source_stat (char *file, SUMMARY_HEADER *header)
+{
+  struct stat        st;
+
+
+  if (stat (file, &st)) return (-1);
+
+  header->source_size = (int64_t) st.st_size;
+  header->source_mtime = (int64_t) st.st_mtime;
+
+#if defined (NVWIN3X)
+  header->source_mtime_ns = 0;
+#elif defined (__APPLE__)
+  header->source_mtime_ns = (int64_t) st.st_mtimespec.tv_nsec;
+#else
+  header->source_mtime_ns = (int64_t) st.st_mtim.tv_nsec;
+#endif
+
+  return (0);
+}
+
+
+
+static void summary_init (SUMMARY *summary, int32_t type)
+{
+  memset (&summary->header, 0, sizeof (SUMMARY_HEADER));
+
+  memcpy (summary->header.magic, SUMMARY_MAGIC, sizeof (summary->header.magic));
+  summary->header.byte_order = 0x01020304;
+  summary->header.version = SUMMARY_VERSION;
+  summary->header.header_size = sizeof (SUMMARY_HEADER);
+  summary->header.block_size = SUMMARY_BLOCK_SIZE;
+  summary->header.record_type = type;
+  summary->header.min_time = INT64_MAX;
+  summary->header.max_time = INT64_MIN;
+  summary->header.min_lat = summary->header.min_lon = 1.0e300;
+  summary->header.max_lat = summary->header.max_lon = -1.0e300;
+
+  summary->block = NULL;
+}
+
+
+
+static void block_init (SUMMARY_BLOCK *block)
+{
+  memset (block, 0, sizeof (SUMMARY_BLOCK));
+
+  block->min_time = INT64_MAX;
+  block->max_time = INT64_MIN;
+  block->min_lat = block->min_lon = 1.0e300;
+  block->max_lat = block->max_lon = -1.0e300;
+}
+
+
+
+static inline void block_add (SUMMARY_BLOCK *block, int64_t timestamp, double lat, double lon)
+{
+  if (timestamp < block->min_time) block->min_time = timestamp;
+  if (timestamp > block->max_time) block->max_time = timestamp;
+  if (lat < block->min_lat) block->min_lat = lat;
+  if (lat > block->max_lat) block->max_lat = lat;
+  if (lon < block->min_lon) block->min_lon = lon;
+  if (lon > block->max_lon) block->max_lon = lon;
+}
+
+
+
+static inline int32_t histogram_bin (double value, int32_t bins)
+{
+  if (value < 0.0 || value >= (double) bins || value != floor (value)) return (bins);
+
+  return ((int32_t) value);
+}
+
+
+
+/*  Read every record of file and fill in summary.  Returns 0 on success or -1 on error.  */
+
+int32_t summary_build (OPTIONS *options, char *file, SUMMARY *summary)
+{
+  FILE               *fp;
+  HOF_HEADER_T       hof_header;
+  RECORD_READER      reader;
+  HYDRO_OUTPUT_T     *hof_batch = NULL, *hof;
+  TOPO_OUTPUT_T      *tof_batch = NULL, *tof;
+  SUMMARY_HEADER     *head = &summary->header;
+  SUMMARY_BLOCK      *block = NULL;
+  int32_t            type, start, count, i, size = 0;
+
+
+  if (strstr (file, ".hof"))
+    {
+      if ((fp = open_hof_file (file)) == NULL)
+        {
+          perror (file);
+          return (-1);
+        }
+
+      type = 0;
+
+      hof_read_header (fp, &hof_header);
+
+      reader_open (&reader, fp, file, type, hof_header.text.number_shots, options->use_library);
+
+      hof_batch = (HYDRO_OUTPUT_T *) malloc (READ_BATCH * sizeof (HYDRO_OUTPUT_T));
+    }
+  else if (strstr (file, ".tof"))
+    {
+      if ((fp = open_tof_file (file)) == NULL)
+        {
+          perror (file);
+          return (-1);
+        }
+
+      type = 1;
+
+      reader_open (&reader, fp, file, type, -1, options->use_library);
+
+      tof_batch = (TOPO_OUTPUT_T *) malloc (READ_BATCH * sizeof (TOPO_OUTPUT_T));
+    }
+  else
+    {
+      fprintf (stderr,"\nUnknown file extension %s\n", file);
+      return (-1);
+    }
+
+
+  if (hof_batch == NULL && tof_batch == NULL)
+    {
+      perror ("Allocating record memory");
+      exit (-1);
+    }
+
+
+  summary_init (summary, type);
+
+  if (source_stat (file, head))
+    {
+      perror (file);
+      reader_close (&reader);
+      fclose (fp);
+      free (hof_batch);
+      free (tof_batch);
+      return (-1);
+    }
+
+
+  for (start = 1 ; ; start += count)
+    {
+      if ((count = reader_read (&reader, start, READ_BATCH, type ? (void *) tof_batch : (void *) hof_batch)) <= 0) break;
+
+      for (i = 0 ; i < count ; i++)
+        {
+          /*  Start a new block every SUMMARY_BLOCK_SIZE records.  */
+
+          if (!(head->num_records % SUMMARY_BLOCK_SIZE))
+            {
+              if (head->num_blocks == size)
+                {
+                  size = size ? size * 2 : 256;
+
+                  if ((summary->block = (SUMMARY_BLOCK *) realloc (summary->block, size * sizeof (SUMMARY_BLOCK))) == NULL)
+                    {
+                      perror ("Allocating summary memory");
+                      exit (-1);
+                    }
+                }
+
+              block = &summary->block[head->num_blocks];
+              block_init (block);
+              head->num_blocks++;
+            }
+
+
+          if (type)
+            {
+              tof = &tof_batch[i];
+
+              block_add (block, tof->timestamp, tof->latitude_last, tof->longitude_last);
+              block_add (block, tof->timestamp, tof->latitude_first, tof->longitude_first);
+
+              if (tof->elevation_last == -998.0)
+                {
+                  head->null_count++;
+                  block->null_count++;
+                }
+
+              if (tof->elevation_first == -998.0) head->null_first_count++;
+            }
+          else
+            {
+              hof = &hof_batch[i];
+
+              block_add (block, hof->timestamp, hof->latitude, hof->longitude);
+
+              if (hof->correct_depth == -998.0)
+                {
+                  head->null_count++;
+                  block->null_count++;
+                }
+
+              if (hof->kgps_water_level == -998.0) head->null_water_level_count++;
+
+
+              /*  Same test as -t.  */
+
+              if (hof->reported_depth != -998.0)
+                {
+                  if ((hof->reported_depth + hof->tide_cor_depth) == 0.0) head->zero_tide_count++;
+                  head->tide_total++;
+                }
+
+              head->data_type_hist[histogram_bin (hof->data_type, SUMMARY_DATA_TYPE_BINS)]++;
+              head->abdc_hist[histogram_bin (hof->abdc, SUMMARY_ABDC_BINS)]++;
+            }
+
+          head->num_records++;
+        }
+    }
+
+
+  /*  The file totals are the union of the blocks.  */
+
+  for (i = 0 ; i < head->num_blocks ; i++)
+    {
+      if (summary->block[i].min_time < head->min_time) head->min_time = summary->block[i].min_time;
+      if (summary->block[i].max_time > head->max_time) head->max_time = summary->block[i].max_time;
+      if (summary->block[i].min_lat < head->min_lat) head->min_lat = summary->block[i].min_lat;
+      if (summary->block[i].max_lat > head->max_lat) head->max_lat = summary->block[i].max_lat;
+      if (summary->block[i].min_lon < head->min_lon) head->min_lon = summary->block[i].min_lon;
+      if (summary->block[i].max_lon > head->max_lon) head->max_lon = summary->block[i].max_lon;
+    }
+
+
+  reader_close (&reader);
+  fclose (fp);
+  free (hof_batch);
+  free (tof_batch);
+
+  return (0);
+}
+
+
+
+/*  Write the sidecar for file.  Returns 0 on success or -1 on error.  */
+
+int32_t summary_write (char *file, SUMMARY *summary)
+{
+  char               path[1024];
+  FILE               *fp;
+  int32_t            status = 0;
+
+
+  summary_path (file, path, sizeof (path));
+
+  if ((fp = fopen (path, "wb")) == NULL)
+    {
+      perror (path);
+      return (-1);
+    }
+
+  if (fwrite (&summary->header, sizeof (SUMMARY_HEADER), 1, fp) != 1) status = -1;
+
+  if (summary->header.num_blocks &&
+      fwrite (summary->block, sizeof (SUMMARY_BLOCK), summary->header.num_blocks, fp) != (size_t) summary->header.num_blocks) status = -1;
+
+  if (fclose (fp) || status)
+    {
+      perror (path);
+      remove (path);
+      return (-1);
+    }
+
+  return (0);
+}
+
+
+
+/*  Load the sidecar for file if there is one and it matches the data file.  If blocks is NVFalse
+    only the header is read.  Returns 0 if the summary was loaded.  */
+
+int32_t summary_read (char *file, SUMMARY *summary, uint8_t blocks)
+{
+  char               path[1024];
+  FILE               *fp;
+  SUMMARY_HEADER     current;
+
+
+  summary->block = NULL;
+
+  if (source_stat (file, &current)) return (-1);
+
+  summary_path (file, path, sizeof (path));
+
+  if ((fp = fopen (path, "rb")) == NULL) return (-1);
+
+
+  if (fread (&summary->header, sizeof (SUMMARY_HEADER), 1, fp) != 1 ||
+      memcmp (summary->header.magic, SUMMARY_MAGIC, sizeof (summary->header.magic)) ||
+      summary->header.byte_order != 0x01020304 ||
+      summary->header.version != SUMMARY_VERSION ||
+      summary->header.header_size != sizeof (SUMMARY_HEADER) ||
+      summary->header.block_size != SUMMARY_BLOCK_SIZE ||
+      summary->header.source_size != current.source_size ||
+      summary->header.source_mtime != current.source_mtime ||
+      summary->header.source_mtime_ns != current.source_mtime_ns ||
+      summary->header.num_blocks < 0)
+    {
+      fclose (fp);
+      return (-1);
+    }
+
+
+  if (blocks && summary->header.num_blocks)
+    {
+      if ((summary->block = (SUMMARY_BLOCK *) malloc (summary->header.num_blocks * sizeof (SUMMARY_BLOCK))) == NULL)
+        {
+          perror ("Allocating summary memory");
+          exit (-1);
+        }
+
+      if (fread (summary->block, sizeof (SUMMARY_BLOCK), summary->header.num_blocks, fp) != (size_t) summary->header.num_blocks)
+        {
+          summary_free (summary);
+          fclose (fp);
+          return (-1);
+        }
+    }
+
+  fclose (fp);
+
+  return (0);
+}
+
+
+
+void summary_free (SUMMARY *summary)
+{
+  free (summary->block);
+  summary->block = NULL;
+}
+
+
+
+static void print_time (char *label, int64_t timestamp)
+{
+  int32_t            year, jday, hour, minute;
+  float              second;
+
+
+  charts_cvtime (timestamp, &year, &jday, &hour, &minute, &second);
+
+  printf ("%s : %d %03d %02d:%02d:%05.2f\n", label, year + 1900, jday, hour, minute, second);
+}
+
+
+
+/*  Print the summary of file to stdout.  */
+
+void summary_print (char *file, SUMMARY *summary)
+{
+  SUMMARY_HEADER     *head = &summary->header;
+  int32_t            i;
+
+
+  printf ("File : %s\n", file);
+  printf ("Records : %d\n", head->num_records);
+
+  if (head->num_records)
+    {
+      print_time ("Start time", head->min_time);
+      print_time ("End time", head->max_time);
+      printf ("Latitude : %.9f %.9f\n", head->min_lat, head->max_lat);
+      printf ("Longitude : %.9f %.9f\n", head->min_lon, head->max_lon);
+    }
+
+
+  if (head->record_type)
+    {
+      printf ("Null elevation_last : %d\n", head->null_count);
+      printf ("Null elevation_first : %d\n", head->null_first_count);
+    }
+  else
+    {
+      printf ("Null correct_depth : %d\n", head->null_count);
+      printf ("Null kgps_water_level : %d\n", head->null_water_level_count);
+      printf ("Tide checked : %d, no tide correction = %d\n", head->tide_total, head->zero_tide_count);
+
+      for (i = 0 ; i <= SUMMARY_DATA_TYPE_BINS ; i++)
+        {
+          if (!head->data_type_hist[i]) continue;
+
+          if (i < SUMMARY_DATA_TYPE_BINS)
+            {
+              printf ("data_type %d : %d\n", i, head->data_type_hist[i]);
+            }
+          else
+            {
+              printf ("data_type other : %d\n", head->data_type_hist[i]);
+            }
+        }
+
+      for (i = 0 ; i <= SUMMARY_ABDC_BINS ; i++)
+        {
+          if (!head->abdc_hist[i]) continue;
+
+          if (i < SUMMARY_ABDC_BINS)
+            {
+              printf ("abdc %d : %d\n", i, head->abdc_hist[i]);
+            }
+          else
+            {
+              printf ("abdc other : %d\n", head->abdc_hist[i]);
+            }
+        }
+    }
+
+  printf ("\n");
+}
+
+
+
+/*  --index and --summary processing for one file.  With --index the sidecar is always rebuilt.
+    Otherwise a current sidecar is used if there is one.  */
+
+int32_t summary_file (OPTIONS *options, char *file)
+{
+  SUMMARY            summary;
+  int32_t            status = 0;
+
+
+  if (options->index || summary_read (file, &summary, NVFalse))
+    {
+      if (summary_build (options, file, &summary)) return (-1);
+
+      if (options->index) status = summary_write (file, &summary);
+    }
+
+  if (options->summary) summary_print (file, &summary);
+
+  summary_free (&summary);
+
+  return (status);
+}
@@ -38,7 +38,7 @@
 
 #ifndef VERSION
 
-#define     VERSION     "PFM Software - charts_list V2.33 - 07/23/14"
+#define     VERSION     "PFM Software - charts_list V2.58 - 10/17/26"
 
 #endif
 
@@ -187,4 +187,220 @@
     - Switched from using the old NV_INT64 and NV_U_INT32 type definitions to the C99 standard stdint.h and
       inttypes.h sized data types (e.g. int64_t and uint32_t).
 
+
+    Version 2.34
+    PFM Software
+    10/17/26
+
+    Added batch mode.  Any number of files, directories (searched recursively), and list files (-l)
+    may be given and are processed by a pool of worker processes (-j).  Output for each file is
+    kept together and in input order.  Moved the per-file processing out of main.c into process_file.c.
+
+
+    Version 2.35
+    PFM Software
+    10/17/26
+
+    Added a memory mapped bulk record reader (record_reader.c) for the full file HOF and TOF loops.
+    Records are copied out in batches with sequential read ahead hints instead of a seek and read
+    per record.  The mapped layout is checked against the CHARTS library when the file is opened
+    and the library is used if it doesn't match.  Added -L to force library reads.
+
+
+    Version 2.36
+    PFM Software
+    10/17/26
+
+    With more than one worker, full dump, -y, and -d runs now split each file into record ranges
+    that are processed in parallel and written back out in record order.  Added -c to set the
+    number of records per chunk.
+
+
+    Version 2.37
+    PFM Software
+    10/17/26
+
+    Added a buffered output stage with fast fixed precision number formatting (output.c) for the
+    -y and water level lines.  Output is identical to the printf formats it replaces.
+
+
+    Version 2.38
+    PFM Software
+    10/17/26
+
+    Added --columnar and --columns to write selected record fields to a binary columnar file with
+    typed columns, per column min/max, and a self describing header (columnar.c).  The selectable
+    HOF and TOF fields are in fields.c.  Switched to getopt_long for the new options.
+
+
+    Version 2.39
+    PFM Software
+    10/17/26
+
+    Added --fields and --delimiter to list selected HOF or TOF fields.  The field list is compiled
+    once into a list of formatters (output_compile_fields) so the record loop doesn't look up
+    names or types per record.
+
+
+    Version 2.40
+    PFM Software
+    10/17/26
+
+    Added --index, which writes a summary sidecar (INPUT_FILE.clx) beside each file, and --summary.
+    The sidecar holds the record count, time range, bounds, null and zero tide counts, data_type
+    and abdc histograms, and the time and position bounds of every 4096 record block.  -t and
+    --summary use a sidecar that matches the file's size and modification time instead of reading
+    the records.
+
+
+    Version 2.41
+    PFM Software
+    10/17/26
+
+    Added --bbox, --polygon, and --time record filters for every output mode.  The time window is
+    found with a binary search on the record timestamps and, when a current --index sidecar
+    exists, blocks whose bounds miss the filter are skipped without being read.
+
+
+    Version 2.42
+    PFM Software
+    10/17/26
+
+    -n now takes a comma separated list of record numbers and START:END ranges, or @FILE.  Each
+    contiguous run is read in batches through the bulk reader instead of one record at a time.
+
+
+    Version 2.43
+    PFM Software
+    10/17/26
+
+    -s now reads the HOF and waveform records ahead on a separate thread (shot_reader.c) and the
+    shot data is decoded with memcpy into float, int32_t, and int16_t arrays instead of a byte by
+    byte union copy.  The shot data lines go through the output buffer.
+
+
+    Version 2.44
+    PFM Software
+    10/17/26
+
+    Added an SRTM land mask cache for -w and -W (srtm_cache.c).  Mask results are kept in one
+    degree tiles, least recently used tiles are dropped at the --srtm-cache limit (default 64MB),
+    and the cache is shared by all of the worker processes.
+
+
+    Version 2.45
+    PFM Software
+    10/17/26
+
+    -g distances are computed in batches by a distance only version of the NGS inverse
+    (geodesic.c) with the reference point terms computed once.  The kernel is checked against
+    invgp at startup and invgp is used if they disagree.  Added --radius METERS to only use
+    records within METERS of the -g position in any mode.
+
+
+    Version 2.46
+    PFM Software
+    10/17/26
+
+    Moved the -w and -W averaging into a streaming aggregator (water_level.c) and added --windows
+    to average over several window widths in one pass with count, min, max, and variance.
+
+
+    Version 2.47
+    PFM Software
+    10/17/26
+
+    Added --merge (and --source) to write the water levels of many files, or saved -w output, as
+    one time ordered series using a k-way heap merge.
+
+
+    Version 2.48
+    PFM Software
+    10/17/26
+
+    Added --audit[=CONFIDENCE], a parallel tide correction audit that reads only the two depth fields,
+    can stop early by sequential sampling, and writes one CSV line per file.
+
+
+    Version 2.49
+    PFM Software
+    10/17/26
+
+    Added --grid, --grid-out, and --grid-return to bin HOF depths or TOF elevations straight into a
+    binary lat/lon grid (count, mean, min, max, standard deviation per cell).
+
+
+    Version 2.50
+    PFM Software
+    10/17/26
+
+    Added --prefetch DEPTH[,MB], a read ahead backend (io_uring on Linux, threads otherwise) that keeps
+    several large reads in flight and reports the time spent waiting for I/O per file.
+
+
+    Version 2.51
+    PFM Software
+    10/17/26
+
+    Added --stats[=json] to report run time, CPU time, records and bytes read and written,
+    per phase times, and record reject counts on stderr.
+
+
+    Version 2.52
+    PFM Software
+    10/17/26
+
+    Added bench/charts_gen, a synthetic HOF/TOF/INH file generator, and bench/run_bench.sh to time every
+    listing mode on small, medium, and multi-GB inputs.  --stats now reports the peak memory use.
+
+
+    Version 2.53
+    PFM Software
+    10/17/26
+
+    Added --compress gzip[,LEVEL] to gzip stdout on a pool of compression threads, written in order as
+    independent gzip members.
+
+
+    Version 2.54
+    PFM Software
+    10/17/26
+
+    Added --server SOCKET[,FILES] to answer -n, -y, -d, -s, -w, -W, and -g requests on a Unix socket with
+    an LRU cache of open HOF, TOF, and waveform files, headers, and record readers.
+
+
+    Version 2.55
+    PFM Software
+    10/17/26
+
+    Added --incremental STATE_DIR.  The output of each file is saved in STATE_DIR and replayed on
+    later runs with the same options unless the file's size, modification time, or fingerprint
+    (hash of its first and last 64KB) changed.
+
+
+    Version 2.56
+    PFM Software
+    10/17/26
+
+    Replaced the per record option tests in the listing, -t, and -w loops with record kernels
+    specialized for each combination of options (kernels.c), picked once per file.
+
+
+    Version 2.57
+    PFM Software
+    10/17/26
+
+    Added the charts_list library (libcharts_list.a, charts_list_api.h, lib/charts_list.pro) for
+    reading records as structures, in place, or as field columns, and for water levels and tide
+    audits, without running charts_list.
+
+
+    Version 2.58
+    PFM Software
+    10/17/26
+
+    Added --joint, the .hof and .tof files of each flight line listed together in one
+    time ordered pass with the source of each point.
+
 */
@@ -0,0 +1,246 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+
+*********************************************************************************************/
+
+ /********************************************************************
+ *
+ * Module Name : water_level.c
+ *
+ * Author/Date : PFM Software, 10/17/26
+ *
+ * Description : Streaming water level aggregation for -w and -W.
+ *
+ *               process_file picks the shots that can be used (valid depth
+ *               and water level, KGPS, abdc, the ten second trim, and the
+ *               SRTM land mask) and passes them to wl_add.  Each window keeps
+ *               a constant amount of state, so any number of window widths
+ *               are averaged in the same pass.  The rules for each window are
+ *               the original -w rules:
+ *
+ *                 - a gap of more than WL_GAP between shots starts over,
+ *                 - a sample is written when a shot is more than the window
+ *                   width past the start of the window,
+ *                 - the sample time is halfway between the window start and
+ *                   the last shot in it, and the next window starts there,
+ *                 - a partial window at the end of the file isn't written.
+ *
+ *               With -W every shot after the first is written as is.
+ *
+ *               Without --windows there is one 2 second window and the output
+ *               is the original -w format.  With --windows every sample also
+ *               has the window width, shot count, minimum, maximum, and
+ *               variance of the water levels in it.
+ *
+ *               Library callers (cl_water_level in api.c) get each sample
+ *               through options->wl_func instead of as text.
+ *
+ ********************************************************************/
+
+#include "charts_list.h"
+
+
+#define WL_GAP             1000000                     /*  microseconds  */
+
+
+
+/*  Set up the windows for one file.  */
+
+void wl_init (WATER_LEVEL *wl, OPTIONS *options, OUTPUT_BUFFER *out)
+{
+  int32_t            i;
+
+
+  memset (wl, 0, sizeof (WATER_LEVEL));
+
+  wl->out = out;
+  wl->average = options->average;
+  wl->stats = options->wl_stats;
+  wl->geo_check = options->geo_check;
+  wl->geo_ref = &options->geo_ref;
+  wl->func = options->wl_func;
+  wl->data = options->wl_data;
+  wl->num_windows = options->wl_num_windows;
+
+  for (i = 0 ; i < wl->num_windows ; i++)
+    {
+      wl->window[i].width = options->wl_width[i];
+      wl->window[i].start_time = -1;
+      wl->window[i].last_time = -1;
+    }
+}
+
+
+
+static void window_reset (WL_WINDOW *w)
+{
+  w->count = 0;
+  w->sum = 0.0;
+  w->sumlat = 0.0;
+  w->sumlon = 0.0;
+  w->mean = 0.0;
+  w->m2 = 0.0;
+  w->min = 1.0e30;
+  w->max = -1.0e30;
+}
+
+
+
+/*  Write the sample for a window.  */
+
+static void window_emit (WATER_LEVEL *wl, WL_WINDOW *w, int64_t timestamp, double lat, double lon, float level)
+{
+  double             dist = 0.0, variance = w->count ? w->m2 / (double) w->count : 0.0;
+  int32_t            year, jday, hour, minute;
+  float              second;
+  CL_WATER_LEVEL_SAMPLE value;
+
+
+  if (wl->geo_check) dist = geo_distance (wl->geo_ref, lat, lon);
+
+  if (wl->func != NULL)
+    {
+      value.timestamp = timestamp;
+      value.latitude = lat;
+      value.longitude = lon;
+      value.level = level;
+      value.distance = dist;
+      value.width_seconds = (double) w->width / 1000000.0;
+      value.count = w->count;
+      value.min = w->min;
+      value.max = w->max;
+      value.variance = variance;
+
+      (*wl->func) (&value, wl->data);
+      return;
+    }
+
+  charts_cvtime (timestamp, &year, &jday, &hour, &minute, &second);
+
+  if (wl->stats)
+    {
+      output_water_level_stats (wl->out, lat, lon, year + 1900, jday, hour, minute, second, level, wl->geo_check, dist, w->width, w->count,
+                                w->min, w->max, variance);
+    }
+  else
+    {
+      output_water_level (wl->out, lat, lon, year + 1900, jday, hour, minute, second, level, wl->geo_check, dist);
+    }
+}
+
+
+
+/*  Add a usable shot to every window.  */
+
+void wl_add (WATER_LEVEL *wl, int64_t timestamp, double lat, double lon, float level)
+{
+  WL_WINDOW          *w;
+  int64_t            mid;
+  double             delta;
+  int32_t            i;
+
+
+  for (i = 0 ; i < wl->num_windows ; i++)
+    {
+      w = &wl->window[i];
+
+      if (w->start_time < 0)
+        {
+          w->start_time = timestamp;
+          window_reset (w);
+        }
+
+
+      /*  If we're averaging and we encounter more than a second of bad data we don't want to use
+          this section.  */
+
+      if (wl->average && timestamp - w->last_time > WL_GAP)
+        {
+          w->start_time = timestamp;
+          window_reset (w);
+        }
+
+
+      if ((!wl->average || timestamp - w->start_time > w->width) && w->last_time != -1)
+        {
+          mid = w->start_time + (w->last_time - w->start_time) / 2;
+          w->start_time = mid;
+
+          if (wl->average)
+            {
+              window_emit (wl, w, mid, w->sumlat / (double) w->count, w->sumlon / (double) w->count, (float) (w->sum / (double) w->count));
+            }
+          else
+            {
+              window_emit (wl, w, mid, lat, lon, level);
+            }
+
+          window_reset (w);
+        }
+
+
+      w->count++;
+      w->sum += level;
+      w->sumlat += lat;
+      w->sumlon += lon;
+      w->last_time = timestamp;
+
+      delta = level - w->mean;
+      w->mean += delta / (double) w->count;
+      w->m2 += delta * (level - w->mean);
+
+      if (level < w->min) w->min = level;
+      if (level > w->max) w->max = level;
+    }
+}
+
+
+
+/*  --windows "SECONDS,SECONDS,...".  Returns 0 on success or -1 on error.  */
+
+int32_t wl_parse_windows (OPTIONS *options, char *list)
+{
+  char               string[1024], *entry, *save = NULL;
+  double             seconds;
+
+
+  strncpy (string, list, sizeof (string) - 1);
+  string[sizeof (string) - 1] = 0;
+
+  options->wl_num_windows = 0;
+
+  for (entry = strtok_r (string, ",", &save) ; entry != NULL ; entry = strtok_r (NULL, ",", &save))
+    {
+      if (sscanf (entry, "%lf", &seconds) != 1 || seconds <= 0.0 || options->wl_num_windows == WL_MAX_WINDOWS)
+        {
+          fprintf (stderr, "\nBad window list %s (at most %d widths in seconds)\n\n", list, WL_MAX_WINDOWS);
+          return (-1);
+        }
+
+      options->wl_width[options->wl_num_windows++] = (int64_t) (seconds * 1000000.0 + 0.5);
+    }
+
+  if (!options->wl_num_windows) return (-1);
+
+  options->wl_stats = NVTrue;
+
+  return (0);
+}